@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for tracking error bound / sphere overlap checks. Compares the
+// generic per-sphere loop through the virtual TrackingBound interface against
+// the specialized kernels for each concrete bound type.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/sphere_overlap_kernels.h>
+#include <fastrack/utils/types.h>
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+using fastrack::bound::Box;
+using fastrack::bound::Cylinder;
+using fastrack::bound::Sphere;
+using fastrack::bound::SphereArray;
+using fastrack::bound::TrackingBound;
+
+// Environment extent, obstacle radii, and number of query points.
+static constexpr double kEnvironmentSize = 10.0;
+static constexpr double kMaxObstacleRadius = 0.25;
+static constexpr size_t kNumQueries = 256;
+
+// Random spheres and query points, drawn from a fixed seed.
+SphereArray RandomSpheres(size_t num_spheres) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_p(0.0, kEnvironmentSize);
+  std::uniform_real_distribution<double> unif_r(0.0, kMaxObstacleRadius);
+
+  SphereArray spheres;
+  for (size_t ii = 0; ii < num_spheres; ii++) {
+    const Vector3d center(unif_p(rng), unif_p(rng), unif_p(rng));
+    spheres.Add(center, unif_r(rng));
+  }
+
+  return spheres;
+}
+
+std::vector<Vector3d> RandomQueries() {
+  std::default_random_engine rng(1);
+  std::uniform_real_distribution<double> unif_p(0.0, kEnvironmentSize);
+
+  std::vector<Vector3d> queries;
+  for (size_t ii = 0; ii < kNumQueries; ii++)
+    queries.emplace_back(unif_p(rng), unif_p(rng), unif_p(rng));
+
+  return queries;
+}
+
+// Bounds of similar size.
+Box MakeBox() {
+  Box box;
+  box.x = 0.1;
+  box.y = 0.1;
+  box.z = 0.1;
+  return box;
+}
+
+Cylinder MakeCylinder() {
+  Cylinder cylinder;
+  cylinder.r = 0.1;
+  cylinder.z = 0.1;
+  return cylinder;
+}
+
+Sphere MakeSphere() {
+  Sphere sphere;
+  sphere.r = 0.1;
+  return sphere;
+}
+
+// Check every query against all spheres, with bound type B. Passing
+// B = TrackingBound goes through the generic virtual loop.
+template <typename B>
+void RunOverlaps(benchmark::State& state, const B& bound) {
+  const SphereArray spheres = RandomSpheres(state.range(0));
+  const std::vector<Vector3d> queries = RandomQueries();
+
+  for (auto _ : state) {
+    for (const auto& p : queries) {
+      benchmark::DoNotOptimize(
+          fastrack::bound::OverlapsAnySphere(bound, p, spheres));
+    }
+  }
+
+  // Count one validity check per query point.
+  state.SetItemsProcessed(state.iterations() * kNumQueries);
+}
+
+void BM_BoxVirtual(benchmark::State& state) {
+  const Box box = MakeBox();
+  RunOverlaps<TrackingBound>(state, box);
+}
+
+void BM_BoxKernel(benchmark::State& state) {
+  RunOverlaps<Box>(state, MakeBox());
+}
+
+void BM_CylinderVirtual(benchmark::State& state) {
+  const Cylinder cylinder = MakeCylinder();
+  RunOverlaps<TrackingBound>(state, cylinder);
+}
+
+void BM_CylinderKernel(benchmark::State& state) {
+  RunOverlaps<Cylinder>(state, MakeCylinder());
+}
+
+void BM_SphereVirtual(benchmark::State& state) {
+  const Sphere sphere = MakeSphere();
+  RunOverlaps<TrackingBound>(state, sphere);
+}
+
+void BM_SphereKernel(benchmark::State& state) {
+  RunOverlaps<Sphere>(state, MakeSphere());
+}
+
+}  //\namespace
+
+BENCHMARK(BM_BoxVirtual)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_BoxKernel)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_CylinderVirtual)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_CylinderKernel)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_SphereVirtual)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_SphereKernel)->RangeMultiplier(4)->Range(16, 4096);
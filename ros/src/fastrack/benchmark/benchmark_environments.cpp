@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for environment collision checks as a function of the number of
+// obstacles. Environments are populated directly rather than from the ROS
+// parameter server.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/box.h>
+#include <fastrack/environment/balls_in_box.h>
+#include <fastrack/environment/balls_in_box_occupancy_map.h>
+#include <fastrack/environment/octree_occupancy_map.h>
+#include <fastrack/utils/types.h>
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+using fastrack::bound::Box;
+using fastrack::bound::TrackingBound;
+using fastrack::environment::BallsInBox;
+using fastrack::environment::BallsInBoxOccupancyMap;
+using fastrack::environment::OccupancyOctree;
+using fastrack::environment::OctreeOccupancyMap;
+
+// Environment extent, obstacle radii, and number of query points.
+static constexpr double kEnvironmentSize = 10.0;
+static constexpr double kMinRadius = 0.1;
+static constexpr double kMaxRadius = 0.3;
+static constexpr double kSensorRadius = 2.0;
+static constexpr size_t kNumSensorFovs = 64;
+static constexpr size_t kNumQueries = 256;
+
+// Coarse grid resolution for the occupancy map.
+static constexpr double kCoarseResolution = 0.25;
+
+// Leaf resolution for the octree map.
+static constexpr double kOctreeResolution = 0.05;
+
+// Random points, drawn from a fixed seed.
+std::vector<Vector3d> RandomPoints(size_t num_points, unsigned int seed) {
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif(0.0, kEnvironmentSize);
+
+  std::vector<Vector3d> points;
+  for (size_t ii = 0; ii < num_points; ii++)
+    points.emplace_back(unif(rng), unif(rng), unif(rng));
+
+  return points;
+}
+
+Box MakeBox() {
+  Box box;
+  box.x = 0.1;
+  box.y = 0.1;
+  box.z = 0.1;
+  return box;
+}
+
+// BallsInBox with random obstacles.
+class BenchmarkBallsInBox : public BallsInBox {
+ public:
+  explicit BenchmarkBallsInBox(size_t num_obstacles) : BallsInBox() {
+    name_ = "BenchmarkBallsInBox";
+    lower_ = Vector3d::Zero();
+    upper_ = Vector3d::Constant(kEnvironmentSize);
+    GenerateObstacles(num_obstacles, kMinRadius, kMaxRadius, 0);
+    initialized_ = true;
+  }
+};  //\class BenchmarkBallsInBox
+
+// BallsInBoxOccupancyMap with random obstacles and sensor FOVs.
+class BenchmarkOccupancyMap : public BallsInBoxOccupancyMap {
+ public:
+  explicit BenchmarkOccupancyMap(size_t num_obstacles,
+                                 double coarse_resolution)
+      : BallsInBoxOccupancyMap() {
+    name_ = "BenchmarkOccupancyMap";
+    lower_ = Vector3d::Zero();
+    upper_ = Vector3d::Constant(kEnvironmentSize);
+    free_space_threshold_ = 0.05;
+    coarse_resolution_ = coarse_resolution;
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<double> unif_r(kMinRadius, kMaxRadius);
+    for (const auto& p : RandomPoints(num_obstacles, 2)) {
+      const double r = unif_r(rng);
+      obstacles_.Insert(p, r);
+      largest_obstacle_radius_ = std::max(largest_obstacle_radius_, r);
+    }
+
+    for (const auto& p : RandomPoints(kNumSensorFovs, 3))
+      sensor_fovs_.Insert(p, kSensorRadius);
+    largest_sensor_radius_ = kSensorRadius;
+
+    initialized_ = true;
+  }
+};  //\class BenchmarkOccupancyMap
+
+// OctreeOccupancyMap with the same obstacles and sensor FOVs.
+class BenchmarkOctreeMap : public OctreeOccupancyMap {
+ public:
+  explicit BenchmarkOctreeMap(size_t num_obstacles) : OctreeOccupancyMap() {
+    name_ = "BenchmarkOctreeMap";
+    lower_ = Vector3d::Zero();
+    upper_ = Vector3d::Constant(kEnvironmentSize);
+    free_space_threshold_ = 0.05;
+    resolution_ = kOctreeResolution;
+    octree_.reset(new OccupancyOctree(lower_, upper_, resolution_));
+    max_query_depth_ = octree_->MaxDepth();
+
+    for (const auto& p : RandomPoints(kNumSensorFovs, 3))
+      octree_->InsertFreeSphere(p, kSensorRadius);
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<double> unif_r(kMinRadius, kMaxRadius);
+    for (const auto& p : RandomPoints(num_obstacles, 2))
+      octree_->InsertOccupiedSphere(p, unif_r(rng));
+
+    initialized_ = true;
+  }
+
+  size_t NumNodes() const { return octree_->NumNodes(); }
+};  //\class BenchmarkOctreeMap
+
+// Check all queries. Passing B = TrackingBound goes through the virtual
+// interface.
+template <typename E, typename B>
+void RunIsValid(benchmark::State& state, const E& env, const B& bound) {
+  const std::vector<Vector3d> queries = RandomPoints(kNumQueries, 1);
+
+  for (auto _ : state) {
+    for (const auto& p : queries)
+      benchmark::DoNotOptimize(env.IsValid(p, bound));
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_BallsInBoxIsValid(benchmark::State& state) {
+  const BenchmarkBallsInBox env(state.range(0));
+  RunIsValid(state, env, MakeBox());
+}
+
+void BM_BallsInBoxIsValidVirtual(benchmark::State& state) {
+  const BenchmarkBallsInBox env(state.range(0));
+  const Box box = MakeBox();
+  RunIsValid(state, env, static_cast<const TrackingBound&>(box));
+}
+
+void BM_OccupancyMapIsValid(benchmark::State& state) {
+  const BenchmarkOccupancyMap env(state.range(0), 0.0);
+  RunIsValid(state, env, MakeBox());
+}
+
+void BM_OccupancyMapIsValidCoarse(benchmark::State& state) {
+  const BenchmarkOccupancyMap env(state.range(0), kCoarseResolution);
+
+  // Build the coarse grid outside the timed loop.
+  const Box box = MakeBox();
+  env.IsValid(Vector3d::Constant(0.5 * kEnvironmentSize), box);
+  RunIsValid(state, env, box);
+}
+
+void BM_OctreeMapIsValid(benchmark::State& state) {
+  const BenchmarkOctreeMap env(state.range(0));
+  RunIsValid(state, env, MakeBox());
+  state.counters["nodes"] = env.NumNodes();
+}
+
+}  //\namespace
+
+BENCHMARK(BM_BallsInBoxIsValid)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_BallsInBoxIsValidVirtual)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OccupancyMapIsValid)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_OccupancyMapIsValidCoarse)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_OctreeMapIsValid)->RangeMultiplier(4)->Range(16, 4096);
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for ray-cast depth sensing as a function of obstacle count and
+// thread count. Reports rays per second.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/sphere_overlap_kernels.h>
+#include <fastrack/sensor/ray_casting.h>
+#include <fastrack/sensor/ray_sensor_params.h>
+#include <fastrack/utils/sphere_bvh.h>
+#include <fastrack/utils/thread_pool.h>
+#include <fastrack/utils/types.h>
+
+#include <benchmark/benchmark.h>
+#include <random>
+
+namespace {
+
+using fastrack::SphereBvh;
+using fastrack::ThreadPool;
+using fastrack::bound::SphereArray;
+using fastrack::sensor::CastRays;
+using fastrack::sensor::RaySensorParams;
+
+// Environment extent and obstacle radii.
+static constexpr double kEnvironmentSize = 20.0;
+static constexpr double kMinRadius = 0.1;
+static constexpr double kMaxRadius = 0.5;
+
+SphereArray RandomSpheres(size_t num_spheres, unsigned int seed) {
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif_position(0.0, kEnvironmentSize);
+  std::uniform_real_distribution<double> unif_radius(kMinRadius, kMaxRadius);
+
+  SphereArray spheres;
+  for (size_t ii = 0; ii < num_spheres; ii++) {
+    const Vector3d p(unif_position(rng), unif_position(rng),
+                     unif_position(rng));
+    spheres.Add(p, unif_radius(rng));
+  }
+
+  return spheres;
+}
+
+// 64-ring LiDAR in the middle of the environment.
+RaySensorParams LidarParams() {
+  RaySensorParams params;
+  params.position = Vector3d::Constant(0.5 * kEnvironmentSize);
+  params.range = 10.0;
+  params.SetLidarPattern(64, 1024, -0.4, 0.4);
+  return params;
+}
+
+// Full scan against N obstacles on T threads.
+void BM_RayCastScan(benchmark::State& state) {
+  const SphereBvh bvh(RandomSpheres(state.range(0), 0));
+  const RaySensorParams params = LidarParams();
+  ThreadPool pool(state.range(1));
+  fastrack_msgs::SensedRays msg;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CastRays(bvh, params, &pool, &msg));
+
+  state.SetItemsProcessed(state.iterations() * params.directions.size());
+}
+void RayCastScanArgs(benchmark::internal::Benchmark* b) {
+  for (int num_obstacles : {100, 10000}) {
+    for (int num_threads : {1, 2, 4, 8}) b->Args({num_obstacles, num_threads});
+  }
+}
+BENCHMARK(BM_RayCastScan)
+    ->Apply(RayCastScanArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Hierarchy construction, which happens whenever the environment changes.
+void BM_SphereBvhBuild(benchmark::State& state) {
+  const SphereArray spheres = RandomSpheres(state.range(0), 0);
+  SphereBvh bvh;
+
+  for (auto _ : state) {
+    bvh.Build(spheres);
+    benchmark::DoNotOptimize(bvh.NumNodes());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SphereBvhBuild)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
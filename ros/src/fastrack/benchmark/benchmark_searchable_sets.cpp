@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for KdtreeMap and SearchableSet insertion and queries, as a
+// function of the number of entries. Also recall vs. speed of approximate
+// SearchableSet queries.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/utils/kdtree_map.h>
+#include <fastrack/utils/searchable_set.h>
+#include <fastrack/utils/types.h>
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using fastrack::KdtreeMap;
+using fastrack::NeighborSearchParams;
+using fastrack::SearchableSet;
+using fastrack::state::PositionVelocity;
+
+// Number of neighbors and search radius for queries.
+static constexpr size_t kNumNeighbors = 10;
+static constexpr double kSearchRadius = 0.5;
+
+// Size of the region from which points are drawn.
+static constexpr double kRegionSize = 10.0;
+
+// Number of randomized trees for approximate searches.
+static constexpr int kNumApproximateTrees = 4;
+
+// Minimal node type for SearchableSet.
+struct Node {
+  typedef std::shared_ptr<Node> Ptr;
+  PositionVelocity state;
+
+  explicit Node(const PositionVelocity& x) : state(x) {}
+};  //\struct Node
+
+// Random points, drawn from a fixed seed.
+std::vector<Vector3d> RandomPoints(size_t num_points, unsigned int seed) {
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif(0.0, kRegionSize);
+
+  std::vector<Vector3d> points;
+  for (size_t ii = 0; ii < num_points; ii++)
+    points.emplace_back(unif(rng), unif(rng), unif(rng));
+
+  return points;
+}
+
+PositionVelocity ToState(const Vector3d& p) {
+  return PositionVelocity(p, Vector3d::Zero());
+}
+
+void BM_KdtreeMapInsert(benchmark::State& state) {
+  const std::vector<Vector3d> points = RandomPoints(state.range(0), 0);
+
+  for (auto _ : state) {
+    KdtreeMap<3, double> kdtree;
+    for (const auto& p : points) kdtree.Insert(p, 1.0);
+    benchmark::DoNotOptimize(kdtree.Registry().data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+void BM_KdtreeMapKnnSearch(benchmark::State& state) {
+  KdtreeMap<3, double> kdtree;
+  for (const auto& p : RandomPoints(state.range(0), 0)) kdtree.Insert(p, 1.0);
+
+  const std::vector<Vector3d> queries = RandomPoints(256, 1);
+  for (auto _ : state) {
+    for (const auto& q : queries)
+      benchmark::DoNotOptimize(kdtree.KnnSearch(q, kNumNeighbors));
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_KdtreeMapRadiusSearch(benchmark::State& state) {
+  KdtreeMap<3, double> kdtree;
+  for (const auto& p : RandomPoints(state.range(0), 0)) kdtree.Insert(p, 1.0);
+
+  const std::vector<Vector3d> queries = RandomPoints(256, 1);
+  for (auto _ : state) {
+    for (const auto& q : queries)
+      benchmark::DoNotOptimize(kdtree.RadiusSearch(q, kSearchRadius));
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_SearchableSetInsert(benchmark::State& state) {
+  std::vector<Node::Ptr> nodes;
+  for (const auto& p : RandomPoints(state.range(0), 0))
+    nodes.push_back(std::make_shared<Node>(ToState(p)));
+
+  for (auto _ : state) {
+    SearchableSet<Node, PositionVelocity> set(nodes.front());
+    for (size_t ii = 1; ii < nodes.size(); ii++) set.Insert(nodes[ii]);
+    benchmark::DoNotOptimize(set.InitialNode());
+  }
+
+  state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+
+void BM_SearchableSetKnnSearch(benchmark::State& state) {
+  const std::vector<Vector3d> points = RandomPoints(state.range(0), 0);
+  SearchableSet<Node, PositionVelocity> set(
+      std::make_shared<Node>(ToState(points.front())));
+  for (size_t ii = 1; ii < points.size(); ii++)
+    set.Insert(std::make_shared<Node>(ToState(points[ii])));
+
+  std::vector<PositionVelocity> queries;
+  for (const auto& q : RandomPoints(256, 1)) queries.push_back(ToState(q));
+
+  for (auto _ : state) {
+    for (const auto& q : queries)
+      benchmark::DoNotOptimize(set.KnnSearch(q, kNumNeighbors));
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_SearchableSetRadiusSearch(benchmark::State& state) {
+  const std::vector<Vector3d> points = RandomPoints(state.range(0), 0);
+  SearchableSet<Node, PositionVelocity> set(
+      std::make_shared<Node>(ToState(points.front())));
+  for (size_t ii = 1; ii < points.size(); ii++)
+    set.Insert(std::make_shared<Node>(ToState(points[ii])));
+
+  std::vector<PositionVelocity> queries;
+  for (const auto& q : RandomPoints(256, 1)) queries.push_back(ToState(q));
+
+  for (auto _ : state) {
+    for (const auto& q : queries)
+      benchmark::DoNotOptimize(set.RadiusSearch(q, kSearchRadius));
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Approximate k-nearest neighbor queries. The first argument is the number
+// of nodes and the second the number of leaves checked, where -1 is exact.
+// Reports the fraction of the exact neighbors that were found as 'recall'.
+void BM_SearchableSetApproximateKnnSearch(benchmark::State& state) {
+  std::vector<Node::Ptr> nodes;
+  for (const auto& p : RandomPoints(state.range(0), 0))
+    nodes.push_back(std::make_shared<Node>(ToState(p)));
+
+  NeighborSearchParams params;
+  params.checks = static_cast<int>(state.range(1));
+  if (params.checks != FLANN_CHECKS_UNLIMITED)
+    params.num_trees = kNumApproximateTrees;
+
+  SearchableSet<Node, PositionVelocity> exact_set(nodes.front());
+  SearchableSet<Node, PositionVelocity> set(nodes.front(), params);
+  for (size_t ii = 1; ii < nodes.size(); ii++) {
+    exact_set.Insert(nodes[ii]);
+    set.Insert(nodes[ii]);
+  }
+
+  std::vector<PositionVelocity> queries;
+  for (const auto& q : RandomPoints(256, 1)) queries.push_back(ToState(q));
+
+  for (auto _ : state) {
+    for (const auto& q : queries)
+      benchmark::DoNotOptimize(set.KnnSearch(q, kNumNeighbors));
+  }
+
+  // Recall against exact search, outside the timed loop.
+  size_t num_found = 0;
+  size_t num_expected = 0;
+  for (const auto& q : queries) {
+    const std::vector<Node::Ptr> expected =
+        exact_set.KnnSearch(q, kNumNeighbors);
+    const std::vector<Node::Ptr> found = set.KnnSearch(q, kNumNeighbors);
+    for (const auto& node : expected)
+      num_found += std::count(found.begin(), found.end(), node);
+
+    num_expected += expected.size();
+  }
+
+  state.counters["recall"] =
+      static_cast<double>(num_found) / std::max<size_t>(1, num_expected);
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Graph sizes from 10^4 to 10^6 nodes, exact and with increasing checks.
+void ApproximateKnnArgs(benchmark::internal::Benchmark* b) {
+  for (int num_nodes : {10000, 100000, 1000000}) {
+    for (int checks : {FLANN_CHECKS_UNLIMITED, 16, 64, 256})
+      b->Args({num_nodes, checks});
+  }
+}
+
+}  //\namespace
+
+BENCHMARK(BM_KdtreeMapInsert)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_KdtreeMapKnnSearch)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_KdtreeMapRadiusSearch)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_SearchableSetInsert)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_SearchableSetKnnSearch)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_SearchableSetRadiusSearch)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_SearchableSetApproximateKnnSearch)->Apply(ApproximateKnnArgs);
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for Trajectory interpolation, concatenation, and conversion to
+// ROS messages, as a function of trajectory length.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+
+#include <benchmark/benchmark.h>
+#include <list>
+#include <random>
+#include <vector>
+
+namespace {
+
+using fastrack::state::PositionVelocity;
+using fastrack::trajectory::Trajectory;
+
+// Time between consecutive states, and number of trajectories to splice.
+static constexpr double kTimeStep = 0.1;
+static constexpr size_t kNumSplicedTrajectories = 8;
+
+// Trajectory with the given number of random states, at a fixed time step.
+Trajectory<PositionVelocity> RandomTrajectory(size_t num_states) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+
+  std::vector<PositionVelocity> states;
+  std::vector<double> times;
+  for (size_t ii = 0; ii < num_states; ii++) {
+    states.emplace_back(Vector3d(unif(rng), unif(rng), unif(rng)),
+                        Vector3d(unif(rng), unif(rng), unif(rng)));
+    times.push_back(kTimeStep * ii);
+  }
+
+  return Trajectory<PositionVelocity>(states, times);
+}
+
+void BM_TrajectoryInterpolate(benchmark::State& state) {
+  const auto traj = RandomTrajectory(state.range(0));
+
+  std::default_random_engine rng(1);
+  std::uniform_real_distribution<double> unif(traj.FirstTime(),
+                                              traj.LastTime());
+  std::vector<double> times;
+  for (size_t ii = 0; ii < 256; ii++) times.push_back(unif(rng));
+
+  for (auto _ : state) {
+    for (double t : times) benchmark::DoNotOptimize(traj.Interpolate(t));
+  }
+
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+void BM_TrajectoryConcatenate(benchmark::State& state) {
+  const std::list<Trajectory<PositionVelocity>> trajs(
+      kNumSplicedTrajectories, RandomTrajectory(state.range(0)));
+
+  for (auto _ : state) {
+    const Trajectory<PositionVelocity> spliced(trajs);
+    benchmark::DoNotOptimize(spliced.Size());
+  }
+
+  state.SetItemsProcessed(state.iterations() * kNumSplicedTrajectories *
+                          state.range(0));
+}
+
+void BM_TrajectoryToRos(benchmark::State& state) {
+  const auto traj = RandomTrajectory(state.range(0));
+
+  for (auto _ : state) benchmark::DoNotOptimize(traj.ToRos());
+
+  state.SetItemsProcessed(state.iterations() * traj.Size());
+}
+
+void BM_TrajectoryToPackedRos(benchmark::State& state) {
+  const auto traj = RandomTrajectory(state.range(0));
+
+  for (auto _ : state) {
+    fastrack_msgs::Trajectory msg;
+    traj.ToPackedRos(&msg);
+    benchmark::DoNotOptimize(msg.packed.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * traj.Size());
+}
+
+}  //\namespace
+
+BENCHMARK(BM_TrajectoryInterpolate)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_TrajectoryConcatenate)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_TrajectoryToRos)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_TrajectoryToPackedRos)->RangeMultiplier(8)->Range(8, 32768);
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks for value function evaluation: value and gradient lookups in the
+// MatlabValueFunction grid, and optimal control from both value functions
+// through the statically typed path and through the virtual ValueFunction
+// interface. Also optimal control with the grid paged in from tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/box.h>
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/control/quadrotor_control.h>
+#include <fastrack/dynamics/planar_dubins_dynamics_3d.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d_rel_planar_dubins_3d.h>
+#include <fastrack/state/planar_dubins_3d.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/utils/tiled_grid.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/value/analytical_kinematic_box_quadrotor_decoupled_6d.h>
+#include <fastrack/value/matlab_value_function.h>
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = fastrack::state;
+namespace fb = fastrack::bound;
+namespace fc = fastrack::control;
+namespace fd = fastrack::dynamics;
+namespace fv = fastrack::value;
+
+// Same instantiation as the Matlab tracker demo.
+using CustomValueFunction = fv::MatlabValueFunction<
+    fs::PositionVelocity, fc::QuadrotorControl,
+    fd::QuadrotorDecoupled6D<fc::QuadrotorControlBoundCylinder>,
+    fs::PlanarDubins3D, double, fd::PlanarDubinsDynamics3D,
+    fs::PositionVelocityRelPlanarDubins3D,
+    fd::QuadrotorDecoupled6DRelPlanarDubins3D, fb::Cylinder>;
+
+// Base class of the Matlab value function.
+using CustomValueFunctionBase = fv::ValueFunction<
+    fs::PositionVelocity, fc::QuadrotorControl,
+    fd::QuadrotorDecoupled6D<fc::QuadrotorControlBoundCylinder>,
+    fs::PlanarDubins3D, double, fd::PlanarDubinsDynamics3D, fb::Cylinder>;
+
+// Base class of the analytical value function.
+using AnalyticalValueFunctionBase = fv::ValueFunction<
+    fs::PositionVelocity, fc::QuadrotorControl,
+    fd::QuadrotorDecoupled6D<fc::QuadrotorControlBoundBox>,
+    fs::PositionVelocity, VectorXd, fd::Kinematics<fs::PositionVelocity>,
+    fb::Box>;
+
+// Value function file shipped with this package.
+static const std::string kValueFunctionFile =
+    std::string(FASTRACK_MATLAB_DIR) + "/value_function.mat";
+
+// Number of random state pairs, and how far apart they are.
+static constexpr size_t kNumQueries = 256;
+static constexpr double kMaxRelativePosition = 0.5;
+static constexpr double kMaxVelocity = 0.5;
+
+// Random tracker states near the origin.
+std::vector<fs::PositionVelocity> RandomTrackerStates() {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_p(-kMaxRelativePosition,
+                                                kMaxRelativePosition);
+  std::uniform_real_distribution<double> unif_v(-kMaxVelocity, kMaxVelocity);
+
+  std::vector<fs::PositionVelocity> states;
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    states.emplace_back(Vector3d(unif_p(rng), unif_p(rng), unif_p(rng)),
+                        Vector3d(unif_v(rng), unif_v(rng), unif_v(rng)));
+  }
+
+  return states;
+}
+
+void BM_MatlabValue(benchmark::State& state) {
+  CustomValueFunction value;
+  if (!value.InitializeFromMatFile(kValueFunctionFile)) {
+    state.SkipWithError("Could not load value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.Value(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+void BM_MatlabGradient(benchmark::State& state) {
+  CustomValueFunction value;
+  if (!value.InitializeFromMatFile(kValueFunctionFile)) {
+    state.SkipWithError("Could not load value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.Gradient(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+void BM_MatlabOptimalControl(benchmark::State& state) {
+  CustomValueFunction value;
+  if (!value.InitializeFromMatFile(kValueFunctionFile)) {
+    state.SkipWithError("Could not load value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+void BM_MatlabOptimalControlTable(benchmark::State& state) {
+  CustomValueFunction value;
+  if (!value.InitializeFromMatFile(kValueFunctionFile)) {
+    state.SkipWithError("Could not load value function.");
+    return;
+  }
+
+  constexpr double kTolerance = 0.01;
+  const double valid_fraction = value.BuildControlTable(kTolerance);
+  if (valid_fraction < 0.0) {
+    state.SkipWithError("Could not build control table.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+  state.counters["valid_fraction"] = valid_fraction;
+}
+
+// Optimal control with the grid paged in from tiles. The first argument is
+// the number of cells per tile side and the second the number of cached
+// tiles. Reports the fraction of lookups which fell back to the coarse level.
+void BM_MatlabOptimalControlTiled(benchmark::State& state) {
+  const std::string tile_file = "/tmp/benchmark_value_function.tiles";
+  constexpr size_t kCoarseFactor = 4;
+  if (!fastrack::TiledGrid::WriteValueFunction(
+          kValueFunctionFile, tile_file, state.range(0), kCoarseFactor)) {
+    state.SkipWithError("Could not write tiles.");
+    return;
+  }
+
+  CustomValueFunction value;
+  if (!value.InitializeFromTiles(kValueFunctionFile, tile_file,
+                                 state.range(1))) {
+    state.SkipWithError("Could not load value function.");
+    std::remove(tile_file.c_str());
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+  const auto* tiles = value.Tiles();
+  state.counters["coarse_fraction"] =
+      static_cast<double>(tiles->NumMisses()) /
+      static_cast<double>(tiles->NumHits() + tiles->NumMisses());
+  std::remove(tile_file.c_str());
+}
+
+void BM_MatlabOptimalControlVirtual(benchmark::State& state) {
+  CustomValueFunction value;
+  if (!value.InitializeFromMatFile(kValueFunctionFile)) {
+    state.SkipWithError("Could not load value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PlanarDubins3D planner_x(0.0, 0.0, 0.0);
+  const CustomValueFunctionBase& base = value;
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(base.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+// Same parameters as the analytical tracker demo.
+bool InitializeAnalytical(fv::AnalyticalKinematicBoxQuadrotorDecoupled6D* value) {
+  const fc::QuadrotorControl lower(-0.1, -0.1, 0.0, 7.81);
+  const fc::QuadrotorControl upper(0.1, 0.1, 0.0, 11.81);
+  return value->InitializeFromParameters(
+      lower, upper, Vector3d::Constant(0.5), Vector3d::Constant(0.1),
+      Vector3d::Constant(0.01), Vector3d::Constant(0.1));
+}
+
+void BM_AnalyticalOptimalControl(benchmark::State& state) {
+  fv::AnalyticalKinematicBoxQuadrotorDecoupled6D value;
+  if (!InitializeAnalytical(&value)) {
+    state.SkipWithError("Could not initialize value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PositionVelocity planner_x(Vector3d::Zero(), Vector3d::Zero());
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(value.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+void BM_AnalyticalOptimalControlVirtual(benchmark::State& state) {
+  fv::AnalyticalKinematicBoxQuadrotorDecoupled6D value;
+  if (!InitializeAnalytical(&value)) {
+    state.SkipWithError("Could not initialize value function.");
+    return;
+  }
+
+  const auto tracker_xs = RandomTrackerStates();
+  const fs::PositionVelocity planner_x(Vector3d::Zero(), Vector3d::Zero());
+  const AnalyticalValueFunctionBase& base = value;
+  for (auto _ : state) {
+    for (const auto& tracker_x : tracker_xs)
+      benchmark::DoNotOptimize(base.OptimalControl(tracker_x, planner_x));
+  }
+
+  state.SetItemsProcessed(state.iterations() * tracker_xs.size());
+}
+
+}  //\namespace
+
+BENCHMARK(BM_MatlabValue);
+BENCHMARK(BM_MatlabGradient);
+BENCHMARK(BM_MatlabOptimalControl);
+BENCHMARK(BM_MatlabOptimalControlTable);
+BENCHMARK(BM_MatlabOptimalControlTiled)
+    ->Args({4, 16})
+    ->Args({8, 16})
+    ->Args({8, 64});
+BENCHMARK(BM_MatlabOptimalControlVirtual);
+BENCHMARK(BM_AnalyticalOptimalControl);
+BENCHMARK(BM_AnalyticalOptimalControlVirtual);
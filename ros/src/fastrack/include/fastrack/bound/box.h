@@ -53,7 +53,7 @@
 namespace fastrack {
 namespace bound {
 
-struct Box
+struct Box final
     : public TrackingBoundRos<fastrack_srvs::TrackingBoundBox::Response> {
   // Size in each dimension.
   double x;
@@ -116,6 +116,22 @@ struct Box
            p(2) >= lower(2) + z && p(2) <= upper(2) - z;
   }
 
+  // Half-widths of the axis-aligned box enclosing this tracking error bound.
+  Vector3d HalfExtents() const { return Vector3d(x, y, z); }
+
+  // Grow to cover every placement within a cube of the given half-width.
+  void Inflate(double half_width) {
+    x += half_width;
+    y += half_width;
+    z += half_width;
+  }
+
+  // Returns true if the given tracking error lies within this bound.
+  bool Contains(const Vector3d& error) const {
+    return std::abs(error(0)) <= x && std::abs(error(1)) <= y &&
+           std::abs(error(2)) <= z;
+  }
+
   // Visualize.
   inline void Visualize(const ros::Publisher& pub,
                         const std::string& frame) const {
@@ -53,7 +53,7 @@
 namespace fastrack {
 namespace bound {
 
-struct Cylinder
+struct Cylinder final
     : public TrackingBoundRos<fastrack_srvs::TrackingBoundCylinder::Response> {
   // Radius.
   double r;
@@ -128,6 +128,20 @@ struct Cylinder
            p(2) >= lower(2) + z && p(2) <= upper(2) - z;
   }
 
+  // Half-widths of the axis-aligned box enclosing this tracking error bound.
+  Vector3d HalfExtents() const { return Vector3d(r, r, z); }
+
+  // Grow to cover every placement within a cube of the given half-width.
+  void Inflate(double half_width) {
+    r += std::sqrt(2.0) * half_width;
+    z += half_width;
+  }
+
+  // Returns true if the given tracking error lies within this bound.
+  bool Contains(const Vector3d& error) const {
+    return error.head<2>().squaredNorm() <= r * r && std::abs(error(2)) <= z;
+  }
+
   // Visualize.
   void Visualize(const ros::Publisher& pub, const std::string& frame) const {
     visualization_msgs::Marker m;
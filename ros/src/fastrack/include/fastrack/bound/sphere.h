@@ -52,7 +52,7 @@
 namespace fastrack {
 namespace bound {
 
-struct Sphere
+struct Sphere final
     : public TrackingBoundRos<fastrack_srvs::TrackingBoundSphere::Response> {
   // Radius.
   double r;
@@ -105,6 +105,17 @@ struct Sphere
            p(2) >= lower(2) + r && p(2) <= upper(2) - r;
   }
 
+  // Half-widths of the axis-aligned box enclosing this tracking error bound.
+  Vector3d HalfExtents() const { return Vector3d(r, r, r); }
+
+  // Grow to cover every placement within a cube of the given half-width.
+  void Inflate(double half_width) { r += std::sqrt(3.0) * half_width; }
+
+  // Returns true if the given tracking error lies within this bound.
+  bool Contains(const Vector3d& error) const {
+    return error.squaredNorm() <= r * r;
+  }
+
   // Visualize.
   void Visualize(const ros::Publisher& pub, const std::string& frame) const {
     visualization_msgs::Marker m;
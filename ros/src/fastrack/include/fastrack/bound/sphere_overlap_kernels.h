@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Overlap checks between a tracking error bound and many spheres at once.
+// Spheres are stored as a structure of arrays, and each concrete bound type
+// (Box, Cylinder, Sphere) gets its own branch-free kernel which the compiler
+// can inline and vectorize. Other bound types fall back to calling
+// OverlapsSphere on each sphere.
+//
+// These are templated on the bound type so that callers which know the
+// concrete bound at compile time (e.g. planners) avoid virtual dispatch
+// entirely.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_BOUND_SPHERE_OVERLAP_KERNELS_H
+#define FASTRACK_BOUND_SPHERE_OVERLAP_KERNELS_H
+
+#include <fastrack/bound/box.h>
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/bound/sphere.h>
+#include <fastrack/utils/types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace fastrack {
+namespace bound {
+
+// Spheres stored as a structure of arrays.
+struct SphereArray {
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+  std::vector<double> r;
+
+  // Number of spheres.
+  size_t Size() const { return r.size(); }
+
+  // Add a sphere.
+  void Add(const Vector3d& center, double radius) {
+    x.push_back(center(0));
+    y.push_back(center(1));
+    z.push_back(center(2));
+    r.push_back(radius);
+  }
+
+  // Center of the sphere at the given index.
+  Vector3d Center(size_t ii) const { return Vector3d(x[ii], y[ii], z[ii]); }
+};  //\struct SphereArray
+
+// Apply the given kernel (which maps sphere x, y, z, r to a Boolean overlap
+// flag) to all spheres. Kernels are evaluated in fixed-size blocks without
+// branching so each block vectorizes, and we exit early between blocks.
+template <typename K>
+inline bool AnySphere(const SphereArray& spheres, const K& kernel) {
+  constexpr size_t kBlockSize = 8;
+
+  const double* xs = spheres.x.data();
+  const double* ys = spheres.y.data();
+  const double* zs = spheres.z.data();
+  const double* rs = spheres.r.data();
+  const size_t num_spheres = spheres.Size();
+
+  for (size_t ii = 0; ii < num_spheres; ii += kBlockSize) {
+    const size_t end = std::min(num_spheres, ii + kBlockSize);
+
+    int any = 0;
+    for (size_t jj = ii; jj < end; jj++)
+      any |= kernel(xs[jj], ys[jj], zs[jj], rs[jj]);
+
+    if (any) return true;
+  }
+
+  return false;
+}
+
+// Returns true if the bound (at the given position) overlaps any sphere.
+// Generic version, for bound types without a specialized kernel.
+template <typename B>
+inline bool OverlapsAnySphere(const B& bound, const Vector3d& p,
+                              const SphereArray& spheres) {
+  for (size_t ii = 0; ii < spheres.Size(); ii++) {
+    if (bound.OverlapsSphere(p, spheres.Center(ii), spheres.r[ii]))
+      return true;
+  }
+
+  return false;
+}
+
+// Box: distance from sphere center to the closest point in the box.
+template <>
+inline bool OverlapsAnySphere<Box>(const Box& bound, const Vector3d& p,
+                                   const SphereArray& spheres) {
+  const double px = p(0), py = p(1), pz = p(2);
+  const double bx = bound.x, by = bound.y, bz = bound.z;
+
+  return AnySphere(spheres, [=](double cx, double cy, double cz, double r) {
+    const double dx = std::max(std::abs(cx - px) - bx, 0.0);
+    const double dy = std::max(std::abs(cy - py) - by, 0.0);
+    const double dz = std::max(std::abs(cz - pz) - bz, 0.0);
+    return dx * dx + dy * dy + dz * dz <= r * r;
+  });
+}
+
+// Cylinder: the sphere must overlap in z, and then the squared x/y distance
+// q must satisfy sqrt(q) <= br + sqrt(s), where s is the squared radius of the
+// sphere's cross section at the closest z. We square out the roots so the
+// kernel stays cheap.
+template <>
+inline bool OverlapsAnySphere<Cylinder>(const Cylinder& bound,
+                                        const Vector3d& p,
+                                        const SphereArray& spheres) {
+  const double px = p(0), py = p(1), pz = p(2);
+  const double br2 = bound.r * bound.r, bz = bound.z;
+
+  return AnySphere(spheres, [=](double cx, double cy, double cz, double r) {
+    const double dz = std::max(std::abs(cz - pz) - bz, 0.0);
+    const double s = r * r - dz * dz;
+    const double dx = cx - px;
+    const double dy = cy - py;
+    const double q = dx * dx + dy * dy;
+    const double t = q + br2 - s;
+    return (s >= 0.0) & ((q <= br2) | (t <= 0.0) | (t * t <= 4.0 * br2 * q));
+  });
+}
+
+// Sphere: distance between centers.
+template <>
+inline bool OverlapsAnySphere<Sphere>(const Sphere& bound, const Vector3d& p,
+                                      const SphereArray& spheres) {
+  const double px = p(0), py = p(1), pz = p(2);
+  const double br = bound.r;
+
+  return AnySphere(spheres, [=](double cx, double cy, double cz, double r) {
+    const double dx = cx - px;
+    const double dy = cy - py;
+    const double dz = cz - pz;
+    return dx * dx + dy * dy + dz * dz <= (r + br) * (r + br);
+  });
+}
+
+}  //\namespace bound
+}  //\namespace fastrack
+
+#endif
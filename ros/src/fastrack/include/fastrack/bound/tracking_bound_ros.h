@@ -76,6 +76,13 @@ struct TrackingBoundRos : public TrackingBound {
   virtual bool ContainedWithinBox(const Vector3d& p, const Vector3d& lower,
                                   const Vector3d& upper) const = 0;
 
+  // Half-widths of the axis-aligned box enclosing this tracking error bound.
+  virtual Vector3d HalfExtents() const = 0;
+
+  // Returns true if the given tracking error (tracker position minus planner
+  // position) lies within this tracking error bound.
+  virtual bool Contains(const Vector3d& error) const = 0;
+
   // Visualize.
   virtual void Visualize(const ros::Publisher& pub,
                          const std::string& frame) const = 0;
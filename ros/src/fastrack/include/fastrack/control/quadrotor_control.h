@@ -68,7 +68,7 @@ struct QuadrotorControl {
 
   // Convert to ROS message. Assume ordering [pitch, roll, yaw_rate, thrust].
   // NOTE! Set priority to 1 by default.
-  inline fastrack_msgs::Control ToRos(double priority=1.0) {
+  inline fastrack_msgs::Control ToRos(double priority=1.0) const {
     fastrack_msgs::Control msg;
     msg.u.push_back(pitch);
     msg.u.push_back(roll);
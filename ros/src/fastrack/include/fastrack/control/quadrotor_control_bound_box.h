@@ -52,7 +52,8 @@
 namespace fastrack {
 namespace control {
 
-class QuadrotorControlBoundBox : public ControlBound<QuadrotorControl> {
+class QuadrotorControlBoundBox final
+    : public ControlBound<QuadrotorControl> {
  public:
   ~QuadrotorControlBoundBox() {}
   explicit QuadrotorControlBoundBox(const QuadrotorControl& min,
@@ -53,7 +53,8 @@
 namespace fastrack {
 namespace control {
 
-class QuadrotorControlBoundCylinder : public ControlBound<QuadrotorControl> {
+class QuadrotorControlBoundCylinder final
+    : public ControlBound<QuadrotorControl> {
  public:
   ~QuadrotorControlBoundCylinder() {}
   explicit QuadrotorControlBoundCylinder(double radius,
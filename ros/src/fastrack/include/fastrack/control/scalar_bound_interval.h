@@ -48,7 +48,7 @@
 namespace fastrack {
 namespace control {
 
-class ScalarBoundInterval : public ControlBound<double> {
+class ScalarBoundInterval final : public ControlBound<double> {
  public:
   ~ScalarBoundInterval() {}
   explicit ScalarBoundInterval(double min, double max) : min_(min), max_(max) {}
@@ -49,7 +49,7 @@
 namespace fastrack {
 namespace control {
 
-class VectorBoundBox : public ControlBound<VectorXd> {
+class VectorBoundBox final : public ControlBound<VectorXd> {
  public:
   ~VectorBoundBox() {}
   explicit VectorBoundBox(const VectorXd& min, const VectorXd& max)
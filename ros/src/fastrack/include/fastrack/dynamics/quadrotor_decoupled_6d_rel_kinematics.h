@@ -47,6 +47,7 @@
 #include <fastrack/control/quadrotor_control.h>
 #include <fastrack/dynamics/dynamics.h>
 #include <fastrack/dynamics/kinematics.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d.h>
 #include <fastrack/dynamics/relative_dynamics.h>
 #include <fastrack/state/position_velocity.h>
 #include <fastrack/state/position_velocity_rel_position_velocity.h>
@@ -79,17 +80,26 @@ class QuadrotorDecoupled6DRelKinematics
   inline std::unique_ptr<RelativeState<PositionVelocity, PositionVelocity>>
   Evaluate(const PositionVelocity& tracker_x, const QuadrotorControl& tracker_u,
            const PositionVelocity& planner_x, const VectorXd& planner_u) const {
-    if (planner_u.size() != PositionVelocity::ConfigurationDimension())
-      std::runtime_error("Bad planner control size.");
-
-    // TODO(@jaime): confirm that this works. I set things up so things like
-    // this should work.
-    const QuadrotorDecoupled6D<CB> quad_dynamics;
-    const Kinematics<PositionVelocity> quad_kinematics;
     return std::unique_ptr<PositionVelocityRelPositionVelocity>(
         new PositionVelocityRelPositionVelocity(
-            quad_dynamics.Evaluate(tracker_x, tracker_u),
-            quad_kinematics.Evaluate(planner_x, planner_u)));
+            EvaluateRelative(tracker_x, tracker_u, planner_x, planner_u)));
+  }
+
+  // Statically typed version of Evaluate, which returns the relative state
+  // derivative by value. The quadrotor derivative is (velocity, acceleration)
+  // and the kinematic planner derivative is (control, 0), so this is just the
+  // difference of the two.
+  inline PositionVelocityRelPositionVelocity EvaluateRelative(
+      const PositionVelocity& tracker_x, const QuadrotorControl& tracker_u,
+      const PositionVelocity& planner_x, const VectorXd& planner_u) const {
+    if (planner_u.size() != PositionVelocity::ConfigurationDimension())
+      throw std::runtime_error("Bad planner control size.");
+
+    const Vector3d tracker_accel(constants::G * std::tan(tracker_u.pitch),
+                                 -constants::G * std::tan(tracker_u.roll),
+                                 tracker_u.thrust - constants::G);
+    return PositionVelocityRelPositionVelocity(
+        tracker_x.Velocity() - planner_u.head<3>(), tracker_accel);
   }
 
   // Derived classes must be able to compute an optimal control given
@@ -100,12 +110,35 @@ class QuadrotorDecoupled6DRelKinematics
       const RelativeState<PositionVelocity, PositionVelocity>& value_gradient,
       const ControlBound<QuadrotorControl>& tracker_u_bound,
       const ControlBound<VectorXd>& planner_u_bound) const {
-    // Get internal state of value gradient and map tracker control (negative)
-    // coefficients to QuadrotorControl, so we get a negative gradient.
-    const auto& cast = static_cast<const PositionVelocityRelPositionVelocity& >(
-        value_gradient);
+    return OptimalControl(
+        tracker_x, planner_x,
+        static_cast<const PositionVelocityRelPositionVelocity&>(value_gradient),
+        tracker_u_bound, planner_u_bound);
+  }
 
-    const auto& grad = cast.State();
+  // Statically typed version of OptimalControl. Takes the concrete gradient
+  // type, and is templated on the tracker control bound type so that the
+  // projection is not a virtual call when the concrete bound is known.
+  template <typename TB>
+  inline QuadrotorControl OptimalControl(
+      const PositionVelocity& tracker_x, const PositionVelocity& planner_x,
+      const PositionVelocityRelPositionVelocity& value_gradient,
+      const TB& tracker_u_bound,
+      const ControlBound<VectorXd>& planner_u_bound) const {
+    return RelativeOptimalControl(value_gradient, tracker_u_bound);
+  }
+
+  // Part of the optimal control which depends only on the value gradient, and
+  // the remainder which depends on the tracker and planner states. For these
+  // dynamics the optimal control is a function of the gradient alone, so the
+  // remainder is the identity.
+  template <typename TB>
+  inline QuadrotorControl RelativeOptimalControl(
+      const PositionVelocityRelPositionVelocity& value_gradient,
+      const TB& tracker_u_bound) const {
+    // Map tracker control (negative) coefficients to QuadrotorControl, so we
+    // get a negative gradient.
+    const auto& grad = value_gradient.State();
     QuadrotorControl negative_grad;
     negative_grad.yaw_rate = 0.0;
     negative_grad.pitch = -grad.Vx();
@@ -118,6 +151,12 @@ class QuadrotorDecoupled6DRelKinematics
 
     return c;
   }
+
+  inline QuadrotorControl CompleteOptimalControl(
+      const PositionVelocity& tracker_x, const PositionVelocity& planner_x,
+      const QuadrotorControl& relative_u) const {
+    return relative_u;
+  }
 }; //\class QuadrotorDecoupled6DRelKinematics
 
 } // namespace dynamics
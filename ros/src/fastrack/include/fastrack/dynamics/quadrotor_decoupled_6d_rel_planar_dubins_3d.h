@@ -52,6 +52,7 @@
 #include <fastrack/state/planar_dubins_3d.h>
 #include <fastrack/state/position_velocity.h>
 #include <fastrack/state/position_velocity_rel_planar_dubins_3d.h>
+#include <fastrack/utils/types.h>
 
 #include <math.h>
 
@@ -87,8 +88,166 @@ public:
       const RelativeState<PositionVelocity, PlanarDubins3D>& value_gradient,
       const ControlBound<QuadrotorControl>& tracker_u_bound,
       const ControlBound<double>& planner_u_bound) const;
+
+  // Statically typed versions of Evaluate and OptimalControl. These take and
+  // return the concrete relative state by value, and OptimalControl is
+  // templated on the tracker control bound type so the projection can be
+  // inlined. The virtual interface above is implemented on top of these.
+  inline PositionVelocityRelPlanarDubins3D EvaluateRelative(
+      const PositionVelocity& tracker_x, const QuadrotorControl& tracker_u,
+      const PlanarDubins3D& planner_x, const double& planner_u) const;
+
+  template <typename TB>
+  inline QuadrotorControl OptimalControl(
+      const PositionVelocity& tracker_x, const PlanarDubins3D& planner_x,
+      const PositionVelocityRelPlanarDubins3D& value_gradient,
+      const TB& tracker_u_bound,
+      const ControlBound<double>& planner_u_bound) const;
+
+  // The optimal control splits into a part which depends only on the value
+  // gradient, i.e. the projected (pitch, roll) expressed in the planner frame,
+  // and a part which depends on the tracker and planner states, i.e. the
+  // rotation into the world frame and the vertical PD controller. The first
+  // part may be precomputed over a grid of relative states.
+  // NOTE! Projecting before rotating is only equivalent to OptimalControl for
+  // a bound which is rotationally symmetric in (pitch, roll), so
+  // RelativeOptimalControl takes a cylindrical bound.
+  inline QuadrotorControl RelativeOptimalControl(
+      const PositionVelocityRelPlanarDubins3D& value_gradient,
+      const QuadrotorControlBoundCylinder& tracker_u_bound) const;
+  inline QuadrotorControl CompleteOptimalControl(
+      const PositionVelocity& tracker_x, const PlanarDubins3D& planner_x,
+      const QuadrotorControl& relative_u) const;
+
+private:
+  // Thrust from the vertical PD controller.
+  static inline double VerticalThrust(const PositionVelocity& tracker_x,
+                                      const PlanarDubins3D& planner_x);
 }; //\class QuadrotorDecoupledPlanarDubins
 
+// ---------------------------- IMPLEMENTATION  ---------------------------- //
+
+// Statically typed version of Evaluate.
+PositionVelocityRelPlanarDubins3D
+QuadrotorDecoupled6DRelPlanarDubins3D::EvaluateRelative(
+    const PositionVelocity& tracker_x, const QuadrotorControl& tracker_u,
+    const PlanarDubins3D& planner_x, const double& planner_u) const {
+  // Compute relative state.
+  const PositionVelocityRelPlanarDubins3D relative_x(tracker_x, planner_x);
+
+  // Net instantaneous tangent velocity (PositionVelocity minus Dubins).
+  // This is used in the derivatives of relative position (distance, bearing).
+  // It is NOT used in the velocity derivatives because velocity states are
+  // absolute (even though they are expressed in the changing Dubins frame).
+  const auto net_tangent_velocity =
+      relative_x.TangentVelocity() - planner_x.V();
+
+  // Relative distance derivative.
+  const double distance_dot =
+      net_tangent_velocity * std::cos(relative_x.Bearing()) +
+      relative_x.NormalVelocity() * std::sin(relative_x.Bearing());
+
+  // Relative bearing derivative.
+  const double bearing_dot =
+      -planner_u +
+      (-net_tangent_velocity * std::sin(relative_x.Bearing()) +
+       relative_x.NormalVelocity() * std::cos(relative_x.Bearing())) /
+          relative_x.Distance();  // omega_circ = v_circ / R
+
+  // Tracker accelerations expressed in inertial world frame.
+  const double tracker_accel_x = constants::G * std::tan(tracker_u.pitch);
+  const double tracker_accel_y = -constants::G * std::tan(tracker_u.roll);
+
+  // Relative tangent and normal velocity derivatives.
+  // NOTE! Must rotate roll/pitch into planner frame.
+  const double c = std::cos(planner_x.Theta());
+  const double s = std::sin(planner_x.Theta());
+
+  const double tangent_velocity_dot = tracker_accel_x * c +
+                                      tracker_accel_y * s +
+                                      planner_u * relative_x.NormalVelocity();
+  const double normal_velocity_dot = -tracker_accel_x * s +
+                                     tracker_accel_y * c -
+                                     planner_u * relative_x.TangentVelocity();
+
+  return PositionVelocityRelPlanarDubins3D(distance_dot, bearing_dot,
+                                           tangent_velocity_dot,
+                                           normal_velocity_dot);
+}
+
+// Statically typed version of OptimalControl.
+template <typename TB>
+QuadrotorControl QuadrotorDecoupled6DRelPlanarDubins3D::OptimalControl(
+    const PositionVelocity& tracker_x, const PlanarDubins3D& planner_x,
+    const PositionVelocityRelPlanarDubins3D& value_gradient,
+    const TB& tracker_u_bound,
+    const ControlBound<double>& planner_u_bound) const {
+  // Map tracker control (negative) coefficients to QuadrotorControl, so we
+  // get a negative gradient.
+  const auto& grad = value_gradient;
+
+  // Translate gradient into (negative) control-affine terms for pitch and roll.
+  const double c = std::cos(planner_x.Theta());
+  const double s = std::sin(planner_x.Theta());
+
+  QuadrotorControl negative_grad;
+  negative_grad.pitch =
+      -(grad.TangentVelocity() * c - grad.NormalVelocity() * s);
+  negative_grad.roll =
+      -(-grad.TangentVelocity() * s - grad.NormalVelocity() * c);
+  negative_grad.thrust = 0.0;    // Vertical position controlled externally.
+  negative_grad.yaw_rate = 0.0;  // Yaw controlled externally.
+
+  // Project onto tracker control bound and make sure to zero out yaw_rate.
+  QuadrotorControl u = tracker_u_bound.ProjectToSurface(negative_grad);
+
+  // Adjust non-bang-bang control inputs.
+  u.yaw_rate = 0.0;  // Yaw controlled externally.
+  u.thrust = VerticalThrust(tracker_x, planner_x);
+
+  return u;
+}
+
+// Part of the optimal control which depends only on the value gradient,
+// expressed in the planner frame. This is OptimalControl with the planner
+// heading set to zero, without the vertical controller.
+QuadrotorControl QuadrotorDecoupled6DRelPlanarDubins3D::RelativeOptimalControl(
+    const PositionVelocityRelPlanarDubins3D& value_gradient,
+    const QuadrotorControlBoundCylinder& tracker_u_bound) const {
+  QuadrotorControl negative_grad;
+  negative_grad.pitch = -value_gradient.TangentVelocity();
+  negative_grad.roll = value_gradient.NormalVelocity();
+  negative_grad.thrust = 0.0;
+  negative_grad.yaw_rate = 0.0;
+
+  QuadrotorControl u = tracker_u_bound.ProjectToSurface(negative_grad);
+  u.yaw_rate = 0.0;
+  u.thrust = 0.0;
+  return u;
+}
+
+// Rotate a control computed by RelativeOptimalControl into the world frame
+// and add the vertical controller.
+QuadrotorControl QuadrotorDecoupled6DRelPlanarDubins3D::CompleteOptimalControl(
+    const PositionVelocity& tracker_x, const PlanarDubins3D& planner_x,
+    const QuadrotorControl& relative_u) const {
+  const double c = std::cos(planner_x.Theta());
+  const double s = std::sin(planner_x.Theta());
+
+  return QuadrotorControl(c * relative_u.pitch + s * relative_u.roll,
+                          -s * relative_u.pitch + c * relative_u.roll, 0.0,
+                          VerticalThrust(tracker_x, planner_x));
+}
+
+// Thrust from the vertical PD controller.
+double QuadrotorDecoupled6DRelPlanarDubins3D::VerticalThrust(
+    const PositionVelocity& tracker_x, const PlanarDubins3D& planner_x) {
+  constexpr double k_p = 1.5;  // HACK! PD constants are hard-coded.
+  constexpr double k_d = 1.0;  // (from k_manual.txt in crazyflie_clean).
+  return constants::G + k_p * (planner_x.Z() - tracker_x.Z()) +
+         k_d * (planner_x.Vz() - tracker_x.Vz());
+}
+
 } // namespace dynamics
 } // namespace fastrack
 
@@ -39,13 +39,26 @@
 // BallsInBox is derived from the Environment base class. This class models
 // obstacles as spheres to provide a simple demo.
 //
+// Collision checks are also provided as templates on the bound type, so that
+// callers who know the concrete bound (e.g. planners) get a specialized,
+// statically dispatched overlap kernel.
+//
+// Besides the SensedSpheres measurement, BallsInBox can simulate a ray-cast
+// depth scan (for RaySensor), using a bounding volume hierarchy over the
+// obstacles which is rebuilt whenever they change.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_ENVIRONMENT_BALLS_IN_BOX_H
 #define FASTRACK_ENVIRONMENT_BALLS_IN_BOX_H
 
+#include <fastrack/bound/sphere_overlap_kernels.h>
 #include <fastrack/environment/environment.h>
+#include <fastrack/sensor/ray_sensor_params.h>
 #include <fastrack/sensor/sphere_sensor_params.h>
+#include <fastrack/utils/sphere_bvh.h>
+#include <fastrack/utils/thread_pool.h>
+#include <fastrack_msgs/SensedRays.h>
 #include <fastrack_msgs/SensedSpheres.h>
 
 #include <geometry_msgs/Point.h>
@@ -53,51 +66,114 @@
 #include <ros/ros.h>
 #include <visualization_msgs/Marker.h>
 
+#include <limits>
+#include <memory>
+#include <mutex>
+
 namespace fastrack {
 namespace environment {
 
+using sensor::RaySensorParams;
 using sensor::SphereSensorParams;
 using bound::TrackingBound;
+using bound::SphereArray;
 
 class BallsInBox
     : public Environment<fastrack_msgs::SensedSpheres, SphereSensorParams> {
  public:
   ~BallsInBox() {}
   explicit BallsInBox()
-      : Environment<fastrack_msgs::SensedSpheres, SphereSensorParams>() {}
+      : Environment<fastrack_msgs::SensedSpheres, SphereSensorParams>(),
+        bvh_version_(std::numeric_limits<unsigned int>::max()) {}
+
+  // Copy the obstacles, e.g. for snapshots. Ray casting state is rebuilt
+  // lazily by the copy if needed.
+  BallsInBox(const BallsInBox &other)
+      : Environment<fastrack_msgs::SensedSpheres, SphereSensorParams>(other),
+        obstacles_(other.obstacles_),
+        bvh_version_(std::numeric_limits<unsigned int>::max()) {}
 
   // Derived classes must provide a collision checker which returns true if
   // and only if the provided position is a valid collision-free configuration.
   // Ignores 'time' since this is a time-invariant environment.
+  // Known bound types are dispatched to their specialized kernels.
   bool IsValid(const Vector3d &position, const TrackingBound &bound,
                double time = std::numeric_limits<double>::quiet_NaN()) const;
 
+  // Statically dispatched collision checks for a concrete bound type B.
+  template <typename B>
+  bool IsValid(const Vector3d &position, const B &bound,
+               double time = std::numeric_limits<double>::quiet_NaN()) const;
+  template <typename B>
+  bool AreValid(const std::vector<Vector3d> &positions, const B &bound,
+                double time = std::numeric_limits<double>::quiet_NaN()) const;
+
   // Generate a sensor measurement.
   fastrack_msgs::SensedSpheres SimulateSensor(
       const SphereSensorParams &params) const;
 
+  // Generate a ray-cast depth scan. Rays are cast in parallel.
+  fastrack_msgs::SensedRays SimulateSensor(
+      const RaySensorParams &params) const;
+
   // Derived classes must have some sort of visualization through RViz.
   void Visualize() const;
 
- private:
+ protected:
   // Load parameters. This may be overridden by derived classes if needed
   // (they should still call this one via Environment::LoadParameters).
   bool LoadParameters(const ros::NodeHandle &n);
 
   // Update this environment with the information contained in the given
-  // sensor measurement.
-  // NOTE! This function needs to publish on `updated_topic_`.
-  void SensorCallback(const fastrack_msgs::SensedSpheres::ConstPtr &msg);
+  // sensor measurement. Returns whether the model changed.
+  // NOTE! This function needs to publish on `updated_topic_` if so.
+  bool SensorCallback(const fastrack_msgs::SensedSpheres::ConstPtr &msg);
 
   // Generate random obstacles.
   void GenerateObstacles(size_t num, double min_radius, double max_radius,
                          unsigned int seed = 0);
 
   // Obstacle centers and radii.
-  std::vector<Vector3d> centers_;
-  std::vector<double> radii_;
+  SphereArray obstacles_;
+
+  // Hierarchy over the obstacles for ray casting, the version it was built
+  // at, and the threads rays are cast on. Built lazily on the first scan.
+  mutable std::mutex ray_mutex_;
+  mutable SphereBvh bvh_;
+  mutable unsigned int bvh_version_;
+  mutable std::unique_ptr<ThreadPool> ray_pool_;
 };  //\class Environment
 
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+// Statically dispatched collision checks for a concrete bound type B.
+template <typename B>
+bool BallsInBox::IsValid(const Vector3d &position, const B &bound,
+                         double time) const {
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized BallsInBox.",
+             name_.c_str());
+    return false;
+  }
+
+  // Check that this position is within the outer environment boundaries.
+  if (!bound.ContainedWithinBox(position, lower_, upper_)) return false;
+
+  // Check against each obstacle.
+  return !bound::OverlapsAnySphere(bound, position, obstacles_);
+}
+
+template <typename B>
+bool BallsInBox::AreValid(const std::vector<Vector3d> &positions,
+                          const B &bound, double time) const {
+  // Return Boolean AND of all IsValid calls.
+  for (const auto &p : positions) {
+    if (!IsValid(p, bound, time)) return false;
+  }
+
+  return true;
+}
+
 }  //\namespace environment
 }  //\namespace fastrack
 
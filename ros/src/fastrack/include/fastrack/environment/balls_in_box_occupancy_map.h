@@ -40,17 +40,36 @@
 // a collection of spherical sensor fields of view and spherical obstacles,
 // which may overlap.
 //
+// Occupancy queries for a tracking error bound are also provided as templates
+// on the bound type, so that callers who know the concrete bound avoid
+// virtual dispatch in the inner overlap loop.
+//
+// Optionally, bound queries are first answered from a CoarseOccupancyGrid
+// built for the size of the queried bound. Only queries which land in
+// ambiguous cells run the exact checks. The grid lives on the live map and is
+// relabeled incrementally by the updater, so snapshots share an up-to-date
+// grid. Since only readers know the bound, a snapshot which has to build a
+// grid hands it back to the live map, which adopts it (or rebuilds it, if
+// the map has changed since) on the next sensor update.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_ENVIRONMENT_BALLS_IN_BOX_OCCUPANCY_MAP_H
 #define FASTRACK_ENVIRONMENT_BALLS_IN_BOX_OCCUPANCY_MAP_H
 
+#include <fastrack/bound/box.h>
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/bound/sphere.h>
+#include <fastrack/environment/coarse_occupancy_grid.h>
 #include <fastrack/environment/occupancy_map.h>
 #include <fastrack/sensor/sphere_sensor.h>
 #include <fastrack/sensor/sphere_sensor_params.h>
 #include <fastrack/utils/kdtree_map.h>
 #include <fastrack_msgs/SensedSpheres.h>
 
+#include <memory>
+#include <mutex>
+
 namespace fastrack {
 namespace environment {
 
@@ -64,7 +83,21 @@ class BallsInBoxOccupancyMap
   explicit BallsInBoxOccupancyMap()
       : OccupancyMap<fastrack_msgs::SensedSpheres, SphereSensorParams>(),
         largest_obstacle_radius_(0.0),
-        largest_sensor_radius_(0.0) {}
+        largest_sensor_radius_(0.0),
+        coarse_resolution_(0.0),
+        coarse_grid_handoff_(std::make_shared<CoarseGridHandoff>()) {}
+
+  // Copy the map, e.g. for snapshots. Coarse grids are immutable, so the
+  // copy shares the current one, and hands new ones back to the original.
+  BallsInBoxOccupancyMap(const BallsInBoxOccupancyMap& other)
+      : OccupancyMap<fastrack_msgs::SensedSpheres, SphereSensorParams>(other),
+        obstacles_(other.obstacles_),
+        sensor_fovs_(other.sensor_fovs_),
+        largest_obstacle_radius_(other.largest_obstacle_radius_),
+        largest_sensor_radius_(other.largest_sensor_radius_),
+        coarse_resolution_(other.coarse_resolution_),
+        coarse_grid_(std::atomic_load(&other.coarse_grid_)),
+        coarse_grid_handoff_(other.coarse_grid_handoff_) {}
 
   // Derived classes must provide an OccupancyProbability function for both
   // single points and tracking error bounds centered on a point.
@@ -72,10 +105,32 @@ class BallsInBoxOccupancyMap
   double OccupancyProbability(
       const Vector3d& p,
       double time = std::numeric_limits<double>::quiet_NaN()) const;
+  // Known bound types are dispatched to their templated versions below.
   double OccupancyProbability(
       const Vector3d& p, const TrackingBound& bound,
       double time = std::numeric_limits<double>::quiet_NaN()) const;
 
+  // Statically dispatched occupancy queries for a concrete bound type B.
+  template <typename B>
+  double OccupancyProbability(
+      const Vector3d& p, const B& bound,
+      double time = std::numeric_limits<double>::quiet_NaN()) const;
+  template <typename B>
+  bool IsValid(const Vector3d& position, const B& bound,
+               double time = std::numeric_limits<double>::quiet_NaN()) const {
+    return initialized_ &&
+           OccupancyProbability(position, bound, time) < free_space_threshold_;
+  }
+  template <typename B>
+  bool AreValid(const std::vector<Vector3d>& positions, const B& bound,
+                double time = std::numeric_limits<double>::quiet_NaN()) const {
+    for (const auto& p : positions) {
+      if (!IsValid(p, bound, time)) return false;
+    }
+
+    return true;
+  }
+
   // Generate a sensor measurement.
   fastrack_msgs::SensedSpheres SimulateSensor(
       const SphereSensorParams& params) const;
@@ -83,17 +138,39 @@ class BallsInBoxOccupancyMap
   // Derived classes must have some sort of visualization through RViz.
   void Visualize() const;
 
- private:
+ protected:
   // Load parameters. This may be overridden by derived classes if needed
   // (they should still call this one via OccupancyMap::LoadParameters).
   bool LoadParameters(const ros::NodeHandle& n);
 
   // Update this environment with the information contained in the given
-  // sensor measurement.
-  // NOTE! This function needs to publish on `updated_topic_`.
-  void SensorCallback(
+  // sensor measurement. Returns whether the model changed.
+  // NOTE! This function needs to publish on `updated_topic_` if so.
+  bool SensorCallback(
       const typename fastrack_msgs::SensedSpheres::ConstPtr& msg);
 
+  // Get a coarse grid which is valid for bounds with the given half extents,
+  // building a new one if necessary. Returns null if disabled.
+  std::shared_ptr<const CoarseOccupancyGrid> CoarseGrid(
+      const Vector3d& inflation) const;
+
+  // Build a coarse grid for the given half extents from scratch.
+  std::shared_ptr<const CoarseOccupancyGrid> BuildCoarseGrid(
+      const Vector3d& inflation) const;
+
+  // Take over a grid handed back by a snapshot, if it covers larger bounds
+  // than the current one. Rebuilds it if it was built from an older model.
+  // Must be called by the updater before changing the model.
+  void AdoptCoarseGrid();
+
+  // Label the cell with the given index from the obstacles and sensor FOVs.
+  CoarseOccupancyGrid::CellLabel ClassifyCell(const CoarseOccupancyGrid& grid,
+                                              size_t idx) const;
+
+  // Relabel the coarse grid cells affected by the given new spheres.
+  void UpdateCoarseGrid(
+      const std::vector<std::pair<Vector3d, double>>& spheres);
+
   // KdtreeMaps to store spherical obstacle and sensor locations, as well as
   // radii for each.
   KdtreeMap<3, double> obstacles_;
@@ -103,12 +180,90 @@ class BallsInBoxOccupancyMap
   double largest_obstacle_radius_;
   double largest_sensor_radius_;
 
+  // Coarse grid cell size (zero to disable), and the current grid. The grid
+  // is swapped atomically so queries never need to lock.
+  double coarse_resolution_;
+  mutable std::shared_ptr<const CoarseOccupancyGrid> coarse_grid_;
+  mutable std::mutex coarse_grid_mutex_;
+
+  // Most recent grid built by any copy of this map, with the version of the
+  // model it was built from. Shared by the live map and all its snapshots.
+  struct CoarseGridHandoff {
+    std::mutex mutex;
+    std::shared_ptr<const CoarseOccupancyGrid> grid;
+    unsigned int version;
+  };  //\struct CoarseGridHandoff
+
+  std::shared_ptr<CoarseGridHandoff> coarse_grid_handoff_;
+
   // Static constants for occupied/unknown/free probabilities.
   static constexpr double kOccupiedProbability = 1.0;
   static constexpr double kUnknownProbability = 0.5;
   static constexpr double kFreeProbability = 0.0;
 };  //\class BallsInBoxOccupancyMap
 
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+// Occupancy probability for a tracking error bound centered at the given
+// point. Occupancy is set to occupied if ANY of the bound is occupied. Next,
+// if ANY of the bound is unknown the result is unknown. Otherwise, free.
+template <typename B>
+double BallsInBoxOccupancyMap::OccupancyProbability(const Vector3d& p,
+                                                    const B& bound,
+                                                    double time) const {
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check without initializing.",
+             name_.c_str());
+    return kOccupiedProbability;
+  }
+
+  // Check box limits.
+  if (!bound.ContainedWithinBox(p, lower_, upper_)) return kOccupiedProbability;
+
+  // Coarse check. Only ambiguous cells need the exact checks below.
+  if (coarse_resolution_ > 0.0) {
+    const auto grid = CoarseGrid(bound.HalfExtents());
+    switch (grid->Label(p)) {
+      case CoarseOccupancyGrid::OCCUPIED:
+        return kOccupiedProbability;
+      case CoarseOccupancyGrid::UNKNOWN:
+        return kUnknownProbability;
+      case CoarseOccupancyGrid::FREE:
+        return kFreeProbability;
+      default:
+        break;
+    }
+  }
+
+  // Helper function to check if any sphere in the given KdtreeMap overlaps
+  // the given bound.
+  auto overlaps = [&p, &bound](const KdtreeMap<3, double>& kdtree) {
+    // Get k-nearest neighbors as a heuristic.
+    // NOTE: using KnnSearch instead of RadiusSearch because it seems to
+    // be more precise. When the Kdtree is huge it may make more sense to
+    // radius search, or it may not matter.
+    constexpr size_t kNumNearestNeighbors = 10;
+    const auto neighbors = kdtree.KnnSearch(p, kNumNearestNeighbors);
+
+    // Check for overlaps.
+    for (const auto& entry : neighbors) {
+      const Vector3d& center = entry.first;
+      const double& radius = entry.second;
+      if (bound.OverlapsSphere(p, center, radius)) return true;
+    }
+
+    return false;
+  };  //\overlaps
+
+  // Check if this point is inside any obstacles.
+  if (overlaps(obstacles_)) return kOccupiedProbability;
+
+  // Check if this point contains any unknown space.
+  if (!overlaps(sensor_fovs_)) return kUnknownProbability;
+
+  return kFreeProbability;
+}
+
 }  //\namespace environment
 }  //\namespace fastrack
 
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoarseOccupancyGrid is a uniform grid over the environment box which
+// stores, for each cell, whether a tracking error bound centered anywhere in
+// that cell is definitely free, definitely occupied, definitely unknown, or
+// ambiguous. The grid is built for a particular bound size (its half extents)
+// and is meant to answer most collision checks with a single lookup; only
+// ambiguous cells need to fall through to exact checks.
+//
+// The grid itself only stores labels. Classifying cells is left to the
+// environment which owns it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_ENVIRONMENT_COARSE_OCCUPANCY_GRID_H
+#define FASTRACK_ENVIRONMENT_COARSE_OCCUPANCY_GRID_H
+
+#include <fastrack/utils/types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace fastrack {
+namespace environment {
+
+class CoarseOccupancyGrid {
+ public:
+  // Cell labels. AMBIGUOUS must be zero so new grids start out ambiguous.
+  enum CellLabel : uint8_t { AMBIGUOUS = 0, FREE, OCCUPIED, UNKNOWN };
+
+  ~CoarseOccupancyGrid() {}
+  explicit CoarseOccupancyGrid(const Vector3d& lower, const Vector3d& upper,
+                               double resolution, const Vector3d& inflation)
+      : lower_(lower), resolution_(resolution), inflation_(inflation) {
+    for (size_t ii = 0; ii < 3; ii++) {
+      const double num_cells = std::ceil((upper(ii) - lower(ii)) / resolution);
+      dims_[ii] = std::max<size_t>(1, static_cast<size_t>(num_cells));
+    }
+
+    labels_.resize(dims_[0] * dims_[1] * dims_[2], AMBIGUOUS);
+  }
+
+  // Label of the cell containing the given point. Points outside the grid
+  // are ambiguous.
+  CellLabel Label(const Vector3d& p) const {
+    size_t idx;
+    return (Index(p, &idx)) ? static_cast<CellLabel>(labels_[idx]) : AMBIGUOUS;
+  }
+
+  // Set the label of the cell with the given index.
+  void SetLabel(size_t idx, CellLabel label) { labels_[idx] = label; }
+
+  // Bound size this grid was built for.
+  const Vector3d& Inflation() const { return inflation_; }
+
+  // Number of cells.
+  size_t NumCells() const { return labels_.size(); }
+
+  // Corners of the cell with the given index.
+  void CellBox(size_t idx, Vector3d* lower, Vector3d* upper) const {
+    const size_t ix = idx % dims_[0];
+    const size_t iy = (idx / dims_[0]) % dims_[1];
+    const size_t iz = idx / (dims_[0] * dims_[1]);
+
+    *lower = lower_ + resolution_ * Vector3d(ix, iy, iz);
+    *upper = *lower + Vector3d::Constant(resolution_);
+  }
+
+  // Indices of all cells which overlap the given box.
+  std::vector<size_t> CellsOverlapping(const Vector3d& lower,
+                                       const Vector3d& upper) const {
+    size_t lo[3], hi[3];
+    for (size_t ii = 0; ii < 3; ii++) {
+      const double l = std::floor((lower(ii) - lower_(ii)) / resolution_);
+      const double h = std::floor((upper(ii) - lower_(ii)) / resolution_);
+      if (h < 0.0 || l >= static_cast<double>(dims_[ii])) return {};
+
+      lo[ii] = static_cast<size_t>(std::max(l, 0.0));
+      hi[ii] = std::min(static_cast<size_t>(h), dims_[ii] - 1);
+    }
+
+    std::vector<size_t> cells;
+    for (size_t iz = lo[2]; iz <= hi[2]; iz++) {
+      for (size_t iy = lo[1]; iy <= hi[1]; iy++) {
+        for (size_t ix = lo[0]; ix <= hi[0]; ix++)
+          cells.push_back(ix + dims_[0] * (iy + dims_[1] * iz));
+      }
+    }
+
+    return cells;
+  }
+
+ private:
+  // Index of the cell containing the given point. Returns false if the point
+  // is outside the grid.
+  bool Index(const Vector3d& p, size_t* idx) const {
+    size_t cell[3];
+    for (size_t ii = 0; ii < 3; ii++) {
+      const double c = std::floor((p(ii) - lower_(ii)) / resolution_);
+      if (!(c >= 0.0 && c < static_cast<double>(dims_[ii]))) return false;
+      cell[ii] = static_cast<size_t>(c);
+    }
+
+    *idx = cell[0] + dims_[0] * (cell[1] + dims_[1] * cell[2]);
+    return true;
+  }
+
+  // Lower corner, cell size, and number of cells along each axis.
+  const Vector3d lower_;
+  const double resolution_;
+  size_t dims_[3];
+
+  // Bound size this grid was built for.
+  const Vector3d inflation_;
+
+  // One label per cell.
+  std::vector<uint8_t> labels_;
+};  //\class CoarseOccupancyGrid
+
+}  //\namespace environment
+}  //\namespace fastrack
+
+#endif
@@ -42,6 +42,19 @@
 // message (M) which may be generated from or incorporated into a derived class,
 // and sensor parameters (P) which may be used to generate sensor readings.
 //
+// Environments are versioned. Sensor updates happen under a lock and bump the
+// version, and Snapshot() returns an immutable copy of the model at the
+// current version, shared by all readers until the next update (RCU-style:
+// old snapshots are released when their last reader lets go). Once anyone
+// has asked for a snapshot, the updater copies the model after each change
+// and swaps the copy in, so readers only ever take a pointer. Optionally,
+// sensor updates run on their own thread, so that planning against a
+// snapshot and integrating new measurements no longer block each other.
+//
+// Optionally, every sensor message is acknowledged once it has been
+// incorporated, whether or not it changed the model (e.g. so that a session
+// replay need not wait for an update that never comes).
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_ENVIRONMENT_ENVIRONMENT_H
@@ -51,12 +64,19 @@
 #include <fastrack/bound/cylinder.h>
 #include <fastrack/bound/sphere.h>
 #include <fastrack/bound/tracking_bound.h>
+#include <fastrack/utils/session_log.h>
 #include <fastrack/utils/types.h>
 
+#include <ros/callback_queue.h>
 #include <ros/ros.h>
 #include <std_msgs/Empty.h>
 #include <visualization_msgs/Marker.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
 namespace fastrack {
 namespace environment {
 
@@ -68,7 +88,11 @@ using bound::TrackingBound;
 template <typename M, typename P>
 class Environment {
  public:
-  virtual ~Environment() {}
+  virtual ~Environment() {
+    // Stop the update thread before its queue and subscriber go away.
+    if (update_spinner_) update_spinner_->stop();
+    sensor_sub_.shutdown();
+  }
 
   // Initialize from a ROS NodeHandle.
   bool Initialize(const ros::NodeHandle& n);
@@ -97,8 +121,42 @@ class Environment {
   // Derived classes must have some sort of visualization through RViz.
   virtual void Visualize() const = 0;
 
+  // Record all incoming sensor messages to the given session log.
+  void SetRecorder(const std::shared_ptr<SessionRecorder>& recorder) {
+    recorder_ = recorder;
+  }
+
+  // Version counter, incremented after every sensor update which changes the
+  // model. Collision check results are only comparable if computed at the
+  // same version.
+  unsigned int Version() const { return version_.load(); }
+
+  // Immutable copy of this environment at the most recent version. The model
+  // is copied at most once per version, and only when someone asks, so bursts
+  // of sensor updates between planner requests cost one copy. Readers never
+  // wait on an update in progress (except for the very first snapshot); they
+  // get the previous snapshot instead. E must be the concrete type of this
+  // environment.
+  template <typename E>
+  std::shared_ptr<const E> Snapshot() const;
+
  protected:
-  explicit Environment() : initialized_(false) {}
+  explicit Environment()
+      : concurrent_updates_(false), version_(0), initialized_(false) {}
+
+  // Copy the model but none of the ROS interfaces, e.g. for snapshots.
+  Environment(const Environment& other)
+      : lower_(other.lower_),
+        upper_(other.upper_),
+        vis_topic_(other.vis_topic_),
+        updated_topic_(other.updated_topic_),
+        sensor_topic_(other.sensor_topic_),
+        sensor_ack_topic_(other.sensor_ack_topic_),
+        fixed_frame_(other.fixed_frame_),
+        concurrent_updates_(false),
+        version_(other.version_.load()),
+        name_(other.name_),
+        initialized_(other.initialized_) {}
 
   // Load parameters. This may be overridden by derived classes if needed
   // (they should still call this one via Environment::LoadParameters).
@@ -108,9 +166,42 @@ class Environment {
   virtual bool RegisterCallbacks(const ros::NodeHandle& n);
 
   // Update this environment with the information contained in the given
-  // sensor measurement.
-  // NOTE! This function needs to publish on `updated_topic_`.
-  virtual void SensorCallback(const typename M::ConstPtr& msg) = 0;
+  // sensor measurement. Returns whether the model changed.
+  // NOTE! This function needs to publish on `updated_topic_` if so.
+  virtual bool SensorCallback(const typename M::ConstPtr& msg) = 0;
+
+  // Record the sensor message (if recording) before incorporating it, and
+  // acknowledge it afterward (if acknowledging). The version is only bumped
+  // if the model actually changed.
+  void RecordAndSensorCallback(const typename M::ConstPtr& msg) {
+    RecordAndIncorporate(SENSOR, *msg, [this, &msg]() {
+      return SensorCallback(msg);
+    });
+  }
+
+  // Same for any other kind of measurement which changes the model. The
+  // incorporate function returns whether the model changed.
+  template <typename T, typename F>
+  void RecordAndIncorporate(SessionRecordType type, const T& msg,
+                            const F& incorporate) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    if (recorder_) recorder_->Record(type, msg);
+    if (incorporate()) ModelChanged();
+
+    if (!sensor_ack_topic_.empty()) sensor_ack_pub_.publish(std_msgs::Empty());
+  }
+
+  // Bump the version, marking the current snapshot stale. Call with
+  // 'update_mutex_' held after every change to the model.
+  void ModelChanged() { version_++; }
+
+  // Node handle on which to subscribe to sensor updates, using the update
+  // thread's callback queue if updates are concurrent.
+  ros::NodeHandle UpdateNodeHandle(const ros::NodeHandle& n) const {
+    ros::NodeHandle nl(n);
+    if (update_queue_) nl.setCallbackQueue(update_queue_.get());
+    return nl;
+  }
 
   // Upper and lower bounds.
   Vector3d lower_;
@@ -119,15 +210,37 @@ class Environment {
   // Publishers and subscribers.
   ros::Publisher vis_pub_;
   ros::Publisher updated_pub_;
+  ros::Publisher sensor_ack_pub_;
   ros::Subscriber sensor_sub_;
 
   std::string vis_topic_;
   std::string updated_topic_;
   std::string sensor_topic_;
+  std::string sensor_ack_topic_;
 
   // Frame in which to publish visualization.
   std::string fixed_frame_;
 
+  // Optional session recorder.
+  std::shared_ptr<SessionRecorder> recorder_;
+
+  // Whether sensor updates run on their own thread, with its queue and
+  // spinner.
+  bool concurrent_updates_;
+  std::unique_ptr<ros::CallbackQueue> update_queue_;
+  std::unique_ptr<ros::AsyncSpinner> update_spinner_;
+
+  // Held while incorporating a sensor update.
+  mutable std::mutex update_mutex_;
+
+  // Most recent snapshot. The snapshot mutex is only held to swap or read
+  // the pointer; copies are made under 'update_mutex_'.
+  mutable std::mutex snapshot_mutex_;
+  mutable std::shared_ptr<const Environment> snapshot_;
+
+  // Version counter.
+  std::atomic<unsigned int> version_;
+
   // Naming and initialization.
   std::string name_;
   bool initialized_;
@@ -145,11 +258,19 @@ bool Environment<M, P>::Initialize(const ros::NodeHandle& n) {
     return false;
   }
 
+  if (concurrent_updates_) update_queue_.reset(new ros::CallbackQueue);
+
   if (!RegisterCallbacks(n)) {
     ROS_ERROR("%s: Failed to register callbacks.", name_.c_str());
     return false;
   }
 
+  // Start integrating sensor updates on their own thread.
+  if (concurrent_updates_) {
+    update_spinner_.reset(new ros::AsyncSpinner(1, update_queue_.get()));
+    update_spinner_->start();
+  }
+
   // Visualize.
   Visualize();
 
@@ -168,6 +289,9 @@ bool Environment<M, P>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("topic/updated_env", updated_topic_)) return false;
   if (!nl.getParam("vis/env", vis_topic_)) return false;
 
+  // Optionally acknowledge each incorporated sensor message.
+  nl.getParam("topic/sensor_ack", sensor_ack_topic_);
+
   // Frame of reference to publish visualization in.
   if (!nl.getParam("frame/fixed", fixed_frame_)) return false;
 
@@ -180,6 +304,10 @@ bool Environment<M, P>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("env/lower/y", lower_(1))) return false;
   if (!nl.getParam("env/lower/z", lower_(2))) return false;
 
+  // Optionally integrate sensor updates on their own thread. Only enable
+  // this if everyone else reads the environment through snapshots.
+  nl.getParam("env/concurrent_updates", concurrent_updates_);
+
   return true;
 }
 
@@ -189,8 +317,10 @@ bool Environment<M, P>::RegisterCallbacks(const ros::NodeHandle& n) {
   ros::NodeHandle nl(n);
 
   // Subscribers.
-  sensor_sub_ = nl.subscribe(sensor_topic_.c_str(), 1,
-                             &Environment<M, P>::SensorCallback, this);
+  ros::NodeHandle nu = UpdateNodeHandle(n);
+  sensor_sub_ = nu.subscribe(sensor_topic_.c_str(), 1,
+                             &Environment<M, P>::RecordAndSensorCallback,
+                             this);
 
   // Publishers.
   vis_pub_ =
@@ -199,9 +329,55 @@ bool Environment<M, P>::RegisterCallbacks(const ros::NodeHandle& n) {
   updated_pub_ =
       nl.advertise<std_msgs::Empty>(updated_topic_.c_str(), 1, false);
 
+  if (!sensor_ack_topic_.empty())
+    sensor_ack_pub_ =
+        nl.advertise<std_msgs::Empty>(sensor_ack_topic_.c_str(), 1, false);
+
   return true;
 }
 
+// Immutable copy of this environment at the most recent version. The model
+// is copied at most once per version, and only when someone asks. E must be
+// the concrete type of this environment.
+template <typename M, typename P>
+template <typename E>
+std::shared_ptr<const E> Environment<M, P>::Snapshot() const {
+  static_assert(std::is_base_of<Environment<M, P>, E>::value,
+                "Snapshot type must be derived from this environment.");
+
+  std::shared_ptr<const Environment> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    snapshot = snapshot_;
+  }
+
+  if (snapshot && snapshot->Version() == Version())
+    return std::static_pointer_cast<const E>(snapshot);
+
+  // Stale (or no) snapshot. If an update is in progress, hand out the
+  // stale one rather than wait; the next request will pick up the change.
+  std::unique_lock<std::mutex> lock(update_mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    if (snapshot) return std::static_pointer_cast<const E>(snapshot);
+    lock.lock();
+  }
+
+  // Someone else may have refreshed it while we were checking.
+  {
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+    snapshot = snapshot_;
+  }
+
+  if (!snapshot || snapshot->Version() != Version()) {
+    snapshot.reset(new E(static_cast<const E&>(*this)));
+
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+    snapshot_ = snapshot;
+  }
+
+  return std::static_pointer_cast<const E>(snapshot);
+}
+
 }  //\namespace environment
 }  //\namespace fastrack
 
@@ -102,9 +102,9 @@ class OccupancyMap : public Environment<M, P> {
   virtual bool LoadParameters(const ros::NodeHandle& n);
 
   // Update this environment with the information contained in the given
-  // sensor measurement.
-  // NOTE! This function needs to publish on `updated_topic_`.
-  virtual void SensorCallback(const typename M::ConstPtr& msg) = 0;
+  // sensor measurement. Returns whether the model changed.
+  // NOTE! This function needs to publish on `updated_topic_` if so.
+  virtual bool SensorCallback(const typename M::ConstPtr& msg) = 0;
 
   // Occupancy probability threshold below which a point/region is considered
   // to be free space.
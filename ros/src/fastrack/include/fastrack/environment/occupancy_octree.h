@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// OccupancyOctree is a hierarchical occupancy map over a cube which encloses
+// the environment box. Every node is either a leaf with a single label
+// (unknown, free, or occupied) or has eight children. Each node also stores
+// the set of labels present anywhere in its subtree, and subtrees whose
+// leaves all share the same label are pruned to a single leaf. Large regions
+// of free space, unknown space, or obstacle interior therefore collapse to a
+// few nodes, and memory scales with the obstacle and sensor surfaces rather
+// than the volume.
+//
+// Queries for a tracking error bound descend only into nodes which the bound
+// overlaps and whose subtree is not already uniform, and may be limited to a
+// maximum depth, in which case the answer is conservative.
+//
+// Like CoarseOccupancyGrid, this class does not depend on ROS. It is filled
+// in by the environment which owns it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_ENVIRONMENT_OCCUPANCY_OCTREE_H
+#define FASTRACK_ENVIRONMENT_OCCUPANCY_OCTREE_H
+
+#include <fastrack/utils/types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace fastrack {
+namespace environment {
+
+class OccupancyOctree {
+ public:
+  // Leaf labels. These are bits so that a node can store the set of labels
+  // present in its subtree.
+  enum Label : uint8_t { UNKNOWN = 1, FREE = 2, OCCUPIED = 4 };
+
+  ~OccupancyOctree() {}
+  explicit OccupancyOctree(const Vector3d& lower, const Vector3d& upper,
+                           double resolution);
+
+  // Mark all leaves which touch the given sphere as occupied. Returns true
+  // if any leaf changed.
+  bool InsertOccupiedSphere(const Vector3d& center, double radius) {
+    return InsertSphere(kRoot, lower_, size_, 0, center, radius, OCCUPIED);
+  }
+
+  // Mark all leaves which lie entirely inside the given sphere as free,
+  // unless they are already occupied. Returns true if any leaf changed.
+  bool InsertFreeSphere(const Vector3d& center, double radius) {
+    return InsertSphere(kRoot, lower_, size_, 0, center, radius, FREE);
+  }
+
+  // Mark all unknown finest leaves which the segment from the origin to the
+  // endpoint passes through as free, and if the ray hit something mark the
+  // leaf containing the endpoint as occupied. Returns true if any leaf
+  // changed.
+  bool InsertRay(const Vector3d& origin, const Vector3d& endpoint, bool hit) {
+    bool changed =
+        InsertSegment(kRoot, lower_, size_, 0, origin, endpoint, hit);
+    if (hit) changed |= InsertOccupiedSphere(endpoint, 0.0);
+    return changed;
+  }
+
+  // Label of the leaf containing the given point. Points outside the octree
+  // are occupied.
+  Label Query(const Vector3d& p) const;
+
+  // Worst label (occupied, then unknown, then free) among all leaves which
+  // the bound B centered at the given point overlaps. Nodes at 'max_depth'
+  // are not refined further, so their subtree labels are used instead.
+  template <typename B>
+  Label Query(const Vector3d& p, const B& bound, size_t max_depth) const {
+    const uint8_t labels =
+        Collect(kRoot, lower_, size_, 0, p, bound, max_depth);
+    return WorstLabel(labels);
+  }
+  template <typename B>
+  Label Query(const Vector3d& p, const B& bound) const {
+    return Query(p, bound, max_depth_);
+  }
+
+  // Call f(lower, size, label) on every leaf which overlaps the given box.
+  template <typename F>
+  void ForEachLeaf(const Vector3d& lower, const Vector3d& upper,
+                   F f) const {
+    ForEachLeaf(kRoot, lower_, size_, lower, upper, f);
+  }
+
+  // Number of nodes currently in use, depth of the finest leaves, side
+  // length of the finest leaves.
+  size_t NumNodes() const { return nodes_.size() - kNumChildren * free_.size(); }
+  size_t MaxDepth() const { return max_depth_; }
+  double Resolution() const { return resolution_; }
+
+ private:
+  // Each node is either a leaf or the parent of eight consecutive children.
+  struct Node {
+    uint32_t children;
+    uint8_t labels;
+  };  //\struct Node
+
+  static constexpr uint32_t kRoot = 0;
+  static constexpr uint32_t kNoChildren = 0;
+  static constexpr size_t kNumChildren = 8;
+
+  // Worst label in a set of labels.
+  static Label WorstLabel(uint8_t labels) {
+    if (labels & OCCUPIED) return OCCUPIED;
+    if (labels & UNKNOWN) return UNKNOWN;
+    return (labels & FREE) ? FREE : UNKNOWN;
+  }
+
+  // Lower corner of the given child of a node.
+  static Vector3d ChildLower(const Vector3d& lower, double size,
+                             size_t child) {
+    const double half = 0.5 * size;
+    return lower + half * Vector3d(child & 1, (child >> 1) & 1,
+                                   (child >> 2) & 1);
+  }
+
+  // Sphere/box tests.
+  static bool SphereContainsBox(const Vector3d& center, double radius,
+                                const Vector3d& lower, const Vector3d& upper) {
+    const Vector3d farthest =
+        (lower - center).cwiseAbs().cwiseMax((upper - center).cwiseAbs());
+    return farthest.squaredNorm() < radius * radius;
+  }
+  static bool SphereOverlapsBox(const Vector3d& center, double radius,
+                                const Vector3d& lower, const Vector3d& upper) {
+    const Vector3d closest = center.cwiseMax(lower).cwiseMin(upper);
+    return (closest - center).squaredNorm() <= radius * radius;
+  }
+
+  // Slab test for the segment from 'a' to 'b' against a box.
+  static bool SegmentOverlapsBox(const Vector3d& a, const Vector3d& b,
+                                 const Vector3d& lower, const Vector3d& upper) {
+    double t_min = 0.0;
+    double t_max = 1.0;
+    for (size_t ii = 0; ii < 3; ii++) {
+      const double d = b(ii) - a(ii);
+      if (std::abs(d) < 1e-12) {
+        if (a(ii) < lower(ii) || a(ii) > upper(ii)) return false;
+        continue;
+      }
+
+      double t0 = (lower(ii) - a(ii)) / d;
+      double t1 = (upper(ii) - a(ii)) / d;
+      if (t0 > t1) std::swap(t0, t1);
+      t_min = std::max(t_min, t0);
+      t_max = std::min(t_max, t1);
+      if (t_min > t_max) return false;
+    }
+
+    return true;
+  }
+
+  // Recursive helpers.
+  bool InsertSphere(uint32_t idx, const Vector3d& lower, double size,
+                    size_t depth, const Vector3d& center, double radius,
+                    Label label);
+  bool InsertSegment(uint32_t idx, const Vector3d& lower, double size,
+                     size_t depth, const Vector3d& origin,
+                     const Vector3d& endpoint, bool hit);
+  template <typename B>
+  uint8_t Collect(uint32_t idx, const Vector3d& lower, double size,
+                  size_t depth, const Vector3d& p, const B& bound,
+                  size_t max_depth) const;
+  template <typename F>
+  void ForEachLeaf(uint32_t idx, const Vector3d& lower, double size,
+                   const Vector3d& query_lower, const Vector3d& query_upper,
+                   F& f) const;
+
+  // Turn a leaf into a parent of eight leaves with the same label, or turn
+  // a node into a leaf with the given label, releasing its descendants.
+  void Split(uint32_t idx);
+  void MakeLeaf(uint32_t idx, Label label);
+
+  // Recompute a parent's labels from its children, and prune it if all
+  // children are leaves with the same label.
+  void Merge(uint32_t idx);
+
+  // Lower corner and side length of the root cube, and leaf resolution.
+  const Vector3d lower_;
+  double size_;
+  const double resolution_;
+  size_t max_depth_;
+
+  // All nodes, and the first indices of released blocks of children.
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_;
+};  //\class OccupancyOctree
+
+// ---------------------------- IMPLEMENTATION  ---------------------------- //
+
+inline OccupancyOctree::OccupancyOctree(const Vector3d& lower,
+                                        const Vector3d& upper,
+                                        double resolution)
+    : lower_(lower), resolution_(resolution), max_depth_(0) {
+  if (resolution <= 0.0)
+    throw std::runtime_error("Octree resolution must be positive.");
+
+  // Smallest power-of-two multiple of the resolution which covers the box.
+  constexpr size_t kMaxDepth = 20;
+  const double extent = (upper - lower).maxCoeff();
+  size_ = resolution;
+  while (size_ < extent && max_depth_ < kMaxDepth) {
+    size_ *= 2.0;
+    max_depth_++;
+  }
+
+  nodes_.push_back({kNoChildren, UNKNOWN});
+}
+
+inline OccupancyOctree::Label OccupancyOctree::Query(const Vector3d& p) const {
+  if ((p.array() < lower_.array()).any() ||
+      (p.array() > lower_.array() + size_).any())
+    return OCCUPIED;
+
+  uint32_t idx = kRoot;
+  Vector3d lower = lower_;
+  double size = size_;
+  while (nodes_[idx].children != kNoChildren) {
+    size *= 0.5;
+    const size_t child = (p(0) >= lower(0) + size) +
+                         2 * (p(1) >= lower(1) + size) +
+                         4 * (p(2) >= lower(2) + size);
+    lower = ChildLower(lower, 2.0 * size, child);
+    idx = nodes_[idx].children + child;
+  }
+
+  return WorstLabel(nodes_[idx].labels);
+}
+
+inline bool OccupancyOctree::InsertSphere(uint32_t idx, const Vector3d& lower,
+                                          double size, size_t depth,
+                                          const Vector3d& center,
+                                          double radius, Label label) {
+  const Vector3d upper = lower + Vector3d::Constant(size);
+  if (!SphereOverlapsBox(center, radius, lower, upper)) return false;
+
+  // Nothing to do if the whole subtree already has the new label, or if
+  // marking free space and the subtree has no unknown space left.
+  const uint8_t labels = nodes_[idx].labels;
+  if (labels == label || (label == FREE && !(labels & UNKNOWN))) return false;
+
+  const bool contains = SphereContainsBox(center, radius, lower, upper);
+  if (label == OCCUPIED && (contains || depth == max_depth_)) {
+    MakeLeaf(idx, OCCUPIED);
+    return true;
+  }
+
+  if (label == FREE && nodes_[idx].children == kNoChildren) {
+    // A leaf here is unknown, so it becomes free if it is entirely inside
+    // the sphere. Partially covered finest leaves stay unknown.
+    if (contains) {
+      nodes_[idx].labels = FREE;
+      return true;
+    }
+
+    if (depth == max_depth_) return false;
+  }
+
+  if (nodes_[idx].children == kNoChildren) Split(idx);
+
+  bool changed = false;
+  for (size_t ii = 0; ii < kNumChildren; ii++) {
+    changed |= InsertSphere(nodes_[idx].children + ii,
+                            ChildLower(lower, size, ii), 0.5 * size,
+                            depth + 1, center, radius, label);
+  }
+
+  Merge(idx);
+  return changed;
+}
+
+inline bool OccupancyOctree::InsertSegment(uint32_t idx, const Vector3d& lower,
+                                           double size, size_t depth,
+                                           const Vector3d& origin,
+                                           const Vector3d& endpoint,
+                                           bool hit) {
+  const Vector3d upper = lower + Vector3d::Constant(size);
+  if (!SegmentOverlapsBox(origin, endpoint, lower, upper)) return false;
+
+  // Only unknown space is cleared, so skip subtrees without any.
+  if (!(nodes_[idx].labels & UNKNOWN)) return false;
+
+  if (depth == max_depth_) {
+    // Leave the leaf which the ray ended in for the occupied update.
+    if (hit && (endpoint.array() >= lower.array()).all() &&
+        (endpoint.array() <= upper.array()).all())
+      return false;
+
+    // Finest leaves are either unknown or fully labeled at this point.
+    nodes_[idx].labels = FREE;
+    return true;
+  }
+
+  if (nodes_[idx].children == kNoChildren) Split(idx);
+
+  bool changed = false;
+  for (size_t ii = 0; ii < kNumChildren; ii++) {
+    changed |= InsertSegment(nodes_[idx].children + ii,
+                             ChildLower(lower, size, ii), 0.5 * size,
+                             depth + 1, origin, endpoint, hit);
+  }
+
+  Merge(idx);
+  return changed;
+}
+
+inline void OccupancyOctree::Split(uint32_t idx) {
+  uint32_t first;
+  if (!free_.empty()) {
+    first = free_.back();
+    free_.pop_back();
+  } else {
+    first = static_cast<uint32_t>(nodes_.size());
+    nodes_.resize(nodes_.size() + kNumChildren);
+  }
+
+  for (size_t ii = 0; ii < kNumChildren; ii++)
+    nodes_[first + ii] = {kNoChildren, nodes_[idx].labels};
+
+  nodes_[idx].children = first;
+}
+
+inline void OccupancyOctree::MakeLeaf(uint32_t idx, Label label) {
+  const uint32_t first = nodes_[idx].children;
+  if (first != kNoChildren) {
+    for (size_t ii = 0; ii < kNumChildren; ii++)
+      MakeLeaf(first + ii, label);
+
+    free_.push_back(first);
+  }
+
+  nodes_[idx] = {kNoChildren, label};
+}
+
+inline void OccupancyOctree::Merge(uint32_t idx) {
+  const uint32_t first = nodes_[idx].children;
+
+  uint8_t labels = 0;
+  bool all_leaves = true;
+  for (size_t ii = 0; ii < kNumChildren; ii++) {
+    labels |= nodes_[first + ii].labels;
+    all_leaves &= nodes_[first + ii].children == kNoChildren;
+  }
+
+  // Prune if the children are leaves with a single label.
+  if (all_leaves && (labels & (labels - 1)) == 0) {
+    free_.push_back(first);
+    nodes_[idx] = {kNoChildren, labels};
+    return;
+  }
+
+  nodes_[idx].labels = labels;
+}
+
+template <typename B>
+uint8_t OccupancyOctree::Collect(uint32_t idx, const Vector3d& lower,
+                                 double size, size_t depth, const Vector3d& p,
+                                 const B& bound, size_t max_depth) const {
+  if (!bound.OverlapsBox(p, lower, lower + Vector3d::Constant(size)))
+    return 0;
+
+  // Stop at leaves, uniform subtrees, and the depth limit.
+  const Node& node = nodes_[idx];
+  if (node.children == kNoChildren || (node.labels & (node.labels - 1)) == 0 ||
+      depth >= max_depth)
+    return node.labels;
+
+  uint8_t labels = 0;
+  for (size_t ii = 0; ii < kNumChildren; ii++) {
+    labels |= Collect(node.children + ii, ChildLower(lower, size, ii),
+                      0.5 * size, depth + 1, p, bound, max_depth);
+
+    // Occupied is the worst case, so stop looking.
+    if (labels & OCCUPIED) break;
+  }
+
+  return labels;
+}
+
+template <typename F>
+void OccupancyOctree::ForEachLeaf(uint32_t idx, const Vector3d& lower,
+                                  double size, const Vector3d& query_lower,
+                                  const Vector3d& query_upper, F& f) const {
+  const Vector3d upper = lower + Vector3d::Constant(size);
+  if ((upper.array() < query_lower.array()).any() ||
+      (lower.array() > query_upper.array()).any())
+    return;
+
+  const Node& node = nodes_[idx];
+  if (node.children == kNoChildren) {
+    f(lower, size, WorstLabel(node.labels));
+    return;
+  }
+
+  for (size_t ii = 0; ii < kNumChildren; ii++) {
+    ForEachLeaf(node.children + ii, ChildLower(lower, size, ii), 0.5 * size,
+                query_lower, query_upper, f);
+  }
+}
+
+}  //\namespace environment
+}  //\namespace fastrack
+
+#endif
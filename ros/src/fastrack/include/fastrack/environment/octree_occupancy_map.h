@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// OctreeOccupancyMap is derived from OccupancyMap, and stores occupancy in
+// a multi-resolution OccupancyOctree rather than keeping every sensor
+// measurement. It consumes the same SensedSpheres measurements as
+// BallsInBoxOccupancyMap: leaves touching a sensed obstacle become occupied,
+// and leaves entirely inside the sensor field of view become free unless they
+// are already occupied. It is meant for large environments, where memory must
+// scale with obstacle surfaces rather than the volume of the environment box.
+//
+// Occupancy queries for a tracking error bound only descend the octree as far
+// as needed to decide the bound's footprint, optionally limited to a maximum
+// query depth. As in BallsInBoxOccupancyMap, they are also provided as
+// templates on the bound type.
+//
+// Optionally, the map also ingests SensedRays scans (e.g. from a RaySensor)
+// on a second topic, clearing unknown leaves along each ray and marking the
+// leaves which rays end in as occupied.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_ENVIRONMENT_OCTREE_OCCUPANCY_MAP_H
+#define FASTRACK_ENVIRONMENT_OCTREE_OCCUPANCY_MAP_H
+
+#include <fastrack/bound/box.h>
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/bound/sphere.h>
+#include <fastrack/environment/occupancy_map.h>
+#include <fastrack/environment/occupancy_octree.h>
+#include <fastrack/sensor/sphere_sensor_params.h>
+#include <fastrack_msgs/SensedRays.h>
+#include <fastrack_msgs/SensedSpheres.h>
+
+#include <memory>
+
+namespace fastrack {
+namespace environment {
+
+using sensor::SphereSensorParams;
+
+class OctreeOccupancyMap
+    : public OccupancyMap<fastrack_msgs::SensedSpheres, SphereSensorParams> {
+ public:
+  ~OctreeOccupancyMap() {}
+  explicit OctreeOccupancyMap()
+      : OccupancyMap<fastrack_msgs::SensedSpheres, SphereSensorParams>(),
+        resolution_(0.0),
+        max_query_depth_(0) {}
+
+  // Copy the map, e.g. for snapshots.
+  OctreeOccupancyMap(const OctreeOccupancyMap& other)
+      : OccupancyMap<fastrack_msgs::SensedSpheres, SphereSensorParams>(other),
+        resolution_(other.resolution_),
+        max_query_depth_(other.max_query_depth_),
+        rays_topic_(other.rays_topic_) {
+    if (other.octree_) octree_.reset(new OccupancyOctree(*other.octree_));
+  }
+
+  // Derived classes must provide an OccupancyProbability function for both
+  // single points and tracking error bounds centered on a point.
+  // Ignores time since this is a time-invariant environment.
+  double OccupancyProbability(
+      const Vector3d& p,
+      double time = std::numeric_limits<double>::quiet_NaN()) const;
+  // Known bound types are dispatched to their templated versions below.
+  double OccupancyProbability(
+      const Vector3d& p, const TrackingBound& bound,
+      double time = std::numeric_limits<double>::quiet_NaN()) const;
+
+  // Statically dispatched occupancy queries for a concrete bound type B.
+  template <typename B>
+  double OccupancyProbability(
+      const Vector3d& p, const B& bound,
+      double time = std::numeric_limits<double>::quiet_NaN()) const;
+  template <typename B>
+  bool IsValid(const Vector3d& position, const B& bound,
+               double time = std::numeric_limits<double>::quiet_NaN()) const {
+    return initialized_ &&
+           OccupancyProbability(position, bound, time) < free_space_threshold_;
+  }
+  template <typename B>
+  bool AreValid(const std::vector<Vector3d>& positions, const B& bound,
+                double time = std::numeric_limits<double>::quiet_NaN()) const {
+    for (const auto& p : positions) {
+      if (!IsValid(p, bound, time)) return false;
+    }
+
+    return true;
+  }
+
+  // Generate a sensor measurement. Reports every occupied leaf within range
+  // as the sphere circumscribing it.
+  fastrack_msgs::SensedSpheres SimulateSensor(
+      const SphereSensorParams& params) const;
+
+  // Derived classes must have some sort of visualization through RViz.
+  void Visualize() const;
+
+ protected:
+  // Load parameters. This may be overridden by derived classes if needed
+  // (they should still call this one via OccupancyMap::LoadParameters).
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Register callbacks.
+  bool RegisterCallbacks(const ros::NodeHandle& n);
+
+  // Update this environment with the information contained in the given
+  // sensor measurement. Returns whether the model changed.
+  // NOTE! This function needs to publish on `updated_topic_` if so.
+  bool SensorCallback(
+      const typename fastrack_msgs::SensedSpheres::ConstPtr& msg);
+
+  // Incorporate a ray-cast scan. Returns whether the model changed, and also
+  // publishes on `updated_topic_` if so.
+  bool RaysCallback(const fastrack_msgs::SensedRays::ConstPtr& msg);
+
+  // Record and acknowledge scans just like sensor messages.
+  void RecordAndRaysCallback(const fastrack_msgs::SensedRays::ConstPtr& msg) {
+    RecordAndIncorporate(RAYS, *msg, [this, &msg]() {
+      return RaysCallback(msg);
+    });
+  }
+
+  // Convert an octree label to an occupancy probability.
+  static double LabelProbability(OccupancyOctree::Label label) {
+    switch (label) {
+      case OccupancyOctree::OCCUPIED:
+        return kOccupiedProbability;
+      case OccupancyOctree::FREE:
+        return kFreeProbability;
+      default:
+        return kUnknownProbability;
+    }
+  }
+
+  // Leaf resolution and maximum depth to which bound queries descend.
+  double resolution_;
+  size_t max_query_depth_;
+
+  // Octree over the environment box.
+  std::unique_ptr<OccupancyOctree> octree_;
+
+  // Optional subscriber for ray-cast scans.
+  ros::Subscriber rays_sub_;
+  std::string rays_topic_;
+
+  // Static constants for occupied/unknown/free probabilities.
+  static constexpr double kOccupiedProbability = 1.0;
+  static constexpr double kUnknownProbability = 0.5;
+  static constexpr double kFreeProbability = 0.0;
+};  //\class OctreeOccupancyMap
+
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+// Occupancy probability for a tracking error bound centered at the given
+// point. Occupancy is set to occupied if ANY of the bound is occupied. Next,
+// if ANY of the bound is unknown the result is unknown. Otherwise, free.
+template <typename B>
+double OctreeOccupancyMap::OccupancyProbability(const Vector3d& p,
+                                                const B& bound,
+                                                double time) const {
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check without initializing.",
+             name_.c_str());
+    return kOccupiedProbability;
+  }
+
+  // Check box limits.
+  if (!bound.ContainedWithinBox(p, lower_, upper_)) return kOccupiedProbability;
+
+  return LabelProbability(octree_->Query(p, bound, max_query_depth_));
+}
+
+}  //\namespace environment
+}  //\namespace fastrack
+
+#endif
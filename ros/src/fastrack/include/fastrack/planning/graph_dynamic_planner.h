@@ -41,6 +41,19 @@
 // guaranteed to generate recursively feasible trajectories constructed
 // using sampling-based logic.
 //
+// Optionally, the graph keeps growing in a background thread between
+// replanning requests, against the latest environment snapshot, so that most
+// of each request's budget is left for extracting a trajectory. Background
+// expansion pauses as soon as a request arrives, after at most one sample.
+//
+// If the goal changes between requests, the graph is kept and only goal
+// connectivity is rebuilt, starting with direct connections from existing
+// nodes near the new goal.
+//
+// Also optionally, the heuristic used to pick nodes to explore is a coarse
+// cost-to-go field over known free space rather than distance to the goal,
+// so exploration does not head into dead ends behind obstacles.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_PLANNING_GRAPH_DYNAMIC_PLANNER_H
@@ -49,9 +62,14 @@
 #include <fastrack/dynamics/dynamics.h>
 #include <fastrack/planning/planner.h>
 #include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/cost_to_go_field.h>
 #include <fastrack/utils/searchable_set.h>
 #include <fastrack/utils/types.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -129,20 +147,55 @@ template <typename S, typename E, typename D, typename SD, typename B,
           typename SB>
 class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
  public:
-  virtual ~GraphDynamicPlanner() {}
+  virtual ~GraphDynamicPlanner() { StopExpansion(); }
 
  protected:
-  explicit GraphDynamicPlanner() : Planner<S, E, D, SD, B, SB>(), rng_(rd_()) {}
+  explicit GraphDynamicPlanner()
+      : Planner<S, E, D, SD, B, SB>(),
+        rng_(rd_()),
+        use_cost_to_go_(false),
+        cost_to_go_resolution_(0.5),
+        cost_to_go_version_(0),
+        background_expansion_(false),
+        expanding_in_background_(false),
+        pause_expansion_(false),
+        stop_expansion_(false) {}
 
   // Load parameters.
   virtual bool LoadParameters(const ros::NodeHandle& n);
   virtual bool RegisterCallbacks(const ros::NodeHandle& n);
 
+  // Seed random number generators, including the one used for exploration.
+  virtual void Seed(unsigned int seed) {
+    Planner<S, E, D, SD, B, SB>::Seed(seed);
+    rng_.seed(seed);
+  }
+
+  // Pause background expansion while serving a replanning request. The
+  // first request sets up the graph, after which expansion starts.
+  bool ReplanServer(fastrack_srvs::ReplanRequest& req,
+                    fastrack_srvs::ReplanResponse& res);
+
   // Plan a trajectory from the given start to goal states starting
   // at the given time.
   Trajectory<S> Plan(const S& start, const S& goal,
                      double start_time = 0.0) const;
 
+  // Background expansion loop, and a function to stop it. Derived classes
+  // whose SubPlan uses their own members should stop expansion in their
+  // destructors.
+  void ExpansionLoop();
+  void StopExpansion();
+
+  // Whether to keep growing the graph: until the planning budget is spent,
+  // or in the background, until a request arrives.
+  bool KeepExpanding(double initial_call_time) const {
+    if (expanding_in_background_ && (pause_expansion_ || stop_expansion_))
+      return false;
+
+    return ros::Time::now().toSec() - initial_call_time < this->max_runtime_;
+  }
+
   // Generate a sub-plan that connects two states and is dynamically feasible
   // (but not necessarily recursively feasible).
   virtual Trajectory<S> SubPlan(const S& start, const S& goal,
@@ -156,16 +209,23 @@ class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
     return traj.Duration();
   }
 
-  // Heuristic function. Defaults to distance between state and goal.
+  // Heuristic function. Defaults to distance between state and goal, or
+  // to the cost-to-go field if enabled and the goal is in free space.
   virtual double Heuristic(const S& state) const {
     if (!goal_node_) {
       ROS_ERROR("%s: Goal node was null.", this->name_.c_str());
       return constants::kInfinity;
     }
 
+    if (cost_to_go_ && cost_to_go_->HasGoal())
+      return cost_to_go_->Value(state.Position());
+
     return (state.ToVector() - goal_node_->state.ToVector()).norm();
   }
 
+  // Bring the cost-to-go field up to date with the planning environment.
+  void UpdateCostToGo() const;
+
   // Node in implicit planning graph, templated on state type.
   // NOTE! To avoid memory leaks, Nodes are constructed using a static
   // factory method that returns a shared pointer.
@@ -186,6 +246,10 @@ class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
     Node::Ptr best_home_child = nullptr;
     Node::Ptr best_goal_child = nullptr;
     std::vector<Node::Ptr> parents;
+
+    // Trajectories to children, with times relative to this node, i.e.
+    // starting at 0. Absolute times live only on nodes, so retiming a
+    // subtree never touches these.
     std::unordered_map<Node::Ptr, Trajectory<S>> trajs_to_children;
 
     // Factory methods.
@@ -219,8 +283,22 @@ class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
   // node the new trajectory should start from.
   Trajectory<S> ExtractTrajectory() const;
 
-  // Update cost to come, best parent, time, and all traj_to_child times
-  // recursively.
+  // Create a goal node for the given state.
+  typename Node::Ptr CreateGoalNode(const S& goal) const;
+
+  // Switch to a new goal, keeping the graph. Clears all goal connectivity,
+  // retires the old goal to an ordinary node, and connects existing nodes
+  // near the new goal to it within the planning budget.
+  void RetargetGoal(const S& goal, double initial_call_time) const;
+
+  // Whether the given node has neither a way to the goal nor home. This can
+  // only happen to nodes which relied on a retired goal.
+  bool IsStranded(const typename Node::Ptr& node) const {
+    return node != goal_node_ && !node->best_goal_child &&
+           std::isinf(node->cost_to_home);
+  }
+
+  // Update cost to come, best parent, and time recursively.
   // NOTE: this will never get into an infinite loop because eventually
   // every node will know its best option and reject further updates.
   void UpdateDescendants(const typename Node::Ptr& node) const;
@@ -239,12 +317,22 @@ class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
   size_t num_neighbors_;
   double search_radius_;
 
+  // Approximate search settings for the graph. Exact by default.
+  NeighborSearchParams search_params_;
+
   // Epsilon greedy exploration parameter. This is the probability of sampling
   // a random (viable!) state to visit.
   double epsilon_greedy_;
   mutable std::random_device rd_;
   mutable std::default_random_engine rng_;
 
+  // Optional cost-to-go field for the heuristic, its cell size, and the
+  // environment version it was last classified against.
+  bool use_cost_to_go_;
+  double cost_to_go_resolution_;
+  mutable std::unique_ptr<CostToGoField> cost_to_go_;
+  mutable unsigned int cost_to_go_version_;
+
   // Unordered set storing nodes that we have not yet visited.
   mutable std::unordered_set<typename Node::Ptr> nodes_to_visit_;
 
@@ -272,10 +360,91 @@ class GraphDynamicPlanner : public Planner<S, E, D, SD, B, SB> {
   std::string fixed_frame_;
 
   mutable Colormap colormap_;
+
+  // Background expansion. The graph mutex is held by whoever is growing the
+  // graph, and 'expanding_in_background_' is only touched under it.
+  bool background_expansion_;
+  bool expanding_in_background_;
+  std::atomic<bool> pause_expansion_;
+  std::atomic<bool> stop_expansion_;
+  std::mutex graph_mutex_;
+  std::condition_variable expansion_cv_;
+  std::thread expansion_thread_;
 };  //\class GraphDynamicPlanner
 
 // ----------------------------- IMPLEMENTATION ----------------------------- //
 
+// Pause background expansion while serving a replanning request. The
+// first request sets up the graph, after which expansion starts.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+bool GraphDynamicPlanner<S, E, D, SD, B, SB>::ReplanServer(
+    fastrack_srvs::ReplanRequest& req, fastrack_srvs::ReplanResponse& res) {
+  // Resumes background expansion when it goes out of scope, so that an
+  // exception from planning cannot leave expansion paused forever.
+  struct ResumeExpansion {
+    GraphDynamicPlanner<S, E, D, SD, B, SB>* planner;
+    ~ResumeExpansion() {
+      planner->pause_expansion_ = false;
+      planner->expansion_cv_.notify_one();
+    }
+  };  //\struct ResumeExpansion
+
+  // Background expansion checks this flag once per sample, so we only wait
+  // for the sample in progress.
+  pause_expansion_ = true;
+  bool success = false;
+  {
+    std::unique_lock<std::mutex> lock(graph_mutex_);
+    const ResumeExpansion resume = {this};
+    success = Planner<S, E, D, SD, B, SB>::ReplanServer(req, res);
+  }
+
+  if (background_expansion_ && !expansion_thread_.joinable()) {
+    expansion_thread_ = std::thread(
+        &GraphDynamicPlanner<S, E, D, SD, B, SB>::ExpansionLoop, this);
+  }
+
+  return success;
+}
+
+// Background expansion loop. Grows the graph in slices of one planning
+// budget each, picking up the latest environment snapshot for every slice.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+void GraphDynamicPlanner<S, E, D, SD, B, SB>::ExpansionLoop() {
+  std::unique_lock<std::mutex> lock(graph_mutex_);
+  while (!stop_expansion_) {
+    // Wait for any request in flight.
+    expansion_cv_.wait(
+        lock, [this]() { return stop_expansion_ || !pause_expansion_; });
+    if (stop_expansion_) break;
+
+    this->env_snapshot_ = this->env_.template Snapshot<E>();
+    expanding_in_background_ = true;
+    RecursivePlan(ros::Time::now().toSec(), true);
+    expanding_in_background_ = false;
+    this->env_snapshot_.reset();
+  }
+}
+
+// Stop background expansion, if running.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+void GraphDynamicPlanner<S, E, D, SD, B, SB>::StopExpansion() {
+  if (!expansion_thread_.joinable()) return;
+
+  stop_expansion_ = true;
+  {
+    // Make sure the loop is either expanding (and will see the flag) or
+    // waiting (and will be notified).
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+  }
+
+  expansion_cv_.notify_one();
+  expansion_thread_.join();
+}
+
 // Plan a trajectory from the given start to goal states starting
 // at the given time.o
 template <typename S, typename E, typename D, typename SD, typename B,
@@ -285,24 +454,17 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::Plan(
   // Keep track of initial time.
   const double initial_call_time = ros::Time::now().toSec();
 
-  // Set up goal node.
+  // Set up goal node, or retarget if the goal has changed.
   if (!goal_node_) {
-    goal_node_ = Node::Create();
-    goal_node_->state = goal;
-    goal_node_->time = constants::kInfinity;
-    goal_node_->cost_to_come = constants::kInfinity;
-    goal_node_->cost_to_home = constants::kInfinity;
-    goal_node_->cost_to_goal = 0.0;
-    goal_node_->is_viable = true;
-    goal_node_->is_visited = false;
-  } else {
-    // Make sure the goal has not changed.
-    if (!goal_node_->state.ToVector().isApprox(goal.ToVector(),
-                                               constants::kEpsilon)) {
-      throw std::runtime_error("Oops. Goal changed.");
-    }
+    goal_node_ = CreateGoalNode(goal);
+  } else if (!goal_node_->state.ToVector().isApprox(goal.ToVector(),
+                                                    constants::kEpsilon)) {
+    RetargetGoal(goal, initial_call_time);
   }
 
+  // Refresh the heuristic before any exploration decisions.
+  if (use_cost_to_go_) UpdateCostToGo();
+
   // Set a start node as null. This will end up either being:
   // (1) the home node, if we don't have one yet, OR
   // (2) the node in traj_nodes immediately after the start_time.
@@ -329,7 +491,7 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::Plan(
     home_node->is_visited = true;
     home_node->time = 0.0;
 
-    home_set_.reset(new SearchableSet<Node, S>(home_node));
+    home_set_.reset(new SearchableSet<Node, S>(home_node, search_params_));
     start_node = home_node;
 
     // Update colormap.
@@ -356,12 +518,13 @@ template <typename S, typename E, typename D, typename SD, typename B,
 Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
     double initial_call_time, bool outbound) const {
   // Loop until we run out of time.
-  while (ros::Time::now().toSec() - initial_call_time < this->max_runtime_) {
+  while (KeepExpanding(initial_call_time)) {
     // (1) Sample a new point.
     const S sample = S::Sample();
 
     // Reject this sample if it's not in known free space.
-    if (!this->env_.AreValid(sample.OccupiedPositions(), this->bound_))
+    if (!this->PlanningEnv().AreValid(
+          sample.OccupiedPositions(), this->bound_))
       continue;
 
     // Check the home set for nearest neighbors and connect.
@@ -401,8 +564,11 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
       // Update colormap.
       colormap_.UpdateTimes(sample_node->time);
 
-      // Update parent.
-      neighboring_parent->trajs_to_children.emplace(sample_node, sub_plan);
+      // Update parent. Edges are stored relative to their source node.
+      Trajectory<S> edge = sub_plan;
+      edge.ResetFirstTime(0.0);
+      neighboring_parent->trajs_to_children.emplace(sample_node,
+                                                    std::move(edge));
 
       // Set parent to neighboring parent and get of here.
       parent = neighboring_parent;
@@ -437,7 +603,8 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
       }
 
       // Check if goal is in known free space.
-      if (!this->env_.AreValid(goal->state.OccupiedPositions(), this->bound_)) {
+      if (!this->PlanningEnv().AreValid(
+            goal->state.OccupiedPositions(), this->bound_)) {
         ROS_INFO_THROTTLE(1.0, "%s: Goal was not in known free space.",
                           this->name_.c_str());
         continue;
@@ -462,7 +629,9 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
       goal->parents.push_back(sample_node);
 
       // Update sample node to point to child.
-      sample_node->trajs_to_children.emplace(child, sub_plan);
+      Trajectory<S> edge = sub_plan;
+      edge.ResetFirstTime(0.0);
+      sample_node->trajs_to_children.emplace(child, std::move(edge));
       sample_node->is_viable = true;
 
       // Add this guy to 'nodes_to_visit_'.
@@ -509,7 +678,8 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
       // goal set to the start node. Be sure to set the correct start time.
       // NOTE: this will automatically set traj_nodes and traj_node_times.
       // Else, return a dummy trajectory since it will be ignored anyway.
-      if (outbound) {
+      // Background expansion never extracts, since that advances the plan.
+      if (outbound && !expanding_in_background_) {
         return ExtractTrajectory();
       } else {
         return Trajectory<S>();
@@ -517,6 +687,9 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::RecursivePlan(
     }
   }
 
+  // Background expansion was paused.
+  if (expanding_in_background_) return Trajectory<S>();
+
   // Ran out of time.
   ROS_ERROR("%s: Planner ran out of time.", this->name_.c_str());
 
@@ -578,6 +751,10 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::ExtractTrajectory()
     const size_t lo = hi - 1;
     hi = std::max(hi, explore_node_idx_);
 
+    // After a goal change, stay on the previous plan until the first node
+    // which still has a way to the goal or home.
+    while (hi + 1 < traj_nodes_.size() && IsStranded(traj_nodes_[hi])) hi++;
+
     // Remove all nodes up to and including previous node from nodes to visit,
     // and also be sure to mark them as visited.
     for (size_t ii = 0; ii <= lo; ii++) {
@@ -611,9 +788,15 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::ExtractTrajectory()
         std::max(0, static_cast<int>(explore_node_idx_) - static_cast<int>(lo));
   }
 
-  // If we are connected to the goal (i.e. we have a best goal child),
-  // then just follow best goal child all the way there!
-  if (start_node->best_goal_child) {
+  // If the previous plan ends at a retired goal and never regains a way out,
+  // finish it. Staying at a goal is safe.
+  // Otherwise, if we are connected to the goal (i.e. we have a best goal
+  // child), then just follow best goal child all the way there!
+  if (IsStranded(start_node)) {
+    ROS_WARN("%s: Finishing previous plan to the old goal.",
+             this->name_.c_str());
+    nodes.push_back(start_node);
+  } else if (start_node->best_goal_child) {
     nodes.push_back(start_node);
     for (auto node = start_node; node->cost_to_goal > 0.0;
          node = node->best_goal_child) {
@@ -721,12 +904,101 @@ Trajectory<S> GraphDynamicPlanner<S, E, D, SD, B, SB>::ExtractTrajectory()
   if (nodes_iter != nodes.end())
     throw std::runtime_error("Incorrect number of nodes.");
 
-  // Concatenate into a single trajectory and set initial time.
+  // Concatenate into a single trajectory and set initial time. This is the
+  // only place edges get absolute times.
   Trajectory<S> traj(trajs);
   traj.ResetFirstTime(first_traj_time);
   return traj;
 }
 
+// Create a goal node for the given state.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+typename GraphDynamicPlanner<S, E, D, SD, B, SB>::Node::Ptr
+GraphDynamicPlanner<S, E, D, SD, B, SB>::CreateGoalNode(const S& goal) const {
+  typename Node::Ptr goal_node = Node::Create();
+  goal_node->state = goal;
+  goal_node->time = constants::kInfinity;
+  goal_node->cost_to_come = constants::kInfinity;
+  goal_node->cost_to_home = constants::kInfinity;
+  goal_node->cost_to_goal = 0.0;
+  goal_node->is_viable = true;
+  goal_node->is_visited = false;
+  return goal_node;
+}
+
+// Switch to a new goal, keeping the graph. Clears all goal connectivity,
+// retires the old goal to an ordinary node, and connects existing nodes
+// near the new goal to it within the planning budget.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+void GraphDynamicPlanner<S, E, D, SD, B, SB>::RetargetGoal(
+    const S& goal, double initial_call_time) const {
+  ROS_INFO("%s: Goal changed. Keeping the graph.", this->name_.c_str());
+
+  // Retire the old goal. It stays in the graph, and new samples may now
+  // connect from it if it was ever reached.
+  const typename Node::Ptr old_goal = goal_node_;
+  old_goal->cost_to_goal = constants::kInfinity;
+  if (home_set_ && !std::isinf(old_goal->cost_to_come))
+    home_set_->Insert(old_goal);
+
+  goal_node_ = CreateGoalNode(goal);
+  if (cost_to_go_ && !cost_to_go_->SetGoal(goal.Position()))
+    ROS_WARN("%s: Goal is outside the cost-to-go field.", this->name_.c_str());
+
+  if (!home_set_) return;
+
+  // Walk the graph and clear goal connectivity. Nodes are only viable now
+  // if they have a way home.
+  std::unordered_set<typename Node::Ptr> visited_nodes;
+  std::list<typename Node::Ptr> nodes_to_expand({home_set_->InitialNode()});
+  while (!nodes_to_expand.empty()) {
+    const auto current_node = nodes_to_expand.front();
+    nodes_to_expand.pop_front();
+    if (!visited_nodes.insert(current_node).second) continue;
+
+    current_node->cost_to_goal = constants::kInfinity;
+    current_node->best_goal_child = nullptr;
+    current_node->is_viable = !std::isinf(current_node->cost_to_home);
+    if (!current_node->is_viable) nodes_to_visit_.erase(current_node);
+
+    for (const auto& child_traj_pair : current_node->trajs_to_children)
+      nodes_to_expand.push_back(child_traj_pair.first);
+  }
+
+  // Connect existing nodes near the new goal directly.
+  if (!this->PlanningEnv().AreValid(goal.OccupiedPositions(), this->bound_))
+    return;
+
+  for (const auto& node : home_set_->KnnSearch(goal, num_neighbors_)) {
+    if (!KeepExpanding(initial_call_time)) break;
+
+    const Trajectory<S> sub_plan = SubPlan(node->state, goal, node->time);
+    if (sub_plan.Size() == 0 ||
+        !CheckTrajectoryEndpoints(sub_plan, node->state, goal))
+      continue;
+
+    // Add an edge to the goal, as in RecursivePlan.
+    Trajectory<S> edge = sub_plan;
+    edge.ResetFirstTime(0.0);
+    const double cost = Cost(edge);
+    node->trajs_to_children.emplace(goal_node_, std::move(edge));
+    goal_node_->parents.push_back(node);
+
+    node->is_viable = true;
+    if (!node->is_visited) nodes_to_visit_.emplace(node);
+
+    UpdateDescendants(node);
+
+    if (cost < node->cost_to_goal) {
+      node->cost_to_goal = cost;
+      node->best_goal_child = goal_node_;
+      UpdateAncestorsOnGoal(node);
+    }
+  }
+}
+
 // Load parameters.
 template <typename S, typename E, typename D, typename SD, typename B,
           typename SB>
@@ -742,6 +1014,13 @@ bool GraphDynamicPlanner<S, E, D, SD, B, SB>::LoadParameters(
   if (!nl.getParam("num_neighbors", k)) return false;
   num_neighbors_ = static_cast<size_t>(k);
 
+  // Optional approximate search settings.
+  double eps = search_params_.eps;
+  nl.getParam("search/trees", search_params_.num_trees);
+  nl.getParam("search/checks", search_params_.checks);
+  nl.getParam("search/eps", eps);
+  search_params_.eps = static_cast<float>(eps);
+
   // Visualization parameters.
   if (!nl.getParam("vis/graph", vis_topic_)) return false;
   if (!nl.getParam("frame/fixed", fixed_frame_)) return false;
@@ -749,9 +1028,47 @@ bool GraphDynamicPlanner<S, E, D, SD, B, SB>::LoadParameters(
   // Epsilon for epsilon-greedy exploration.
   if (!nl.getParam("epsilon_greedy", epsilon_greedy_)) return false;
 
+  // Optionally keep growing the graph between requests.
+  nl.getParam("background_expansion", background_expansion_);
+
+  // Optional cost-to-go heuristic.
+  nl.getParam("heuristic/cost_to_go", use_cost_to_go_);
+  nl.getParam("heuristic/resolution", cost_to_go_resolution_);
+
   return true;
 }
 
+// Bring the cost-to-go field up to date with the planning environment. The
+// first call sets the goal and solves the field from scratch. Later calls
+// only re-classify cells if the environment has changed, and only repair
+// the part of the field those changes affect.
+template <typename S, typename E, typename D, typename SD, typename B,
+          typename SB>
+void GraphDynamicPlanner<S, E, D, SD, B, SB>::UpdateCostToGo() const {
+  const E& env = this->PlanningEnv();
+  const auto is_free = [this, &env](const Vector3d& p) {
+    return env.IsValid(p, this->bound_);
+  };
+
+  if (!cost_to_go_) {
+    cost_to_go_.reset(new CostToGoField(S::GetLower().Position(),
+                                        S::GetUpper().Position(),
+                                        cost_to_go_resolution_));
+    cost_to_go_->Classify(is_free);
+    cost_to_go_version_ = env.Version();
+
+    if (!cost_to_go_->SetGoal(goal_node_->state.Position()))
+      ROS_WARN("%s: Goal is outside the cost-to-go field.",
+               this->name_.c_str());
+    return;
+  }
+
+  if (env.Version() == cost_to_go_version_) return;
+
+  cost_to_go_->Classify(is_free);
+  cost_to_go_version_ = env.Version();
+}
+
 // Register callbacks.
 template <typename S, typename E, typename D, typename SD, typename B,
           typename SB>
@@ -884,8 +1201,7 @@ void GraphDynamicPlanner<S, E, D, SD, B, SB>::Visualize() const {
   vis_pub_.publish(lines);
 }
 
-// Update cost to come, best parent, time, and all traj_to_child times
-// recursively.
+// Update cost to come, best parent, and time recursively.
 // NOTE: this will never get into an infinite loop because eventually
 // every node will know its best option and reject further updates.
 template <typename S, typename E, typename D, typename SD, typename B,
@@ -903,12 +1219,9 @@ void GraphDynamicPlanner<S, E, D, SD, B, SB>::UpdateDescendants(
 
     // Loop over all children and add to queue if this node is their
     // NEW best parent.
-    for (auto& child_traj_pair : current_node->trajs_to_children) {
+    for (const auto& child_traj_pair : current_node->trajs_to_children) {
       auto& child = child_traj_pair.first;
-      auto& traj_to_child = child_traj_pair.second;
-
-      // Update trajectory to child.
-      traj_to_child.ResetFirstTime(current_node->time);
+      const auto& traj_to_child = child_traj_pair.second;
 
       // Maybe update child's best parent to be the current node.
       // If so, also update time and cost to come.
@@ -39,6 +39,15 @@
 // OMPL kinematic planner wrapper, templated on the state type and the specific
 // type of OMPL planner to be used under the hood.
 //
+// Optionally, the planner may be run as a portfolio: several planner instances
+// (alternating between P and RRTConnect, each with its own random seed) race
+// on separate threads against a shared validity checker. Either the first
+// solution found or the best (hybridized) solution at the deadline is used.
+//
+// Solutions may also be post-processed before timing: redundant waypoints are
+// removed and the path is shortcut, with every new segment collision-checked
+// against the environment under the tracking bound.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_PLANNING_OMPL_KINEMATIC_PLANNER_H
@@ -50,12 +59,14 @@
 #include <ompl/geometric/planners/rrt/RRTConnect.h>
 
 #include <ompl/base/SpaceInformation.h>
+#include <ompl/util/RandomNumbers.h>
 #include <ompl/base/TypedSpaceInformation.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/geometric/PathSimplifier.h>
 #include <ompl/geometric/SimpleSetup.h>
+#include <ompl/tools/multiplan/ParallelPlan.h>
 
-#include <ompl/geometric/planners/bitstar/BITstar.h>
-#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <cstdint>
 
 namespace fastrack {
 namespace planning {
@@ -67,12 +78,30 @@ template <typename P, typename S, typename E, typename B, typename SB>
 class OmplKinematicPlanner : public KinematicPlanner<S, E, B, SB> {
  public:
   ~OmplKinematicPlanner() {}
-  explicit OmplKinematicPlanner() : KinematicPlanner<S, E, B, SB>() {
+  explicit OmplKinematicPlanner()
+      : KinematicPlanner<S, E, B, SB>(),
+        portfolio_size_(1),
+        portfolio_first_solution_(true),
+        simplify_(false),
+        simplify_runtime_(0.0),
+        solve_runtime_(0.0) {
     // Set OMPL log level.
     ompl::msg::setLogLevel(ompl::msg::LogLevel::LOG_ERROR);
   }
 
  private:
+  // Load parameters.
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Seed random number generators, including OMPL's.
+  // NOTE! OMPL only respects this if no OMPL planner has sampled yet, and
+  // does not accept a seed of zero. So every seed (zero included) is shifted
+  // by one before handing it to OMPL.
+  void Seed(unsigned int seed) {
+    KinematicPlanner<S, E, B, SB>::Seed(seed);
+    ompl::RNG::setSeed(static_cast<std::uint_fast64_t>(seed) + 1);
+  }
+
   // Plan a trajectory from the given start to goal states starting
   // at the given time.
   // NOTE! The states in the output trajectory are essentially configurations.
@@ -81,10 +110,78 @@ class OmplKinematicPlanner : public KinematicPlanner<S, E, B, SB> {
 
   // Convert between OMPL states and configurations.
   S FromOmplState(const ob::State* state) const;
+
+  // Solve with a portfolio of planners racing on separate threads.
+  ob::PlannerStatus SolvePortfolio(og::SimpleSetup& ompl_setup) const;
+
+  // Shortcut and remove redundant waypoints from the given path in place.
+  // Returns false (and leaves the path untouched) if the result is invalid.
+  bool SimplifyPath(const ob::SpaceInformationPtr& si,
+                    og::PathGeometric& path) const;
+
+  // Convert an OMPL path to a Trajectory, timing each segment with the
+  // best possible time under the planner dynamics.
+  Trajectory<S> ToTrajectory(const og::PathGeometric& path,
+                             double start_time) const;
+
+  // Number of planner instances (threads) in the portfolio. A size of 1
+  // disables the portfolio and runs a single P on the calling thread.
+  size_t portfolio_size_;
+
+  // If true, stop as soon as any planner finds an exact solution. Otherwise,
+  // run all planners until the deadline and hybridize their solutions.
+  bool portfolio_first_solution_;
+
+  // Should we post-process solutions, and for how long (s) at most?
+  bool simplify_;
+  double simplify_runtime_;
+
+  // Time (s) left for the solver, i.e. the planning budget minus any time
+  // reserved for post-processing.
+  double solve_runtime_;
 };  //\class KinematicPlanner
 
 // ---------------------------- IMPLEMENTATION ------------------------------ //
 
+// Load parameters.
+template <typename P, typename S, typename E, typename B, typename SB>
+bool OmplKinematicPlanner<P, S, E, B, SB>::LoadParameters(
+    const ros::NodeHandle& n) {
+  if (!KinematicPlanner<S, E, B, SB>::LoadParameters(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Portfolio parameters are optional; default to a single planner.
+  int size = 1;
+  if (nl.getParam("portfolio/size", size) && size < 1) {
+    ROS_ERROR("%s: Portfolio size must be positive.", this->name_.c_str());
+    return false;
+  }
+
+  portfolio_size_ = static_cast<size_t>(size);
+  nl.getParam("portfolio/first_solution", portfolio_first_solution_);
+
+  // Post-processing is also optional and off by default.
+  // If no time limit is given, spend at most a tenth of the planning budget.
+  nl.getParam("simplify/enabled", simplify_);
+  if (!nl.getParam("simplify/max_runtime", simplify_runtime_))
+    simplify_runtime_ = 0.1 * this->max_runtime_;
+
+  // Post-processing comes out of the planning budget, not on top of it.
+  solve_runtime_ = this->max_runtime_;
+  if (simplify_) {
+    if (simplify_runtime_ < 0.0 || simplify_runtime_ >= this->max_runtime_) {
+      ROS_ERROR("%s: Simplification runtime must be in [0, max_runtime).",
+                this->name_.c_str());
+      return false;
+    }
+
+    solve_runtime_ -= simplify_runtime_;
+  }
+
+  return true;
+}
+
 // Convert between OMPL states and configurations.
 template <typename P, typename S, typename E, typename B, typename SB>
 S OmplKinematicPlanner<P, S, E, B, SB>::FromOmplState(
@@ -115,12 +212,12 @@ Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::Plan(
   const VectorXd goal_config = goal.Configuration();
 
   // Check that both start and stop are in bounds.
-  if (!this->env_.AreValid(start.OccupiedPositions(), this->bound_)) {
+  if (!this->AreValid(start.OccupiedPositions())) {
     ROS_WARN_THROTTLE(1.0, "Start point was in collision or out of bounds.");
     return Trajectory<S>();
   }
 
-  if (!this->env_.AreValid(goal.OccupiedPositions(), this->bound_)) {
+  if (!this->AreValid(goal.OccupiedPositions())) {
     ROS_WARN_THROTTLE(1.0, "Goal point was in collision or out of bounds.");
     return Trajectory<S>();
   }
@@ -142,10 +239,12 @@ Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::Plan(
   ompl_space->setBounds(ompl_bounds);
 
   // Create a SimpleSetup instance and set the state validity checker function.
+  // NOTE! This checker is shared by all threads in portfolio mode. It only
+  // reads from the environment and bound (and the validity cache is
+  // lock-free), so it is safe to call concurrently.
   og::SimpleSetup ompl_setup(ompl_space);
   ompl_setup.setStateValidityChecker([&](const ob::State* state) {
-    return this->env_.AreValid(FromOmplState(state).OccupiedPositions(),
-                               this->bound_);
+    return this->AreValid(FromOmplState(state).OccupiedPositions());
   });
 
   // Set the start and goal states.
@@ -163,7 +262,9 @@ Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::Plan(
   ompl_setup.setPlanner(ompl_planner);
 
   // Solve. Parameter is the amount of time (in seconds) used by the solver.
-  const ob::PlannerStatus solved = ompl_setup.solve(this->max_runtime_);
+  const ob::PlannerStatus solved = (portfolio_size_ > 1)
+                                       ? SolvePortfolio(ompl_setup)
+                                       : ompl_setup.solve(solve_runtime_);
 
   if (!solved) {
     ROS_WARN("OMPL Planner could not compute a solution.");
@@ -172,15 +273,66 @@ Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::Plan(
 
   // Unpack the solution and assign timestamps.
   const og::PathGeometric& solution = ompl_setup.getSolutionPath();
+  const Trajectory<S> raw = ToTrajectory(solution, start_time);
+  if (!simplify_) return raw;
+
+  // Post-process a copy of the solution, and report how much we saved.
+  og::PathGeometric path(solution);
+  if (!SimplifyPath(ompl_setup.getSpaceInformation(), path)) {
+    ROS_WARN("%s: Simplified path was invalid. Using raw solution.",
+             this->name_.c_str());
+    return raw;
+  }
+
+  const Trajectory<S> traj = ToTrajectory(path, start_time);
+  ROS_INFO("%s: Simplification removed %zu of %zu states and %f of %f s.",
+           this->name_.c_str(), raw.Size() - traj.Size(), raw.Size(),
+           raw.Duration() - traj.Duration(), raw.Duration());
+
+  return traj;
+}
+
+// Shortcut and remove redundant waypoints from the given path in place.
+// Returns false (and leaves the path untouched) if the result is invalid.
+template <typename P, typename S, typename E, typename B, typename SB>
+bool OmplKinematicPlanner<P, S, E, B, SB>::SimplifyPath(
+    const ob::SpaceInformationPtr& si, og::PathGeometric& path) const {
+  og::PathGeometric simplified(path);
+  og::PathSimplifier simplifier(si);
+
+  // Alternate between waypoint reduction and shortcutting until neither one
+  // makes progress or we run out of time. All new segments are checked by the
+  // motion validator, i.e. against the environment under the tracking bound.
+  const ros::Time deadline =
+      ros::Time::now() + ros::Duration(simplify_runtime_);
+  bool progress = true;
+  while (progress && ros::Time::now() < deadline) {
+    progress = simplifier.reduceVertices(simplified);
+    progress |= simplifier.shortcutPath(simplified);
+  }
+
+  // Drop any waypoints that are (nearly) coincident.
+  simplifier.collapseCloseVertices(simplified);
 
+  if (!simplified.check()) return false;
+
+  path = simplified;
+  return true;
+}
+
+// Convert an OMPL path to a Trajectory, timing each segment with the
+// best possible time under the planner dynamics.
+template <typename P, typename S, typename E, typename B, typename SB>
+Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::ToTrajectory(
+    const og::PathGeometric& path, double start_time) const {
   // Populate the Trajectory with states and time stamps.
   // NOTE! These states are essentially just configurations.
   std::vector<S> states;
   std::vector<double> times;
 
   double time = start_time;
-  for (size_t ii = 0; ii < solution.getStateCount(); ii++) {
-    const S state = FromOmplState(solution.getState(ii));
+  for (size_t ii = 0; ii < path.getStateCount(); ii++) {
+    const S state = FromOmplState(path.getState(ii));
 
     // Increment time by the duration it takes us to get from the previous
     // configuration to this one.
@@ -193,6 +345,40 @@ Trajectory<S> OmplKinematicPlanner<P, S, E, B, SB>::Plan(
   return Trajectory<S>(states, times);
 }
 
+// Solve with a portfolio of planners racing on separate threads.
+template <typename P, typename S, typename E, typename B, typename SB>
+ob::PlannerStatus OmplKinematicPlanner<P, S, E, B, SB>::SolvePortfolio(
+    og::SimpleSetup& ompl_setup) const {
+  ompl_setup.setup();
+
+  const ob::SpaceInformationPtr& si = ompl_setup.getSpaceInformation();
+  const ob::ProblemDefinitionPtr& pdef = ompl_setup.getProblemDefinition();
+
+  // Alternate between the primary planner and RRTConnect, which is usually
+  // quickest to find a first solution. Every instance has its own RNG, so
+  // repeated instances of the same planner explore differently.
+  ompl::tools::ParallelPlan portfolio(pdef);
+  portfolio.addPlanner(ompl_setup.getPlanner());
+  for (size_t ii = 1; ii < portfolio_size_; ii++) {
+    ob::PlannerPtr planner;
+    if (ii % 2 == 1)
+      planner.reset(new og::RRTConnect(si));
+    else
+      planner.reset(new P(si));
+
+    planner->setProblemDefinition(pdef);
+    portfolio.addPlanner(planner);
+  }
+
+  // Either return as soon as one planner succeeds, or wait for the deadline
+  // and combine all solutions found into the best hybrid path.
+  if (portfolio_first_solution_)
+    return portfolio.solve(solve_runtime_, 1, portfolio_size_, false);
+
+  return portfolio.solve(solve_runtime_, portfolio_size_,
+                         portfolio_size_, true);
+}
+
 }  //\namespace planning
 }  //\namespace fastrack
 
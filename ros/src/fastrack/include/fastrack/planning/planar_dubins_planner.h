@@ -73,7 +73,7 @@ class PlanarDubinsPlanner
                                  fastrack_srvs::PlanarDubinsPlannerDynamics, B,
                                  SB> {
  public:
-  ~PlanarDubinsPlanner() {}
+  ~PlanarDubinsPlanner() { this->StopExpansion(); }
   explicit PlanarDubinsPlanner()
       : GraphDynamicPlanner<PlanarDubins3D, E, PlanarDubinsDynamics3D,
                             fastrack_srvs::PlanarDubinsPlannerDynamics, B,
@@ -126,8 +126,7 @@ Trajectory<PlanarDubins3D> PlanarDubinsPlanner<E, B, SB>::SubPlan(
   // Set up OMPL solver.
   og::SimpleSetup ompl_setup(space);
   ompl_setup.setStateValidityChecker([&](const ob::State* state) {
-    return this->env_.AreValid(FromOmplState(state).OccupiedPositions(),
-                               this->bound_);
+    return this->AreValid(FromOmplState(state).OccupiedPositions());
   });
 
   ompl_setup.setStartAndGoalStates(ompl_start, ompl_goal);
@@ -51,7 +51,9 @@
 
 #include <fastrack/environment/environment.h>
 #include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/session_log.h>
 #include <fastrack/utils/types.h>
+#include <fastrack/utils/validity_cache.h>
 
 #include <fastrack_srvs/Replan.h>
 #include <fastrack_srvs/ReplanRequest.h>
@@ -59,7 +61,10 @@
 #include <fastrack_msgs/Trajectory.h>
 
 #include <ros/ros.h>
+#include <std_msgs/UInt32.h>
 #include <visualization_msgs/Marker.h>
+#include <memory>
+#include <random>
 
 namespace fastrack {
 namespace planning {
@@ -78,7 +83,10 @@ public:
 
 protected:
   explicit Planner()
-    : initialized_(false) {}
+    : seed_(0),
+      cache_resolution_(0.0),
+      cache_size_(1 << 18),
+      initialized_(false) {}
 
   // Load parameters and register callbacks. These may be overridden
   // by derived classes if needed (they should still call these functions
@@ -86,18 +94,39 @@ protected:
   virtual bool LoadParameters(const ros::NodeHandle& n);
   virtual bool RegisterCallbacks(const ros::NodeHandle& n);
 
-  // Callback to handle replanning requests.
-  inline bool ReplanServer(
+  // Seed all random number generators used in planning. This may be
+  // overridden by derived classes with their own generators (they should
+  // still call this function via Planner::Seed).
+  virtual void Seed(unsigned int seed) { S::Seed(seed); }
+
+  // Callback to handle replanning requests. This may be overridden by
+  // derived classes (they should still call this one via
+  // Planner::ReplanServer).
+  virtual bool ReplanServer(
     fastrack_srvs::ReplanRequest& req, fastrack_srvs::ReplanResponse& res) {
+    if (recorder_) recorder_->Record(REPLAN_REQUEST, req.req);
+
     // Unpack start/stop states.
     const S start(req.req.start);
     const S goal(req.req.goal);
 
-    // Plan.
+    // Plan against a consistent snapshot of the environment, which sensor
+    // updates arriving in the meantime do not touch.
+    env_snapshot_ = env_.template Snapshot<E>();
     const Trajectory<S> traj = Plan(start, goal, req.req.start_time);
-
-    // Return whether or not planning was successful.
-    res.traj = traj.ToRos();
+    env_snapshot_.reset();
+
+    // Report validity cache hit rate for this plan.
+    if (validity_cache_) {
+      ROS_INFO("%s: Validity cache hit rate %f over %zu checks.",
+               name_.c_str(), validity_cache_->HitRate(),
+               validity_cache_->NumQueries());
+      validity_cache_->ResetStats();
+    }
+
+    // Return whether or not planning was successful. Write straight into the
+    // response in the packed layout, which is cheap to fill and serialize.
+    traj.ToPackedRos(&res.traj);
     return traj.Size() > 0;
   }
 
@@ -106,11 +135,24 @@ protected:
   virtual Trajectory<S> Plan(
     const S& start, const S& goal, double start_time=0.0) const = 0;
 
+  // Collision check the given positions against the environment with our
+  // bound, going through the validity cache if enabled.
+  bool AreValid(const std::vector<Vector3d>& positions) const;
+
+  // Environment to collision check against: the snapshot for the current
+  // plan if there is one, otherwise the live environment.
+  const E& PlanningEnv() const {
+    return env_snapshot_ ? *env_snapshot_ : env_;
+  }
+
   // Keep a copy of the dynamics, tracking bound, and environment.
   D dynamics_;
   B bound_;
   E env_;
 
+  // Snapshot of the environment for the plan in progress.
+  std::shared_ptr<const E> env_snapshot_;
+
   // Max amount of time for planning to run each time.
   double max_runtime_;
 
@@ -129,6 +171,22 @@ protected:
   std::string dynamics_srv_name_;
   std::string bound_srv_name_;
 
+  // Random seed. Loaded from the optional "seed" parameter, or else drawn at
+  // random, so that it can always be recorded.
+  unsigned int seed_;
+
+  // Optional session recorder.
+  std::shared_ptr<SessionRecorder> recorder_;
+  std::string record_file_;
+
+  // Optional validity cache, with its cell size (zero to disable) and
+  // number of slots. Cell results are checked at the cell center against
+  // the tracking bound inflated to cover the whole cell.
+  std::unique_ptr<ValidityCache> validity_cache_;
+  B cell_bound_;
+  double cache_resolution_;
+  int cache_size_;
+
   // Naming and initialization.
   std::string name_;
   bool initialized_;
@@ -152,6 +210,19 @@ bool Planner<S, E, D, SD, B, SB>::Initialize(const ros::NodeHandle& n) {
     return false;
   }
 
+  // Open session recorder and hook up the environment before it starts
+  // listening for sensor messages.
+  if (!record_file_.empty()) {
+    recorder_.reset(new SessionRecorder);
+    if (!recorder_->Open(record_file_)) {
+      ROS_ERROR("%s: Could not open session log %s.", name_.c_str(),
+                record_file_.c_str());
+      return false;
+    }
+
+    env_.SetRecorder(recorder_);
+  }
+
   // Initialize environment.
   if (!env_.Initialize(n)) {
     ROS_ERROR("%s: Failed to initialize environment.", name_.c_str());
@@ -171,6 +242,7 @@ bool Planner<S, E, D, SD, B, SB>::Initialize(const ros::NodeHandle& n) {
   }
 
   bound_.FromRos(b.response);
+  if (recorder_) recorder_->Record(BOUND, b.response);
 
   // Set dynamics by calling service provided by tracker.
   if (!dynamics_srv_) {
@@ -185,10 +257,36 @@ bool Planner<S, E, D, SD, B, SB>::Initialize(const ros::NodeHandle& n) {
   }
 
   dynamics_.FromRos(d.response);
+  if (recorder_) recorder_->Record(DYNAMICS, d.response);
+
+  // Seed random number generators. This happens after the bound and dynamics
+  // services respond, so that whoever provides them (e.g. a session replayer)
+  // has a chance to set the seed parameter first.
+  ros::NodeHandle nl(n);
+  int seed = 0;
+  if (nl.getParam("seed", seed))
+    seed_ = static_cast<unsigned int>(seed);
+  else
+    seed_ = std::random_device()();
+
+  Seed(seed_);
+  if (recorder_) {
+    std_msgs::UInt32 s;
+    s.data = seed_;
+    recorder_->Record(SEED, s);
+  }
 
   // Set configuration space bounds.
   S::SetBounds(state_lower_, state_upper_);
 
+  // Create validity cache.
+  if (cache_resolution_ > 0.0) {
+    validity_cache_.reset(new ValidityCache(
+      cache_resolution_, static_cast<size_t>(cache_size_)));
+    cell_bound_ = bound_;
+    cell_bound_.Inflate(0.5 * cache_resolution_);
+  }
+
   initialized_ = true;
   return true;
 }
@@ -211,6 +309,13 @@ bool Planner<S, E, D, SD, B, SB>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("state/lower", state_lower_)) return false;
   if (!nl.getParam("state/upper", state_upper_)) return false;
 
+  // Session log file is optional. If not provided, do not record.
+  nl.getParam("record/file", record_file_);
+
+  // Validity cache is optional.
+  nl.getParam("validity_cache/resolution", cache_resolution_);
+  nl.getParam("validity_cache/size", cache_size_);
+
   return true;
 }
 
@@ -233,6 +338,31 @@ bool Planner<S, E, D, SD, B, SB>::RegisterCallbacks(const ros::NodeHandle& n) {
   return true;
 }
 
+// Collision check the given positions against the environment with our
+// bound, going through the validity cache if enabled.
+template<typename S, typename E,
+         typename D, typename SD, typename B, typename SB>
+bool Planner<S, E, D, SD, B, SB>::AreValid(
+  const std::vector<Vector3d>& positions) const {
+  const E& env = PlanningEnv();
+  if (!validity_cache_) return env.AreValid(positions, bound_);
+
+  // A valid cell clears every position inside it. Otherwise, fall back to
+  // checking the exact position.
+  const unsigned int version = env.Version();
+  for (const auto& p : positions) {
+    bool cell_valid;
+    if (!validity_cache_->Lookup(p, version, &cell_valid)) {
+      cell_valid = env.IsValid(validity_cache_->CellCenter(p), cell_bound_);
+      validity_cache_->Insert(p, version, cell_valid);
+    }
+
+    if (!cell_valid && !env.IsValid(p, bound_)) return false;
+  }
+
+  return true;
+}
+
 } //\namespace planning
 } //\namespace fastrack
 
@@ -45,19 +45,37 @@
 // derived classes may add further functionality such as receding
 // horizon planning.
 //
+// Optionally, the PlannerManager learns the distribution of observed replan
+// latencies and uses a high quantile of it (rather than the fixed planner
+// runtime) as the lead time for each request. It may also replan proactively
+// before the current trajectory runs out.
+//
+// A mission may queue further waypoints after the goal. Once the current
+// trajectory reaches its goal (within a tolerance), the next leg is requested
+// from the predicted end state of the current one while the vehicle is still
+// flying, and the result is spliced onto the end of the current trajectory.
+// Legs which do not start where the current trajectory ends are rejected and
+// requested again. Since consumers of the planner's raw output would only
+// see the new leg, the PlannerManager optionally republishes the trajectory
+// it is actually following, e.g. for a tracker.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_PLANNING_PLANNER_MANAGER_H
 #define FASTRACK_PLANNING_PLANNER_MANAGER_H
 
 #include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/quantile_estimator.h>
 #include <fastrack/utils/types.h>
 #include <fastrack/utils/uncopyable.h>
 
 #include <fastrack_msgs/ReplanRequest.h>
+#include <fastrack_msgs/TracedState.h>
 
 #include <ros/ros.h>
 #include <visualization_msgs/Marker.h>
+#include <deque>
+#include <list>
 #include <std_msgs/Empty.h>
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/TransformStamped.h>
@@ -76,11 +94,23 @@ public:
     : ready_(false),
       waiting_for_traj_(false),
       serviced_updated_env_(false),
+      adaptive_runtime_(false),
+      latency_quantile_(0.99),
+      latency_margin_(0.0),
+      replan_horizon_(0.0),
+      goal_tolerance_(0.1),
+      splice_tolerance_(0.05),
+      waiting_for_next_leg_(false),
       initialized_(false) {}
 
   // Initialize this class with all parameters and callbacks.
   bool Initialize(const ros::NodeHandle& n);
 
+  // Does the given trajectory end within 'tolerance' (m) of the given goal?
+  // The goal is interpreted as an S, so only its position is compared.
+  static bool ReachesGoal(const Trajectory<S>& traj,
+                          const fastrack_msgs::State& goal, double tolerance);
+
 protected:
   // Load parameters and register callbacks. These may be overridden, however
   // derived classes should still call these functions.
@@ -93,6 +123,11 @@ protected:
   // classes with more specific replanning needs.
   virtual void MaybeRequestTrajectory();
 
+  // If not already waiting, request the next leg of the mission. It starts
+  // from the final state of the current trajectory, at its final time (or as
+  // soon as the planner can return, if that is later).
+  void MaybeRequestNextLeg();
+
   // Callback for applying tracking controller. This may be overridden, however
   // derived classes should still call thhis function.
   virtual void TimerCallback(const ros::TimerEvent& e);
@@ -100,21 +135,63 @@ protected:
   // Create and publish a marker at goal state.
   virtual void VisualizeGoal() const ;
 
+  // How far in the future should the next requested trajectory start?
+  // This is either the fixed planner runtime or, if adaptive, a high quantile
+  // of recently observed replan latencies.
+  double StartTimeLead() const;
+
+  // Does the current trajectory end at the goal, within 'goal_tolerance_'?
+  bool TrajectoryReachesGoal() const;
+
+  // Publish the current trajectory, if anyone asked for it, carrying over
+  // the latency trace of the message it came from.
+  void PublishTrajectory(const fastrack_msgs::Trajectory& source);
+
   // Callback for processing trajectory updates.
   inline void TrajectoryCallback(const fastrack_msgs::Trajectory::ConstPtr& msg) {
+    // Record how long this replan took.
+    if (waiting_for_traj_)
+      replan_latency_.Add((ros::Time::now() - request_time_).toSec());
+
+    const bool next_leg = waiting_for_next_leg_;
     waiting_for_traj_ = false;
+    waiting_for_next_leg_ = false;
 
     // Catch failure (empty msg).
-    if (msg->states.empty() || msg->times.empty()) {
+    if (msg->times.empty()) {
       ROS_WARN_THROTTLE(1.0, "%s: Received empty trajectory.", name_.c_str());
       return;
     }
 
+    // Splice the next leg of the mission onto the current trajectory.
+    if (next_leg) {
+      if (SpliceNextLeg(Trajectory<S>(msg))) {
+        traj_origin_ = TrajectoryOrigin(*msg);
+        PublishTrajectory(*msg);
+      }
+
+      return;
+    }
+
+    // Warn if the new trajectory should already have started.
+    if (msg->times.front() < ros::Time::now().toSec()) {
+      ROS_WARN_THROTTLE(1.0, "%s: Trajectory arrived %f s late.",
+                        name_.c_str(),
+                        ros::Time::now().toSec() - msg->times.front());
+    }
+
     // Update current trajectory and visualize.
     traj_ = Trajectory<S>(msg);
+    traj_origin_ = TrajectoryOrigin(*msg);
     traj_.Visualize(traj_vis_pub_, fixed_frame_);
+    PublishTrajectory(*msg);
   }
 
+  // Append the next leg of the mission to the current trajectory and advance
+  // the goal to the next waypoint. Returns false (and leaves everything as
+  // is) if the leg does not start where the current trajectory ends.
+  bool SpliceNextLeg(const Trajectory<S>& leg);
+
   // Is the system ready?
   inline void ReadyCallback(const std_msgs::Empty::ConstPtr& msg) {
     ready_ = true;
@@ -126,12 +203,35 @@ protected:
     MaybeRequestTrajectory();
   }
 
-  // Current trajectory.
+  // Latency tracing origin of the given trajectory: its replanning request,
+  // or else right now.
+  static ros::Time TrajectoryOrigin(const fastrack_msgs::Trajectory& msg) {
+    return (msg.origin.isZero()) ? ros::Time::now() : msg.origin;
+  }
+
+  // Current trajectory, and the latency tracing origin of the most recent
+  // trajectory behind it.
   Trajectory<S> traj_;
+  ros::Time traj_origin_;
 
   // Planner runtime -- how long does it take for the planner to run.
   double planner_runtime_;
 
+  // Adaptive planner runtime. If enabled, once enough replans have been
+  // observed the start time lead is the given quantile of recent replan
+  // latencies plus a fixed margin (s).
+  bool adaptive_runtime_;
+  double latency_quantile_;
+  double latency_margin_;
+  QuantileEstimator replan_latency_;
+
+  // When was the outstanding replan request sent?
+  ros::Time request_time_;
+
+  // Replan proactively when the current trajectory ends within this many
+  // seconds (beyond the start time lead). Non-positive disables this.
+  double replan_horizon_;
+
   // Are we waiting for a new trajectory?
   bool waiting_for_traj_;
 
@@ -142,6 +242,17 @@ protected:
   fastrack_msgs::State start_;
   fastrack_msgs::State goal_;
 
+  // How close (m) must the trajectory end to the goal to count as reaching
+  // it, and how close must a mission leg start to the end of the current
+  // trajectory to be spliced on?
+  double goal_tolerance_;
+  double splice_tolerance_;
+
+  // Remaining mission waypoints after the current goal, and are we waiting
+  // for the next leg of the mission (rather than a replan of this one)?
+  std::deque<fastrack_msgs::State> mission_;
+  bool waiting_for_next_leg_;
+
   // Set a recurring timer for a discrete-time controller.
   ros::Timer timer_;
   double time_step_;
@@ -149,17 +260,21 @@ protected:
   // Publishers/subscribers and related topics.
   ros::Publisher goal_pub_;
   ros::Publisher ref_pub_;
+  ros::Publisher traced_ref_pub_;
   ros::Publisher replan_request_pub_;
   ros::Publisher traj_vis_pub_;
+  ros::Publisher current_traj_pub_;
   ros::Subscriber traj_sub_;
   ros::Subscriber ready_sub_;
   ros::Subscriber updated_env_sub_;
 
   std::string goal_topic_;
   std::string ref_topic_;
+  std::string traced_ref_topic_;
   std::string replan_request_topic_;
   std::string traj_vis_topic_;
   std::string traj_topic_;
+  std::string current_traj_topic_;
   std::string ready_topic_;
   std::string updated_env_topic_;
 
@@ -215,6 +330,12 @@ bool PlannerManager<S>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("vis/traj", traj_vis_topic_)) return false;
   if (!nl.getParam("vis/goal", goal_topic_)) return false;
 
+  // Optionally republish the trajectory being followed.
+  nl.getParam("topic/current_traj", current_traj_topic_);
+
+  // Optionally publish references with latency tracing, on their own topic.
+  nl.getParam("topic/traced_ref", traced_ref_topic_);
+
   // Frames.
   if (!nl.getParam("frame/fixed", fixed_frame_)) return false;
   if (!nl.getParam("frame/planner", planner_frame_)) return false;
@@ -227,6 +348,43 @@ bool PlannerManager<S>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("start", start_.x)) return false;
   if (!nl.getParam("goal", goal_.x)) return false;
 
+  // Adaptive runtime and proactive replanning are optional.
+  nl.getParam("adaptive/enabled", adaptive_runtime_);
+  nl.getParam("adaptive/quantile", latency_quantile_);
+  nl.getParam("adaptive/margin", latency_margin_);
+  nl.getParam("replan_horizon", replan_horizon_);
+
+  // Tolerances are optional.
+  nl.getParam("goal_tolerance", goal_tolerance_);
+  nl.getParam("mission/splice_tolerance", splice_tolerance_);
+
+  // Mission waypoints are optional, and stacked into a single list.
+  std::vector<double> mission;
+  if (nl.getParam("mission", mission)) {
+    const size_t dimension = goal_.x.size();
+    if (dimension == 0 || mission.size() % dimension != 0) {
+      ROS_ERROR("%s: Mission must be a list of %zu-dimensional waypoints.",
+                name_.c_str(), dimension);
+      return false;
+    }
+
+    for (size_t ii = 0; ii < mission.size(); ii += dimension) {
+      fastrack_msgs::State waypoint;
+      waypoint.x.assign(mission.begin() + ii, mission.begin() + ii + dimension);
+      mission_.push_back(waypoint);
+    }
+  }
+
+  int window = 0;
+  if (nl.getParam("adaptive/window", window)) {
+    if (window <= 0) {
+      ROS_ERROR("%s: Adaptive window must be positive.", name_.c_str());
+      return false;
+    }
+
+    replan_latency_ = QuantileEstimator(static_cast<size_t>(window));
+  }
+
   return true;
 }
 
@@ -248,6 +406,10 @@ bool PlannerManager<S>::RegisterCallbacks(const ros::NodeHandle& n) {
   // Publishers.
   ref_pub_ = nl.advertise<fastrack_msgs::State>(ref_topic_.c_str(), 1, false);
 
+  if (!traced_ref_topic_.empty())
+    traced_ref_pub_ = nl.advertise<fastrack_msgs::TracedState>(
+      traced_ref_topic_.c_str(), 1, false);
+
   replan_request_pub_ = nl.advertise<fastrack_msgs::ReplanRequest>(
     replan_request_topic_.c_str(), 1, false);
 
@@ -257,6 +419,10 @@ bool PlannerManager<S>::RegisterCallbacks(const ros::NodeHandle& n) {
   traj_vis_pub_ = nl.advertise<visualization_msgs::Marker>(
     traj_vis_topic_.c_str(), 1, false);
 
+  if (!current_traj_topic_.empty())
+    current_traj_pub_ = nl.advertise<fastrack_msgs::Trajectory>(
+      current_traj_topic_.c_str(), 1, false);
+
   // Timer.
   timer_ = nl.createTimer(ros::Duration(time_step_),
     &PlannerManager<S>::TimerCallback, this);
@@ -283,7 +449,10 @@ void PlannerManager<S>::MaybeRequestTrajectory() {
   msg.goal = goal_;
 
   // Set start time.
-  msg.start_time = ros::Time::now().toSec() + planner_runtime_;
+  request_time_ = ros::Time::now();
+  msg.start_time = request_time_.toSec() + StartTimeLead();
+  msg.origin = request_time_;
+  msg.trace.push_back(request_time_);
 
   // Reset start state for future state if we have a current trajectory.
   if (traj_.Size() > 0) {
@@ -303,6 +472,72 @@ void PlannerManager<S>::MaybeRequestTrajectory() {
   serviced_updated_env_ = true;
 }
 
+// If not already waiting, request the next leg of the mission. It starts
+// from the final state of the current trajectory, at its final time (or as
+// soon as the planner can return, if that is later).
+template<typename S>
+void PlannerManager<S>::MaybeRequestNextLeg() {
+  if (!ready_ || waiting_for_traj_ || mission_.empty() || traj_.Size() == 0)
+    return;
+
+  // Start from the predicted end state of the current leg.
+  fastrack_msgs::ReplanRequest msg;
+  msg.start = traj_.LastState().ToRos();
+  msg.goal = mission_.front();
+
+  request_time_ = ros::Time::now();
+  msg.start_time =
+    std::max(traj_.LastTime(), request_time_.toSec() + StartTimeLead());
+  msg.origin = request_time_;
+  msg.trace.push_back(request_time_);
+
+  // Publish request and set flags.
+  replan_request_pub_.publish(msg);
+  waiting_for_traj_ = true;
+  waiting_for_next_leg_ = true;
+}
+
+// Append the next leg of the mission to the current trajectory and advance
+// the goal to the next waypoint. Returns false (and leaves everything as is)
+// if the leg does not start where the current trajectory ends.
+template<typename S>
+bool PlannerManager<S>::SpliceNextLeg(const Trajectory<S>& leg) {
+  if (mission_.empty()) {
+    ROS_WARN("%s: Received a mission leg with no mission.", name_.c_str());
+    return false;
+  }
+
+  // Some planners ignore the requested start state, so make sure the leg
+  // actually continues the current trajectory. If not, the timer will ask
+  // again.
+  if (traj_.Size() > 0) {
+    const double gap =
+      (leg.FirstState().Position() - traj_.LastState().Position()).norm();
+    if (gap > splice_tolerance_) {
+      ROS_WARN("%s: Mission leg starts %f m from the end of the current "
+               "trajectory. Rejecting it.", name_.c_str(), gap);
+      return false;
+    }
+  }
+
+  // If the leg starts no later than the current trajectory ends, splice it
+  // directly onto the end. Otherwise the vehicle is already holding at the
+  // end of the current trajectory, so just switch over.
+  if (traj_.Size() > 0 && leg.FirstTime() <= traj_.LastTime()) {
+    const std::list< Trajectory<S> > legs = { traj_, leg };
+    traj_ = Trajectory<S>(legs);
+  } else {
+    traj_ = leg;
+  }
+
+  goal_ = mission_.front();
+  mission_.pop_front();
+
+  traj_.Visualize(traj_vis_pub_, fixed_frame_);
+  VisualizeGoal();
+  return true;
+}
+
 // Callback for applying tracking controller.
 template<typename S>
 void PlannerManager<S>::TimerCallback(const ros::TimerEvent& e) {
@@ -318,6 +553,20 @@ void PlannerManager<S>::TimerCallback(const ros::TimerEvent& e) {
     ROS_INFO_THROTTLE(1.0, "%s: Servicing old updated environment callback.",
                       name_.c_str());
     MaybeRequestTrajectory();
+  } else if (replan_horizon_ > 0.0 && !TrajectoryReachesGoal() &&
+             traj_.LastTime() - ros::Time::now().toSec() <
+                 StartTimeLead() + replan_horizon_) {
+    // Current trajectory is about to run out, so replan ahead of time. If
+    // the last replan did not help, wait about as long as a replan takes
+    // before trying again rather than requesting on every tick.
+    if ((ros::Time::now() - request_time_).toSec() >= StartTimeLead())
+      MaybeRequestTrajectory();
+  } else if (!mission_.empty() && TrajectoryReachesGoal()) {
+    // This leg is planned, so plan the next one while it is flown. If the
+    // last leg was rejected, wait about as long as a replan takes before
+    // asking again.
+    if ((ros::Time::now() - request_time_).toSec() >= StartTimeLead())
+      MaybeRequestNextLeg();
   }
 
   // Interpolate the current trajectory.
@@ -326,6 +575,15 @@ void PlannerManager<S>::TimerCallback(const ros::TimerEvent& e) {
   // Convert to ROS msg and publish.
   ref_pub_.publish(planner_x.ToRos());
 
+  // Optionally also publish it traced back to the trajectory's origin.
+  if (!traced_ref_topic_.empty()) {
+    fastrack_msgs::TracedState ref;
+    ref.state = planner_x.ToRos();
+    ref.origin = traj_origin_;
+    ref.trace.push_back(ros::Time::now());
+    traced_ref_pub_.publish(ref);
+  }
+
   // Broadcast transform.
   geometry_msgs::TransformStamped tf;
   tf.header.frame_id = fixed_frame_;
@@ -343,6 +601,53 @@ void PlannerManager<S>::TimerCallback(const ros::TimerEvent& e) {
   tf_broadcaster_.sendTransform(tf);
 }
 
+// How far in the future should the next requested trajectory start?
+// This is either the fixed planner runtime or, if adaptive, a high quantile
+// of recently observed replan latencies.
+template<typename S>
+double PlannerManager<S>::StartTimeLead() const {
+  // Minimum number of observed replans before we trust the estimate.
+  constexpr size_t kMinSamples = 10;
+
+  if (!adaptive_runtime_ || replan_latency_.Size() < kMinSamples)
+    return planner_runtime_;
+
+  return replan_latency_.Quantile(latency_quantile_) + latency_margin_;
+}
+
+// Does the current trajectory end at the goal, within 'goal_tolerance_'?
+template<typename S>
+bool PlannerManager<S>::TrajectoryReachesGoal() const {
+  return ReachesGoal(traj_, goal_, goal_tolerance_);
+}
+
+// Does the given trajectory end within 'tolerance' (m) of the given goal?
+template<typename S>
+bool PlannerManager<S>::ReachesGoal(const Trajectory<S>& traj,
+                                    const fastrack_msgs::State& goal,
+                                    double tolerance) {
+  if (traj.Size() == 0) return false;
+
+  return (S(goal).Position() - traj.LastState().Position()).norm() <=
+    tolerance;
+}
+
+// Publish the current trajectory, if anyone asked for it, carrying over
+// the latency trace of the message it came from.
+template<typename S>
+void PlannerManager<S>::PublishTrajectory(
+  const fastrack_msgs::Trajectory& source) {
+  if (current_traj_topic_.empty())
+    return;
+
+  fastrack_msgs::Trajectory msg;
+  traj_.ToPackedRos(&msg);
+  msg.origin = source.origin;
+  msg.trace = source.trace;
+  msg.trace.push_back(ros::Time::now());
+  current_traj_pub_.publish(msg);
+}
+
 // Converts the goal state into a Rviz marker.
 template<typename S>
 void PlannerManager<S>::VisualizeGoal() const {
@@ -360,16 +665,17 @@ void PlannerManager<S>::VisualizeGoal() const {
   sphere.color.b = 0.7;
 
   geometry_msgs::Point center;
+  const Vector3d goal_position = S(goal_).Position();
 
   // Fill in center and scale.
   sphere.scale.x = 0.1;
-  center.x = goal_.x[0];
+  center.x = goal_position(0);
 
   sphere.scale.y = 0.1;
-  center.y = goal_.x[1];
+  center.y = goal_position(1);
 
   sphere.scale.z = 0.1;
-  center.z = goal_.x[2];
+  center.z = goal_position(2);
 
   sphere.pose.position = center;
   sphere.pose.orientation.x = 0.0;
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Double integrator planner over the PositionVelocity state space, using
+// GraphDynamicPlanner high level logic. Sub-plans are closed-form: each axis
+// follows a bang-coast-bang acceleration profile, and all axes are
+// synchronized to the duration of the slowest one. Speed limits are given by
+// the planner dynamics and acceleration limits are planner parameters.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_PLANNING_POSITION_VELOCITY_PLANNER_H
+#define FASTRACK_PLANNING_POSITION_VELOCITY_PLANNER_H
+
+#include <fastrack/dynamics/kinematics.h>
+#include <fastrack/planning/graph_dynamic_planner.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/utils/double_integrator.h>
+#include <fastrack/utils/types.h>
+#include <fastrack_srvs/KinematicPlannerDynamics.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace fastrack {
+namespace planning {
+
+using dynamics::Kinematics;
+using state::PositionVelocity;
+
+template <typename E, typename B, typename SB>
+class PositionVelocityPlanner
+    : public GraphDynamicPlanner<PositionVelocity, E,
+                                 Kinematics<PositionVelocity>,
+                                 fastrack_srvs::KinematicPlannerDynamics, B,
+                                 SB> {
+ public:
+  ~PositionVelocityPlanner() { this->StopExpansion(); }
+  explicit PositionVelocityPlanner()
+      : GraphDynamicPlanner<PositionVelocity, E, Kinematics<PositionVelocity>,
+                            fastrack_srvs::KinematicPlannerDynamics, B, SB>(),
+        max_acceleration_(Vector3d::Zero()),
+        resolution_(0.05) {}
+
+ private:
+  // Load parameters.
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Generate a sub-plan that connects two states and is dynamically feasible
+  // (but not necessarily recursively feasible).
+  Trajectory<PositionVelocity> SubPlan(const PositionVelocity& start,
+                                       const PositionVelocity& goal,
+                                       double start_time = 0.0) const;
+
+  // Maximum acceleration magnitude along each axis.
+  Vector3d max_acceleration_;
+
+  // Spacing (m) of the states along each sub-plan that are collision checked.
+  double resolution_;
+};  //\class PositionVelocityPlanner
+
+// ----------------------------- IMPLEMENTATION ----------------------------  //
+
+// Load parameters.
+template <typename E, typename B, typename SB>
+bool PositionVelocityPlanner<E, B, SB>::LoadParameters(
+    const ros::NodeHandle& n) {
+  if (!GraphDynamicPlanner<PositionVelocity, E, Kinematics<PositionVelocity>,
+                           fastrack_srvs::KinematicPlannerDynamics, B,
+                           SB>::LoadParameters(n))
+    return false;
+
+  ros::NodeHandle nl(n);
+
+  // Acceleration limits.
+  std::vector<double> max_acceleration;
+  if (!nl.getParam("steering/max_acceleration", max_acceleration))
+    return false;
+
+  if (max_acceleration.size() != 3) {
+    ROS_ERROR("%s: Max acceleration must be 3-dimensional.",
+              this->name_.c_str());
+    return false;
+  }
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    if (max_acceleration[ii] <= 0.0) {
+      ROS_ERROR("%s: Max acceleration must be positive.", this->name_.c_str());
+      return false;
+    }
+
+    max_acceleration_(ii) = max_acceleration[ii];
+  }
+
+  // Optional collision checking resolution.
+  nl.getParam("steering/resolution", resolution_);
+  if (resolution_ <= 0.0) {
+    ROS_ERROR("%s: Steering resolution must be positive.",
+              this->name_.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Generate a sub-plan that connects two states and is dynamically feasible
+// (but not necessarily recursively feasible).
+template <typename E, typename B, typename SB>
+Trajectory<PositionVelocity> PositionVelocityPlanner<E, B, SB>::SubPlan(
+    const PositionVelocity& start, const PositionVelocity& goal,
+    double start_time) const {
+  // Speed limits along each axis.
+  const VectorXd& min_speed = this->dynamics_.GetControlBound().Min();
+  const VectorXd& max_speed = this->dynamics_.GetControlBound().Max();
+  if (min_speed.size() != 3 || max_speed.size() != 3) {
+    ROS_ERROR_THROTTLE(1.0, "%s: Speed limits must be 3-dimensional.",
+                       this->name_.c_str());
+    return Trajectory<PositionVelocity>();
+  }
+
+  const Vector3d& p0 = start.Position();
+  const Vector3d& v0 = start.Velocity();
+  const Vector3d& p1 = goal.Position();
+  const Vector3d& v1 = goal.Velocity();
+
+  // Minimum time along each axis. The slowest axis sets the duration.
+  DoubleIntegratorProfile profiles[3];
+  double duration = 0.0;
+  for (size_t ii = 0; ii < 3; ii++) {
+    if (!MinimumTimeProfile(p0(ii), v0(ii), p1(ii), v1(ii), min_speed(ii),
+                            max_speed(ii), max_acceleration_(ii),
+                            &profiles[ii]))
+      return Trajectory<PositionVelocity>();
+
+    duration = std::max(duration, profiles[ii].Duration());
+  }
+
+  // Stretch every axis to the common duration. With nonzero boundary
+  // velocities some durations may be unattainable for an axis, so back off
+  // a few times before giving up on this sub-plan.
+  constexpr size_t kMaxSynchronizationAttempts = 5;
+  constexpr double kDurationBackoff = 0.25;
+  const double min_duration = duration;
+
+  bool synchronized = false;
+  for (size_t jj = 0; jj < kMaxSynchronizationAttempts && !synchronized;
+       jj++) {
+    duration = min_duration * (1.0 + kDurationBackoff * jj);
+
+    synchronized = true;
+    for (size_t ii = 0; ii < 3 && synchronized; ii++) {
+      synchronized = FixedTimeProfile(
+          p0(ii), v0(ii), p1(ii), v1(ii), min_speed(ii), max_speed(ii),
+          max_acceleration_(ii), duration, &profiles[ii]);
+    }
+  }
+
+  if (!synchronized) return Trajectory<PositionVelocity>();
+
+  // Sample the profiles finely enough that consecutive states are at most
+  // the resolution apart at top speed, and collision check each one.
+  const Vector3d top_speed =
+      min_speed.cwiseAbs().cwiseMax(max_speed.cwiseAbs());
+  const size_t num_steps = std::max<size_t>(
+      1, static_cast<size_t>(
+             std::ceil(duration * top_speed.norm() / resolution_)));
+
+  std::vector<PositionVelocity> states;
+  std::vector<double> times;
+  states.reserve(num_steps + 1);
+  times.reserve(num_steps + 1);
+
+  for (size_t kk = 0; kk <= num_steps; kk++) {
+    const double t = duration * static_cast<double>(kk) / num_steps;
+
+    Vector3d position, velocity;
+    for (size_t ii = 0; ii < 3; ii++)
+      profiles[ii].Evaluate(t, &position(ii), &velocity(ii));
+
+    const PositionVelocity state(position, velocity);
+    if (!this->AreValid(state.OccupiedPositions()))
+      return Trajectory<PositionVelocity>();
+
+    states.emplace_back(state);
+    times.emplace_back(start_time + t);
+  }
+
+  return Trajectory<PositionVelocity>(states, times);
+}
+
+}  // namespace planning
+}  // namespace fastrack
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SessionReplayer class, which reads a session log recorded by a
+// Planner and feeds the same inputs back to a fresh planner process:
+// -- the recorded tracking bound and planner dynamics are served from the
+//    same services the tracker would normally provide
+// -- the recorded random seed is set as the planner's "seed" parameter
+// -- sensor messages (and ray-cast scans, if recorded) and replan requests
+//    are sent in their original order
+//
+// Replay runs either at full speed or paced to the recorded time stamps, and
+// reports replan latency statistics at the end. Each sensor message is given
+// a chance to be incorporated (signaled by the planner's acknowledgment, or
+// failing that by an updated environment message) before the next record is
+// sent.
+//
+// Templated on sensor message (M), dynamics service (SD), and bound
+// service (SB).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_PLANNING_SESSION_REPLAYER_H
+#define FASTRACK_PLANNING_SESSION_REPLAYER_H
+
+#include <fastrack/utils/quantile_estimator.h>
+#include <fastrack/utils/session_log.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/utils/uncopyable.h>
+
+#include <fastrack_msgs/ReplanRequest.h>
+#include <fastrack_msgs/SensedRays.h>
+#include <fastrack_srvs/Replan.h>
+
+#include <ros/ros.h>
+#include <std_msgs/Empty.h>
+#include <std_msgs/UInt32.h>
+#include <atomic>
+
+namespace fastrack {
+namespace planning {
+
+template <typename M, typename SD, typename SB>
+class SessionReplayer : private Uncopyable {
+ public:
+  ~SessionReplayer() {}
+  explicit SessionReplayer()
+    : updated_env_(false),
+      acknowledged_(false),
+      initialized_(false) {}
+
+  // Initialize this class with all parameters and callbacks.
+  bool Initialize(const ros::NodeHandle& n);
+
+  // Replay all records in order. Blocks until done.
+  // NOTE! Callbacks must be serviced on another thread while this runs,
+  // e.g. with a ros::AsyncSpinner.
+  bool Run();
+
+ private:
+  // Load parameters and register callbacks.
+  bool LoadParameters(const ros::NodeHandle& n);
+  bool RegisterCallbacks(const ros::NodeHandle& n);
+
+  // Read the session log.
+  bool ReadSession();
+
+  // Service callbacks for recorded tracking bound and planner dynamics.
+  inline bool TrackingBoundServer(
+    typename SB::Request& req, typename SB::Response& res) {
+    res = bound_;
+    return true;
+  }
+  inline bool PlannerDynamicsServer(
+    typename SD::Request& req, typename SD::Response& res) {
+    res = dynamics_;
+    return true;
+  }
+
+  // Planner has incorporated a sensor message.
+  inline void UpdatedEnvironmentCallback(const std_msgs::Empty::ConstPtr& msg) {
+    updated_env_ = true;
+  }
+
+  // Planner has acknowledged a sensor message, changed or not.
+  inline void SensorAckCallback(const std_msgs::Empty::ConstPtr& msg) {
+    acknowledged_ = true;
+  }
+
+  // All records, in order, and the recorded bound and dynamics.
+  std::vector<SessionRecord> records_;
+  typename SB::Response bound_;
+  typename SD::Response dynamics_;
+
+  // Should we pace replay to the recorded time stamps?
+  bool realtime_;
+
+  // How long to wait (s) for each sensor message to be incorporated.
+  double sensor_timeout_;
+
+  // Has the environment been updated since the last sensor message, and has
+  // the planner acknowledged it?
+  std::atomic<bool> updated_env_;
+  std::atomic<bool> acknowledged_;
+
+  // Session log file, and planner parameter to set with the recorded seed.
+  std::string file_name_;
+  std::string seed_param_;
+
+  // Publishers/subscribers and related topics.
+  ros::Publisher sensor_pub_;
+  ros::Publisher rays_pub_;
+  ros::Subscriber updated_env_sub_;
+  ros::Subscriber sensor_ack_sub_;
+
+  std::string sensor_topic_;
+  std::string rays_topic_;
+  std::string updated_env_topic_;
+  std::string sensor_ack_topic_;
+
+  // Services.
+  ros::ServiceServer bound_srv_;
+  ros::ServiceServer dynamics_srv_;
+  ros::ServiceClient replan_srv_;
+
+  std::string bound_srv_name_;
+  std::string dynamics_srv_name_;
+  std::string replan_srv_name_;
+
+  // Naming and initialization.
+  std::string name_;
+  bool initialized_;
+}; //\class SessionReplayer
+
+// ----------------------------- IMPLEMENTATION ----------------------------- //
+
+// Initialize this class with all parameters and callbacks.
+template <typename M, typename SD, typename SB>
+bool SessionReplayer<M, SD, SB>::Initialize(const ros::NodeHandle& n) {
+  name_ = ros::names::append(n.getNamespace(), "SessionReplayer");
+
+  // Load parameters.
+  if (!LoadParameters(n)) {
+    ROS_ERROR("%s: Failed to load parameters.", name_.c_str());
+    return false;
+  }
+
+  // Read session, and set the planner's seed before it can ask for the bound
+  // and dynamics.
+  if (!ReadSession()) {
+    ROS_ERROR("%s: Failed to read session log %s.", name_.c_str(),
+              file_name_.c_str());
+    return false;
+  }
+
+  // Register callbacks.
+  if (!RegisterCallbacks(n)) {
+    ROS_ERROR("%s: Failed to register callbacks.", name_.c_str());
+    return false;
+  }
+
+  initialized_ = true;
+  return true;
+}
+
+// Load parameters.
+template <typename M, typename SD, typename SB>
+bool SessionReplayer<M, SD, SB>::LoadParameters(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
+  // Session log and replay mode.
+  if (!nl.getParam("file", file_name_)) return false;
+  if (!nl.getParam("realtime", realtime_)) return false;
+  if (!nl.getParam("sensor_timeout", sensor_timeout_)) return false;
+  if (!nl.getParam("seed_param", seed_param_)) return false;
+
+  // Topics.
+  if (!nl.getParam("topic/sensor", sensor_topic_)) return false;
+  if (!nl.getParam("topic/updated_env", updated_env_topic_)) return false;
+
+  // Optional sensor acknowledgments. Without them, sensor messages which do
+  // not change the planner's environment wait for the full timeout.
+  nl.getParam("topic/sensor_ack", sensor_ack_topic_);
+
+  // Optional topic for ray-cast scans. Without it, recorded scans are skipped.
+  nl.getParam("topic/rays", rays_topic_);
+
+  // Services.
+  if (!nl.getParam("srv/replan", replan_srv_name_)) return false;
+  if (!nl.getParam("srv/dynamics", dynamics_srv_name_)) return false;
+  if (!nl.getParam("srv/bound", bound_srv_name_)) return false;
+
+  return true;
+}
+
+// Register callbacks.
+template <typename M, typename SD, typename SB>
+bool SessionReplayer<M, SD, SB>::RegisterCallbacks(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
+  // Subscribers.
+  updated_env_sub_ = nl.subscribe(updated_env_topic_.c_str(), 1,
+    &SessionReplayer<M, SD, SB>::UpdatedEnvironmentCallback, this);
+
+  if (!sensor_ack_topic_.empty())
+    sensor_ack_sub_ = nl.subscribe(sensor_ack_topic_.c_str(), 1,
+      &SessionReplayer<M, SD, SB>::SensorAckCallback, this);
+
+  // Publishers.
+  sensor_pub_ = nl.advertise<M>(sensor_topic_.c_str(), 1, false);
+
+  if (!rays_topic_.empty())
+    rays_pub_ = nl.advertise<fastrack_msgs::SensedRays>(
+      rays_topic_.c_str(), 1, false);
+
+  // Services.
+  bound_srv_ = nl.advertiseService(bound_srv_name_.c_str(),
+    &SessionReplayer<M, SD, SB>::TrackingBoundServer, this);
+  dynamics_srv_ = nl.advertiseService(dynamics_srv_name_.c_str(),
+    &SessionReplayer<M, SD, SB>::PlannerDynamicsServer, this);
+
+  return true;
+}
+
+// Read the session log.
+template <typename M, typename SD, typename SB>
+bool SessionReplayer<M, SD, SB>::ReadSession() {
+  SessionReader reader;
+  if (!reader.Open(file_name_)) return false;
+
+  bool found_bound = false;
+  bool found_dynamics = false;
+  SessionRecord record;
+  while (reader.Next(&record)) {
+    if (record.type == BOUND && !found_bound) {
+      bound_ = record.Deserialize<typename SB::Response>();
+      found_bound = true;
+    } else if (record.type == DYNAMICS && !found_dynamics) {
+      dynamics_ = record.Deserialize<typename SD::Response>();
+      found_dynamics = true;
+    } else if (record.type == SEED) {
+      const std_msgs::UInt32 seed = record.Deserialize<std_msgs::UInt32>();
+      ros::param::set(seed_param_, static_cast<int>(seed.data));
+    }
+
+    records_.push_back(record);
+  }
+
+  if (!found_bound || !found_dynamics) {
+    ROS_ERROR("%s: Session log is missing bound or dynamics.", name_.c_str());
+    return false;
+  }
+
+  ROS_INFO("%s: Read %zu records.", name_.c_str(), records_.size());
+  return true;
+}
+
+// Replay all records in order. Blocks until done.
+template <typename M, typename SD, typename SB>
+bool SessionReplayer<M, SD, SB>::Run() {
+  if (!initialized_) {
+    ROS_ERROR("%s: Not initialized.", name_.c_str());
+    return false;
+  }
+
+  // Wait for the planner to come up.
+  ros::service::waitForService(replan_srv_name_);
+  ros::NodeHandle n;
+  replan_srv_ = n.serviceClient<fastrack_srvs::Replan>(
+    replan_srv_name_.c_str(), true);
+
+  while (ros::ok() && sensor_pub_.getNumSubscribers() == 0)
+    ros::WallDuration(0.01).sleep();
+
+  // Track replan latencies over the whole session.
+  QuantileEstimator latency(records_.size());
+  size_t num_failures = 0;
+
+  const ros::WallTime wall_start = ros::WallTime::now();
+  const ros::Time record_start =
+    (records_.empty()) ? ros::Time(0) : records_.front().stamp;
+
+  for (const auto& record : records_) {
+    if (!ros::ok()) return false;
+
+    // Pace to the recorded time stamps if requested.
+    if (realtime_) {
+      const ros::WallTime wall_target =
+        wall_start + ros::WallDuration((record.stamp - record_start).toSec());
+      const ros::WallDuration wait = wall_target - ros::WallTime::now();
+      if (wait > ros::WallDuration(0.0)) wait.sleep();
+    }
+
+    if (record.type == SENSOR ||
+        (record.type == RAYS && !rays_topic_.empty())) {
+      // Publish and give the planner a chance to incorporate it.
+      updated_env_ = false;
+      acknowledged_ = false;
+      if (record.type == SENSOR)
+        sensor_pub_.publish(record.Deserialize<M>());
+      else
+        rays_pub_.publish(record.Deserialize<fastrack_msgs::SensedRays>());
+
+      const ros::WallTime deadline =
+        ros::WallTime::now() + ros::WallDuration(sensor_timeout_);
+      while (ros::ok() && !updated_env_ && !acknowledged_ &&
+             ros::WallTime::now() < deadline)
+        ros::WallDuration(0.001).sleep();
+    } else if (record.type == REPLAN_REQUEST) {
+      // Time the service call.
+      fastrack_srvs::Replan replan;
+      replan.request.req =
+        record.Deserialize<fastrack_msgs::ReplanRequest>();
+
+      const ros::WallTime call_start = ros::WallTime::now();
+      if (!replan_srv_ || !replan_srv_.call(replan) ||
+          replan.response.traj.times.empty())
+        num_failures++;
+
+      latency.Add((ros::WallTime::now() - call_start).toSec());
+    }
+  }
+
+  ROS_INFO("%s: Replayed %zu replans (%zu failed) in %f s.", name_.c_str(),
+           latency.Size(), num_failures,
+           (ros::WallTime::now() - wall_start).toSec());
+  ROS_INFO("%s: Replan latency p50 %f s, p90 %f s, p99 %f s, max %f s.",
+           name_.c_str(), latency.Quantile(0.5), latency.Quantile(0.9),
+           latency.Quantile(0.99), latency.Quantile(1.0));
+
+  return true;
+}
+
+} //\namespace planning
+} //\namespace fastrack
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parallel ray casting for the RaySensor. Casts every ray in a scan pattern
+// from the sensor pose against a SphereBvh, splitting the rays across a
+// ThreadPool, and writes the result into a preallocated SensedRays message.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_SENSOR_RAY_CASTING_H
+#define FASTRACK_SENSOR_RAY_CASTING_H
+
+#include <fastrack/sensor/ray_sensor_params.h>
+#include <fastrack/utils/sphere_bvh.h>
+#include <fastrack/utils/thread_pool.h>
+#include <fastrack/utils/types.h>
+#include <fastrack_msgs/SensedRays.h>
+
+namespace fastrack {
+namespace sensor {
+
+// Number of rays per task. Large enough to amortize scheduling, small enough
+// to balance load when some directions see many more obstacles than others.
+static constexpr size_t kRaysPerTask = 512;
+
+// Cast all rays and fill in the message. Returns the number of hits.
+inline size_t CastRays(const SphereBvh& bvh, const RaySensorParams& params,
+                       ThreadPool* pool, fastrack_msgs::SensedRays* msg) {
+  const size_t num_rays = params.directions.size();
+  msg->endpoints.resize(num_rays);
+  msg->hits.resize(num_rays);
+  msg->sensor_position.x = params.position(0);
+  msg->sensor_position.y = params.position(1);
+  msg->sensor_position.z = params.position(2);
+  msg->sensor_range = params.range;
+
+  const Matrix3d rotation = params.orientation.toRotationMatrix();
+  std::atomic<size_t> num_hits(0);
+  pool->ParallelFor(num_rays, kRaysPerTask,
+                    [&](size_t begin, size_t end) {
+    size_t chunk_hits = 0;
+    for (size_t ii = begin; ii < end; ii++) {
+      const Vector3d direction = rotation * params.directions[ii];
+      const double distance =
+          bvh.Raycast(params.position, direction, params.range);
+      const Vector3d endpoint = params.position + distance * direction;
+
+      auto& e = msg->endpoints[ii];
+      e.x = endpoint(0);
+      e.y = endpoint(1);
+      e.z = endpoint(2);
+
+      const bool hit = distance < params.range;
+      msg->hits[ii] = hit;
+      chunk_hits += hit;
+    }
+
+    num_hits += chunk_hits;
+  });
+
+  return num_hits;
+}
+
+} //\namespace sensor
+} //\namespace fastrack
+
+#endif
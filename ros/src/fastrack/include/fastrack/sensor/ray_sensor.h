@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Depth sensor which ray casts a LiDAR or pinhole scan pattern into the
+// ground truth environment, and publishes the endpoint of every ray along
+// with whether it hit anything. This is meant for load testing mapping and
+// planning at realistic sensor bandwidth.
+//
+// Templated on environment type, which must provide a SimulateSensor for
+// RaySensorParams (e.g. BallsInBox, which casts rays in parallel against a
+// bounding volume hierarchy over its obstacles).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_SENSOR_RAY_SENSOR_H
+#define FASTRACK_SENSOR_RAY_SENSOR_H
+
+#include <fastrack/sensor/ray_sensor_params.h>
+#include <fastrack/sensor/sensor.h>
+#include <fastrack_msgs/SensedRays.h>
+
+namespace fastrack {
+namespace sensor {
+
+template<typename E>
+class RaySensor : public Sensor<
+  E, fastrack_msgs::SensedRays, RaySensorParams> {
+public:
+  ~RaySensor() {}
+  explicit RaySensor()
+    : Sensor<E, fastrack_msgs::SensedRays, RaySensorParams>() {}
+
+private:
+  // Load parameters. This may be overridden by derived classes if needed
+  // (they should still call this one via Sensor::LoadParameters).
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Update sensor parameters.
+  void UpdateParameters();
+
+  // Derived classes must have some sort of visualization through RViz.
+  void Visualize() const;
+}; //\class RaySensor
+
+// ----------------------------- IMPLEMENTATION ----------------------------- //
+
+// Load parameters. This may be overridden by derived classes if needed
+// (they should still call this one via Sensor::LoadParameters).
+template<typename E>
+bool RaySensor<E>::LoadParameters(const ros::NodeHandle& n) {
+  if (!Sensor<E, fastrack_msgs::SensedRays, RaySensorParams>::
+      LoadParameters(n))
+    return false;
+
+  ros::NodeHandle nl(n);
+
+  // Range.
+  if (!nl.getParam("range", this->params_.range)) return false;
+
+  // Scan pattern. Defaults to a 16-beam spinning LiDAR.
+  std::string pattern = "lidar";
+  nl.getParam("pattern/type", pattern);
+
+  if (pattern == "lidar") {
+    int num_rings = 16;
+    int num_beams = 1024;
+    double min_elevation = -0.26;
+    double max_elevation = 0.26;
+    nl.getParam("pattern/num_rings", num_rings);
+    nl.getParam("pattern/num_beams", num_beams);
+    nl.getParam("pattern/min_elevation", min_elevation);
+    nl.getParam("pattern/max_elevation", max_elevation);
+
+    if (num_rings <= 0 || num_beams <= 0) {
+      ROS_ERROR("%s: LiDAR pattern must have rings and beams.",
+                this->name_.c_str());
+      return false;
+    }
+
+    this->params_.SetLidarPattern(num_rings, num_beams, min_elevation,
+                                  max_elevation);
+  } else if (pattern == "pinhole") {
+    int width = 640;
+    int height = 480;
+    double horizontal_fov = 1.5;
+    nl.getParam("pattern/width", width);
+    nl.getParam("pattern/height", height);
+    nl.getParam("pattern/horizontal_fov", horizontal_fov);
+
+    if (width <= 0 || height <= 0 || horizontal_fov <= 0.0 ||
+        horizontal_fov >= M_PI) {
+      ROS_ERROR("%s: Invalid pinhole pattern.", this->name_.c_str());
+      return false;
+    }
+
+    this->params_.SetPinholePattern(width, height, horizontal_fov);
+  } else {
+    ROS_ERROR("%s: Unknown scan pattern: %s.", this->name_.c_str(),
+              pattern.c_str());
+    return false;
+  }
+
+  // Number of threads (zero for one per hardware thread).
+  int num_threads = 0;
+  nl.getParam("num_threads", num_threads);
+  this->params_.num_threads = static_cast<size_t>(std::max(0, num_threads));
+
+  return true;
+}
+
+// Update sensor parameters.
+template<typename E>
+void RaySensor<E>::UpdateParameters() {
+  // Get the current sensor pose from tf.
+  geometry_msgs::TransformStamped tf;
+
+  try {
+    tf = this->tf_buffer_.lookupTransform(
+      this->fixed_frame_.c_str(), this->sensor_frame_.c_str(), ros::Time(0));
+  } catch(tf2::TransformException &ex) {
+    ROS_WARN("%s: %s", this->name_.c_str(), ex.what());
+    ROS_WARN("%s: Could not determine current sensor pose.", this->name_.c_str());
+    return;
+  }
+
+  // Unpack into parameters struct.
+  this->params_.position(0) = tf.transform.translation.x;
+  this->params_.position(1) = tf.transform.translation.y;
+  this->params_.position(2) = tf.transform.translation.z;
+
+  this->params_.orientation = Quaterniond(
+    tf.transform.rotation.w, tf.transform.rotation.x,
+    tf.transform.rotation.y, tf.transform.rotation.z);
+
+  return;
+}
+
+// Derived classes must have some sort of visualization through RViz.
+template<typename E>
+void RaySensor<E>::Visualize() const {
+  visualization_msgs::Marker m;
+  m.ns = "sensor";
+  m.header.frame_id = this->sensor_frame_;
+  m.header.stamp = ros::Time::now();
+  m.id = 0;
+  m.type = visualization_msgs::Marker::SPHERE;
+  m.action = visualization_msgs::Marker::ADD;
+  m.color.a = 0.1;
+  m.color.r = 0.1;
+  m.color.g = 0.5;
+  m.color.b = 0.3;
+  m.scale.x = 2.0 * this->params_.range;
+  m.scale.y = 2.0 * this->params_.range;
+  m.scale.z = 2.0 * this->params_.range;
+
+  this->vis_pub_.publish(m);
+}
+
+} //\namespace sensor
+} //\namespace fastrack
+
+#endif
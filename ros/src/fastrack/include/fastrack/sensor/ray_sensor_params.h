@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parameters for the RaySensor. The scan pattern is a set of unit ray
+// directions in the sensor frame (x forward, y left, z up), generated once
+// for either a spinning LiDAR or a pinhole depth camera.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_SENSOR_RAY_SENSOR_PARAMS_H
+#define FASTRACK_SENSOR_RAY_SENSOR_PARAMS_H
+
+#include <fastrack/utils/types.h>
+
+#include <cmath>
+#include <vector>
+
+namespace fastrack {
+namespace sensor {
+
+struct RaySensorParams {
+  // Pose and range of the sensor.
+  Vector3d position = Vector3d::Zero();
+  Quaterniond orientation = Quaterniond::Identity();
+  double range = 10.0;
+
+  // Unit ray directions in the sensor frame.
+  std::vector<Vector3d> directions;
+
+  // Number of threads to cast rays on (zero for one per hardware thread).
+  size_t num_threads = 0;
+
+  // LiDAR pattern: 'num_rings' rings evenly spaced in elevation between
+  // the given angles (radians), each with 'num_beams' rays evenly spaced in
+  // azimuth around the full circle.
+  void SetLidarPattern(size_t num_rings, size_t num_beams,
+                       double min_elevation, double max_elevation) {
+    directions.clear();
+    directions.reserve(num_rings * num_beams);
+    for (size_t ii = 0; ii < num_rings; ii++) {
+      const double elevation =
+          (num_rings > 1) ? min_elevation + (max_elevation - min_elevation) *
+                                                ii / (num_rings - 1)
+                          : 0.5 * (min_elevation + max_elevation);
+      for (size_t jj = 0; jj < num_beams; jj++) {
+        const double azimuth = 2.0 * M_PI * jj / num_beams;
+        directions.emplace_back(std::cos(elevation) * std::cos(azimuth),
+                                std::cos(elevation) * std::sin(azimuth),
+                                std::sin(elevation));
+      }
+    }
+  }
+
+  // Pinhole pattern: one ray through the center of each pixel of a
+  // 'width' by 'height' image with the given horizontal field of view
+  // (radians) and square pixels.
+  void SetPinholePattern(size_t width, size_t height,
+                         double horizontal_fov) {
+    directions.clear();
+    directions.reserve(width * height);
+
+    const double focal_length = 0.5 * width / std::tan(0.5 * horizontal_fov);
+    const double cx = 0.5 * width;
+    const double cy = 0.5 * height;
+    for (size_t v = 0; v < height; v++) {
+      for (size_t u = 0; u < width; u++) {
+        directions.push_back(
+            Vector3d(focal_length, cx - (u + 0.5), cy - (v + 0.5))
+                .normalized());
+      }
+    }
+  }
+}; //\struct RaySensorParams
+
+} //\namespace sensor
+} //\namespace fastrack
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ClosedLoopSimulator class, which runs headless Monte Carlo
+// rollouts of a tracker following planner reference trajectories. The tracker
+// is a PositionVelocity system driven by the value function's optimal control
+// through its tracker dynamics (e.g. QuadrotorDecoupled6D), with bounded
+// disturbances injected at every integration step. Rollouts are spread over
+// worker threads, and the simulator reports tracking error bound violations
+// and optimal control throughput.
+//
+// Templated on the value function (V) and planner state (PS).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_SIMULATION_CLOSED_LOOP_SIMULATOR_H
+#define FASTRACK_SIMULATION_CLOSED_LOOP_SIMULATOR_H
+
+#include <fastrack/simulation/closed_loop_simulator_params.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/utils/uncopyable.h>
+
+#include <ros/ros.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace fastrack {
+namespace simulation {
+
+using state::PositionVelocity;
+using trajectory::Trajectory;
+
+// Outcome of a single rollout.
+struct RolloutResult {
+  // Number of control periods simulated, and how many of them ended with the
+  // tracking error outside the bound.
+  size_t num_steps = 0;
+  size_t num_violating_steps = 0;
+
+  // Time (relative to the start of the reference) of the first violation, or
+  // infinity if the bound was never violated.
+  double first_violation_time = std::numeric_limits<double>::infinity();
+
+  // Largest absolute tracking error seen in each dimension.
+  Vector3d max_abs_error = Vector3d::Zero();
+
+  // Total time spent computing optimal controls (s).
+  double control_time = 0.0;
+
+  // Was the bound ever violated.
+  bool Violated() const { return num_violating_steps > 0; }
+}; //\struct RolloutResult
+
+// Summary over all rollouts.
+struct ClosedLoopSimulationReport {
+  size_t num_rollouts = 0;
+  size_t num_violating_rollouts = 0;
+  size_t num_steps = 0;
+  size_t num_violating_steps = 0;
+
+  // Largest absolute tracking error seen in each dimension.
+  Vector3d max_abs_error = Vector3d::Zero();
+
+  // Total time spent computing optimal controls, summed over threads, and
+  // wall clock time for the whole simulation (s).
+  double control_time = 0.0;
+  double wall_time = 0.0;
+
+  // Fraction of rollouts which violated the bound at least once.
+  double ViolationRate() const {
+    return (num_rollouts == 0) ? 0.0
+                               : static_cast<double>(num_violating_rollouts) /
+                                     static_cast<double>(num_rollouts);
+  }
+
+  // Optimal controls computed per second of (single-threaded) control time,
+  // and control periods simulated per second of wall time.
+  double ControlsPerSecond() const {
+    return (control_time > 0.0) ? static_cast<double>(num_steps) / control_time
+                                : 0.0;
+  }
+  double StepsPerWallSecond() const {
+    return (wall_time > 0.0) ? static_cast<double>(num_steps) / wall_time : 0.0;
+  }
+
+  // Log a summary.
+  void Print(const std::string& name) const {
+    ROS_INFO("%s: %zu of %zu rollouts violated the bound (%zu of %zu steps).",
+             name.c_str(), num_violating_rollouts, num_rollouts,
+             num_violating_steps, num_steps);
+    ROS_INFO("%s: Largest absolute error (%f, %f, %f).", name.c_str(),
+             max_abs_error(0), max_abs_error(1), max_abs_error(2));
+    ROS_INFO("%s: %.3e controls/s per thread, %.3e steps/s wall clock.",
+             name.c_str(), ControlsPerSecond(), StepsPerWallSecond());
+  }
+}; //\struct ClosedLoopSimulationReport
+
+template <typename V, typename PS>
+class ClosedLoopSimulator : private Uncopyable {
+public:
+  ~ClosedLoopSimulator() {}
+  explicit ClosedLoopSimulator(const V& value)
+    : value_(value), initialized_(false) {}
+
+  // Initialize from a ROS NodeHandle. All parameters are optional.
+  bool Initialize(const ros::NodeHandle& n);
+
+  // Initialize from parameters. Can be used as an alternative to
+  // initialization from a NodeHandle.
+  bool InitializeFromParameters(const ClosedLoopSimulatorParams& params);
+
+  // Run params.num_rollouts rollouts across worker threads. Rollout ii
+  // follows references[ii % references.size()].
+  ClosedLoopSimulationReport Simulate(
+    const std::vector<Trajectory<PS>>& references) const;
+
+  // Run a single rollout along the given reference.
+  RolloutResult Rollout(const Trajectory<PS>& reference,
+                        unsigned int seed) const;
+
+  // Accessors.
+  const ClosedLoopSimulatorParams& Params() const { return params_; }
+
+private:
+  // Load parameters.
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Read an optional 3-vector parameter.
+  static bool LoadVector3d(const ros::NodeHandle& n, const std::string& key,
+                           Vector3d* v);
+
+  // Value function, which also provides tracker dynamics and bound.
+  const V& value_;
+
+  // Simulation parameters.
+  ClosedLoopSimulatorParams params_;
+
+  // Naming and initialization.
+  std::string name_;
+  bool initialized_;
+}; //\class ClosedLoopSimulator
+
+// ---------------------------- IMPLEMENTATION  ---------------------------- //
+
+// Initialize from a ROS NodeHandle.
+template <typename V, typename PS>
+bool ClosedLoopSimulator<V, PS>::Initialize(const ros::NodeHandle& n) {
+  name_ = ros::names::append(n.getNamespace(), "ClosedLoopSimulator");
+
+  if (!LoadParameters(n)) {
+    ROS_ERROR("%s: Failed to load parameters.", name_.c_str());
+    return false;
+  }
+
+  return InitializeFromParameters(params_);
+}
+
+// Initialize from parameters.
+template <typename V, typename PS>
+bool ClosedLoopSimulator<V, PS>::InitializeFromParameters(
+  const ClosedLoopSimulatorParams& params) {
+  if (params.time_step <= 0.0 || params.num_substeps == 0) {
+    ROS_ERROR("%s: Time step and number of substeps must be positive.",
+              name_.c_str());
+    return false;
+  }
+
+  params_ = params;
+  initialized_ = true;
+  return true;
+}
+
+// Run params.num_rollouts rollouts across worker threads.
+template <typename V, typename PS>
+ClosedLoopSimulationReport ClosedLoopSimulator<V, PS>::Simulate(
+  const std::vector<Trajectory<PS>>& references) const {
+  if (!initialized_)
+    throw std::runtime_error("Uninitialized call to Simulate.");
+
+  if (references.empty())
+    throw std::runtime_error("ClosedLoopSimulator: no reference trajectories.");
+
+  const auto start = std::chrono::steady_clock::now();
+
+  // Workers pull rollout indices from a shared counter and write results
+  // into their own slots, so no locking is needed.
+  std::vector<RolloutResult> results(params_.num_rollouts);
+  std::atomic<size_t> next_rollout(0);
+  auto worker = [&]() {
+    for (size_t ii = next_rollout++; ii < results.size();
+         ii = next_rollout++) {
+      results[ii] = Rollout(references[ii % references.size()],
+                            params_.seed + static_cast<unsigned int>(ii));
+    }
+  };
+
+  size_t num_threads = params_.num_threads;
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, results.size());
+
+  std::vector<std::thread> threads;
+  for (size_t ii = 1; ii < num_threads; ii++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+
+  // Merge results in rollout order.
+  ClosedLoopSimulationReport report;
+  for (const auto& result : results) {
+    report.num_rollouts++;
+    report.num_violating_rollouts += result.Violated();
+    report.num_steps += result.num_steps;
+    report.num_violating_steps += result.num_violating_steps;
+    report.max_abs_error = report.max_abs_error.cwiseMax(result.max_abs_error);
+    report.control_time += result.control_time;
+  }
+
+  report.wall_time = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  return report;
+}
+
+// Run a single rollout along the given reference.
+template <typename V, typename PS>
+RolloutResult ClosedLoopSimulator<V, PS>::Rollout(
+  const Trajectory<PS>& reference, unsigned int seed) const {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+  auto sample = [&](const Vector3d& bound) {
+    return Vector3d(unif(rng) * bound(0), unif(rng) * bound(1),
+                    unif(rng) * bound(2));
+  };
+
+  // Reference state at time t, clamped to the reference's time interval.
+  const double t0 = reference.FirstTime();
+  auto reference_at = [&](double t) {
+    return (t <= t0) ? reference.FirstState()
+                     : reference.Interpolate(std::min(t, reference.LastTime()));
+  };
+
+  // Start at the beginning of the reference, perturbed by the initial error.
+  const PS planner_x0 = reference.FirstState();
+  PositionVelocity tracker_x(
+    planner_x0.Position() + sample(params_.initial_position_error),
+    planner_x0.Velocity() + sample(params_.initial_velocity_error));
+
+  const double dt = params_.time_step / static_cast<double>(params_.num_substeps);
+  const size_t num_steps =
+    static_cast<size_t>(reference.Duration() / params_.time_step);
+
+  RolloutResult result;
+  for (size_t ii = 0; ii < num_steps; ii++) {
+    const double t = t0 + ii * params_.time_step;
+
+    // Compute the optimal control at the start of this period.
+    const PS planner_x = reference_at(t);
+    const auto control_start = std::chrono::steady_clock::now();
+    const auto u = value_.OptimalControl(tracker_x, planner_x);
+    result.control_time += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - control_start).count();
+
+    // Hold it while integrating the disturbed tracker dynamics.
+    for (size_t jj = 0; jj < params_.num_substeps; jj++) {
+      const PositionVelocity x_dot =
+        value_.TrackerDynamics().Evaluate(tracker_x, u);
+      tracker_x = PositionVelocity(
+        tracker_x.Position() +
+        dt * (x_dot.Position() + sample(params_.velocity_disturbance)),
+        tracker_x.Velocity() +
+        dt * (x_dot.Velocity() + sample(params_.acceleration_disturbance)));
+    }
+
+    // Check tracking error against the bound at the end of this period.
+    const Vector3d error =
+      tracker_x.Position() - reference_at(t + params_.time_step).Position();
+    result.num_steps++;
+    result.max_abs_error = result.max_abs_error.cwiseMax(error.cwiseAbs());
+    if (!value_.TrackingBound().Contains(error)) {
+      if (!result.Violated())
+        result.first_violation_time = t + params_.time_step - t0;
+      result.num_violating_steps++;
+    }
+  }
+
+  return result;
+}
+
+// Load parameters.
+template <typename V, typename PS>
+bool ClosedLoopSimulator<V, PS>::LoadParameters(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
+  int num_rollouts = static_cast<int>(params_.num_rollouts);
+  int num_threads = static_cast<int>(params_.num_threads);
+  int num_substeps = static_cast<int>(params_.num_substeps);
+  int seed = static_cast<int>(params_.seed);
+  nl.getParam("sim/num_rollouts", num_rollouts);
+  nl.getParam("sim/num_threads", num_threads);
+  nl.getParam("sim/num_substeps", num_substeps);
+  nl.getParam("sim/seed", seed);
+  nl.getParam("sim/time_step", params_.time_step);
+
+  if (num_rollouts < 0 || num_threads < 0 || num_substeps < 0) {
+    ROS_ERROR("%s: Counts must be non-negative.", name_.c_str());
+    return false;
+  }
+
+  params_.num_rollouts = static_cast<size_t>(num_rollouts);
+  params_.num_threads = static_cast<size_t>(num_threads);
+  params_.num_substeps = static_cast<size_t>(num_substeps);
+  params_.seed = static_cast<unsigned int>(seed);
+
+  if (!LoadVector3d(nl, "sim/velocity_disturbance",
+                    &params_.velocity_disturbance) ||
+      !LoadVector3d(nl, "sim/acceleration_disturbance",
+                    &params_.acceleration_disturbance) ||
+      !LoadVector3d(nl, "sim/initial_position_error",
+                    &params_.initial_position_error) ||
+      !LoadVector3d(nl, "sim/initial_velocity_error",
+                    &params_.initial_velocity_error)) {
+    ROS_ERROR("%s: Vector parameters must have 3 entries.", name_.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Read an optional 3-vector parameter.
+template <typename V, typename PS>
+bool ClosedLoopSimulator<V, PS>::LoadVector3d(const ros::NodeHandle& n,
+                                              const std::string& key,
+                                              Vector3d* v) {
+  std::vector<double> values;
+  if (!n.getParam(key, values)) return true;
+  if (values.size() != 3) return false;
+
+  *v = Vector3d(values[0], values[1], values[2]);
+  return true;
+}
+
+} //\namespace simulation
+} //\namespace fastrack
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parameters for the ClosedLoopSimulator.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_SIMULATION_CLOSED_LOOP_SIMULATOR_PARAMS_H
+#define FASTRACK_SIMULATION_CLOSED_LOOP_SIMULATOR_PARAMS_H
+
+#include <fastrack/utils/types.h>
+
+namespace fastrack {
+namespace simulation {
+
+struct ClosedLoopSimulatorParams {
+  // Number of rollouts, and number of worker threads. Zero threads means use
+  // one per hardware thread.
+  size_t num_rollouts = 1000;
+  size_t num_threads = 0;
+
+  // Control period, and number of integration steps per control period.
+  // Control is held constant over each period, as on the vehicle.
+  double time_step = 0.02;
+  size_t num_substeps = 10;
+
+  // Disturbance bounds (assumed to be symmetric). Velocity disturbance is
+  // added to the position derivative and acceleration disturbance to the
+  // velocity derivative, resampled uniformly at every integration step.
+  Vector3d velocity_disturbance = Vector3d::Zero();
+  Vector3d acceleration_disturbance = Vector3d::Zero();
+
+  // Bounds on the initial tracking error (assumed to be symmetric).
+  Vector3d initial_position_error = Vector3d::Zero();
+  Vector3d initial_velocity_error = Vector3d::Zero();
+
+  // Seed for the random number generator. Rollout ii is seeded with
+  // seed + ii, so results do not depend on the number of threads.
+  unsigned int seed = 0;
+}; //\struct ClosedLoopSimulatorParams
+
+} //\namespace simulation
+} //\namespace fastrack
+
+#endif
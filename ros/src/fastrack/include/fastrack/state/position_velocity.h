@@ -107,6 +107,10 @@ class PositionVelocity : public State {
   void FromRos(const fastrack_msgs::State& msg);
   fastrack_msgs::State ToRos() const;
 
+  // Write the same values as ToRos into a flat buffer.
+  size_t PackedDimension() const { return 6; }
+  void Pack(double* x) const;
+
   // Dimension of the state and configuration spaces.
   static constexpr size_t StateDimension() { return 6; }
   static constexpr size_t ConfigurationDimension() { return 3; }
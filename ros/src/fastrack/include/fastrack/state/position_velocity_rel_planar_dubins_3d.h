@@ -79,6 +79,14 @@ public:
     FromVector(x);
   }
 
+  // Fixed-size vector type, for allocation-free conversions.
+  typedef Eigen::Matrix<double, 4, 1> FixedVector;
+
+  // Construct from FixedVector.
+  explicit PositionVelocityRelPlanarDubins3D(const FixedVector& x)
+      : distance_(x(0)), bearing_(x(1)), tangent_velocity_(x(2)),
+        normal_velocity_(x(3)) {}
+
   // Construct directly.
   explicit PositionVelocityRelPlanarDubins3D(double distance, double bearing,
                                              double tangent_v, double normal_v)
@@ -108,6 +116,11 @@ public:
     return vec;
   }
 
+  FixedVector ToFixedVector() const {
+    return FixedVector(distance_, bearing_, tangent_velocity_,
+                       normal_velocity_);
+  }
+
   // Dimension of the state space.
   static constexpr size_t StateDimension() { return 4; }
 
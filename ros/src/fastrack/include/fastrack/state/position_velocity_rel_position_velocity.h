@@ -78,9 +78,22 @@ public:
   explicit PositionVelocityRelPositionVelocity(const VectorXd &x)
       : RelativeState<PositionVelocity, PositionVelocity>(), x_(x) {}
 
+  // Fixed-size vector type, for allocation-free conversions.
+  typedef Eigen::Matrix<double, 6, 1> FixedVector;
+
+  // Construct from FixedVector.
+  explicit PositionVelocityRelPositionVelocity(const FixedVector &x)
+      : RelativeState<PositionVelocity, PositionVelocity>(),
+        x_(x.head<3>(), x.tail<3>()) {}
+
   // Convert from/to VectorXd.
   void FromVector(const VectorXd& x) { x_.FromVector(x); }
   VectorXd ToVector() const { return x_.ToVector(); }
+  FixedVector ToFixedVector() const {
+    FixedVector x;
+    x << x_.Position(), x_.Velocity();
+    return x;
+  }
 
   // Dimension of the state space.
   static constexpr size_t StateDimension() { return 6; }
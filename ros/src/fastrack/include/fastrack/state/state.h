@@ -78,6 +78,15 @@ public:
   virtual void FromRos(const fastrack_msgs::State& msg) = 0;
   virtual fastrack_msgs::State ToRos() const = 0;
 
+  // Write the same values as ToRos into a flat buffer, which must have room
+  // for PackedDimension() values. Derived classes should override these to
+  // avoid building a message.
+  virtual size_t PackedDimension() const { return ToRos().x.size(); }
+  virtual void Pack(double* x) const {
+    const fastrack_msgs::State msg = ToRos();
+    std::copy(msg.x.begin(), msg.x.end(), x);
+  }
+
   // Re-seed the random engine.
   static inline void Seed(unsigned int seed) { rng_.seed(seed); }
 
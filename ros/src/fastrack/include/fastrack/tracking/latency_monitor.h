@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LatencyMonitor class, which listens for traced control messages
+// and periodically publishes percentiles of end-to-end latencies:
+// -- state-to-control: age of the tracker state behind each control
+// -- plan-to-reference: age of the planner trajectory behind each control
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_TRACKING_LATENCY_MONITOR_H
+#define FASTRACK_TRACKING_LATENCY_MONITOR_H
+
+#include <fastrack/utils/quantile_estimator.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/utils/uncopyable.h>
+
+#include <fastrack_msgs/Control.h>
+#include <fastrack_msgs/LatencyStats.h>
+
+#include <ros/ros.h>
+
+namespace fastrack {
+namespace tracking {
+
+class LatencyMonitor : private Uncopyable {
+public:
+  ~LatencyMonitor() {}
+  explicit LatencyMonitor()
+    : initialized_(false) {}
+
+  // Initialize this class with all parameters and callbacks.
+  bool Initialize(const ros::NodeHandle& n);
+
+private:
+  // Load parameters and register callbacks.
+  bool LoadParameters(const ros::NodeHandle& n);
+  bool RegisterCallbacks(const ros::NodeHandle& n);
+
+  // Callback for processing traced control messages.
+  void ControlCallback(const fastrack_msgs::Control::ConstPtr& msg);
+
+  // Timer callback. Publish latency statistics.
+  void TimerCallback(const ros::TimerEvent& e) const;
+
+  // Summarize the given latency estimator.
+  static fastrack_msgs::LatencyStats Summarize(
+    const std::string& name, const QuantileEstimator& latency);
+
+  // Latencies over a sliding window.
+  QuantileEstimator state_to_control_;
+  QuantileEstimator plan_to_reference_;
+
+  // Publishers/subscribers and related topics.
+  ros::Publisher stats_pub_;
+  ros::Subscriber control_sub_;
+
+  std::string stats_topic_;
+  std::string control_topic_;
+
+  // Timer.
+  ros::Timer timer_;
+  double time_step_;
+
+  // Naming and initialization.
+  std::string name_;
+  bool initialized_;
+}; //\class LatencyMonitor
+
+} //\namespace tracking
+} //\namespace fastrack
+
+#endif
@@ -49,16 +49,25 @@
 // services that other nodes can use to access planner dynamics and bound
 // parameters.
 //
+// If a trajectory topic is provided, the tracker also subscribes to the
+// planner's trajectory and interpolates the planner state itself at the exact
+// time the control is computed, rather than relying on the latest reference
+// state message. The reference topic is then only needed as a fallback before
+// the first trajectory arrives (and for visualization elsewhere).
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_TRACKING_TRACKER_H
 #define FASTRACK_TRACKING_TRACKER_H
 
+#include <fastrack/trajectory/trajectory.h>
 #include <fastrack/utils/types.h>
 #include <fastrack/utils/uncopyable.h>
 
 #include <fastrack_msgs/Control.h>
 #include <fastrack_msgs/State.h>
+#include <fastrack_msgs/TracedState.h>
+#include <fastrack_msgs/Trajectory.h>
 
 #include <ros/ros.h>
 #include <visualization_msgs/Marker.h>
@@ -67,6 +76,8 @@
 namespace fastrack {
 namespace tracking {
 
+using trajectory::Trajectory;
+
 template<typename V, typename TS, typename TC, typename PS,
          typename SB, typename SP>
 class Tracker : private Uncopyable {
@@ -76,6 +87,7 @@ public:
     : ready_(false),
       received_planner_x_(false),
       received_tracker_x_(false),
+      received_traj_(false),
       initialized_(false) {}
 
   // Initialize from a ROS NodeHandle.
@@ -101,6 +113,36 @@ private:
     received_planner_x_ = true;
   }
 
+  // Same, for states with latency tracing.
+  inline void TracedTrackerStateCallback(
+    const fastrack_msgs::TracedState::ConstPtr& msg) {
+    tracker_x_.FromRos(msg->state);
+    tracker_origin_ = msg->origin;
+    tracker_trace_ = msg->trace;
+    received_tracker_x_ = true;
+  }
+  inline void TracedPlannerStateCallback(
+    const fastrack_msgs::TracedState::ConstPtr& msg) {
+    planner_x_.FromRos(msg->state);
+    planner_origin_ = msg->origin;
+    received_planner_x_ = true;
+  }
+
+  // Callback to update the planner trajectory, if we are following it.
+  inline void TrajectoryCallback(const fastrack_msgs::Trajectory::ConstPtr& msg) {
+    // Catch failure (empty msg). Packed messages have no 'states'.
+    if (Trajectory<PS>::IsEmpty(*msg)) {
+      ROS_WARN_THROTTLE(1.0, "%s: Received empty trajectory.", name_.c_str());
+      return;
+    }
+
+    // Trace back to the replanning request behind this trajectory, or else
+    // to when it arrived.
+    traj_ = Trajectory<PS>(msg);
+    traj_origin_ = (msg->origin.isZero()) ? ros::Time::now() : msg->origin;
+    received_traj_ = true;
+  }
+
   // Service callbacks for tracking bound and planner parameters.
   inline bool TrackingBoundServer(
     typename SB::Request& req, typename SB::Response& res) {
@@ -118,7 +160,7 @@ private:
     if (!ready_)
       return;
 
-    if (!received_planner_x_ || !received_tracker_x_) {
+    if ((!received_planner_x_ && !received_traj_) || !received_tracker_x_) {
       ROS_WARN_THROTTLE(1.0, "%s: Have not received planner/tracker state yet.",
                         name_.c_str());
       return;
@@ -127,9 +169,20 @@ private:
     // Publish bound.
     value_.TrackingBound().Visualize(bound_pub_, planner_frame_);
 
+    // If following a trajectory, interpolate the planner state right now.
+    const PS planner_x = (received_traj_) ?
+      traj_.Interpolate(ros::Time::now().toSec()) : planner_x_;
+
+    // Compute control and trace back to the states it was computed from.
+    fastrack_msgs::Control u = value_.OptimalControl(tracker_x_, planner_x)
+      .ToRos(value_.Priority(tracker_x_, planner_x));
+    u.origin = tracker_origin_;
+    u.reference_origin = (received_traj_) ? traj_origin_ : planner_origin_;
+    u.trace = tracker_trace_;
+    u.trace.push_back(ros::Time::now());
+
     // Publish control.
-    control_pub_.publish(value_.OptimalControl(tracker_x_, planner_x_).ToRos(
-      value_.Priority(tracker_x_, planner_x_)));
+    control_pub_.publish(u);
   }
 
   // Most recent tracker/planner states.
@@ -139,6 +192,16 @@ private:
   bool received_tracker_x_;
   bool received_planner_x_;
 
+  // Latency tracing information for the most recent tracker/planner states.
+  ros::Time tracker_origin_;
+  std::vector<ros::Time> tracker_trace_;
+  ros::Time planner_origin_;
+
+  // Most recent planner trajectory, if we are following one, and its origin.
+  Trajectory<PS> traj_;
+  ros::Time traj_origin_;
+  bool received_traj_;
+
   // Value function.
   V value_;
 
@@ -149,12 +212,16 @@ private:
   std::string ready_topic_;
   std::string tracker_state_topic_;
   std::string planner_state_topic_;
+  std::string traced_tracker_state_topic_;
+  std::string traced_planner_state_topic_;
+  std::string traj_topic_;
   std::string control_topic_;
   std::string bound_topic_;
 
   ros::Subscriber ready_sub_;
   ros::Subscriber tracker_state_sub_;
   ros::Subscriber planner_state_sub_;
+  ros::Subscriber traj_sub_;
   ros::Publisher control_pub_;
   ros::Publisher bound_pub_;
 
@@ -222,6 +289,13 @@ bool Tracker<V, TS, TC, PS, SB, SP>::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("topic/control", control_topic_)) return false;
   if (!nl.getParam("vis/bound", bound_topic_)) return false;
 
+  // Trajectory topic is optional. If empty, only use the reference topic.
+  nl.getParam("topic/traj", traj_topic_);
+
+  // Traced state topics are optional. If given, they replace the plain ones.
+  nl.getParam("topic/traced_tracker_state", traced_tracker_state_topic_);
+  nl.getParam("topic/traced_planner_state", traced_planner_state_topic_);
+
   // Service names.
   if (!nl.getParam("srv/bound", bound_name_)) return false;
   if (!nl.getParam("srv/planner_dynamics", planner_dynamics_name_))
@@ -251,10 +325,26 @@ bool Tracker<V, TS, TC, PS, SB, SP>::RegisterCallbacks(const ros::NodeHandle& n)
   // Subscribers.
   ready_sub_ = nl.subscribe(ready_topic_.c_str(), 1,
     &Tracker<V, TS, TC, PS, SB, SP>::ReadyCallback, this);
-  planner_state_sub_ = nl.subscribe(planner_state_topic_.c_str(), 1,
-    &Tracker<V, TS, TC, PS, SB, SP>::PlannerStateCallback, this);
-  tracker_state_sub_ = nl.subscribe(tracker_state_topic_.c_str(), 1,
-    &Tracker<V, TS, TC, PS, SB, SP>::TrackerStateCallback, this);
+  if (traced_planner_state_topic_.empty()) {
+    planner_state_sub_ = nl.subscribe(planner_state_topic_.c_str(), 1,
+      &Tracker<V, TS, TC, PS, SB, SP>::PlannerStateCallback, this);
+  } else {
+    planner_state_sub_ = nl.subscribe(traced_planner_state_topic_.c_str(), 1,
+      &Tracker<V, TS, TC, PS, SB, SP>::TracedPlannerStateCallback, this);
+  }
+
+  if (traced_tracker_state_topic_.empty()) {
+    tracker_state_sub_ = nl.subscribe(tracker_state_topic_.c_str(), 1,
+      &Tracker<V, TS, TC, PS, SB, SP>::TrackerStateCallback, this);
+  } else {
+    tracker_state_sub_ = nl.subscribe(traced_tracker_state_topic_.c_str(), 1,
+      &Tracker<V, TS, TC, PS, SB, SP>::TracedTrackerStateCallback, this);
+  }
+
+  if (!traj_topic_.empty()) {
+    traj_sub_ = nl.subscribe(traj_topic_.c_str(), 1,
+      &Tracker<V, TS, TC, PS, SB, SP>::TrajectoryCallback, this);
+  }
 
   // Publishers.
   control_pub_ = nl.advertise<fastrack_msgs::Control>(
@@ -75,6 +75,12 @@ public:
   // Construct from a ROS message.
   explicit Trajectory(const fastrack_msgs::Trajectory::ConstPtr& msg);
 
+  // Returns true if the given ROS message holds no states, in either the
+  // per-state or the packed layout.
+  static bool IsEmpty(const fastrack_msgs::Trajectory& msg) {
+    return msg.times.empty();
+  }
+
   // Size (number of states in this Trajectory).
   inline size_t Size() const { return states_.size(); }
 
@@ -100,6 +106,10 @@ public:
   // Convert to a ROS message.
   fastrack_msgs::Trajectory ToRos() const;
 
+  // Convert to a ROS message in the packed layout, writing into the given
+  // message and reusing its buffers. Much cheaper for long trajectories.
+  void ToPackedRos(fastrack_msgs::Trajectory* msg) const;
+
   // Visualize this trajectory.
   void Visualize(const ros::Publisher& pub, const std::string& frame) const;
 
@@ -177,6 +187,33 @@ Trajectory<S>::Trajectory(const std::vector<S>& states,
 template<typename S>
 Trajectory<S>::Trajectory(const fastrack_msgs::Trajectory::ConstPtr& msg)
   : configuration_(false) {
+  // Packed layout.
+  if (!msg->packed.empty()) {
+    const size_t dimension = msg->dimension;
+    size_t num_elements = (dimension > 0) ? msg->packed.size() / dimension : 0;
+
+    // Get size carefully.
+    if (num_elements * dimension != msg->packed.size() ||
+        num_elements != msg->times.size()) {
+      ROS_ERROR("Trajectory: packed states/times are not the same length.");
+      num_elements = std::min(num_elements, msg->times.size());
+    }
+
+    // Unpack message, reusing one State msg.
+    states_.reserve(num_elements);
+    fastrack_msgs::State state;
+    for (size_t ii = 0; ii < num_elements; ii++) {
+      const auto first = msg->packed.begin() + ii * dimension;
+      state.x.assign(first, first + dimension);
+      states_.emplace_back(state);
+    }
+
+    times_.assign(msg->times.begin(), msg->times.begin() + num_elements);
+    configuration_ =
+      num_elements > 0 && dimension == S::ConfigurationDimension();
+    return;
+  }
+
   size_t num_elements = msg->states.size();
 
   // Get size carefully.
@@ -186,6 +223,8 @@ Trajectory<S>::Trajectory(const fastrack_msgs::Trajectory::ConstPtr& msg)
   }
 
   // Unpack message.
+  states_.reserve(num_elements);
+  times_.reserve(num_elements);
   for (size_t ii = 0; ii < num_elements; ii++) {
     states_.push_back(S(msg->states[ii]));
     times_.push_back(msg->times[ii]);
@@ -259,15 +298,28 @@ void Trajectory<S>::ResetFirstTime(double t) {
 template<typename S>
 fastrack_msgs::Trajectory Trajectory<S>::ToRos() const {
   fastrack_msgs::Trajectory msg;
+  msg.states.reserve(states_.size());
 
-  for (size_t ii = 0; ii < states_.size(); ii++) {
+  for (size_t ii = 0; ii < states_.size(); ii++)
     msg.states.push_back(states_[ii].ToRos());
-    msg.times.push_back(times_[ii]);
-  }
 
+  msg.times = times_;
   return msg;
 }
 
+// Convert to a ROS message in the packed layout, writing into the given
+// message and reusing its buffers.
+template<typename S>
+void Trajectory<S>::ToPackedRos(fastrack_msgs::Trajectory* msg) const {
+  msg->states.clear();
+  msg->times.assign(times_.begin(), times_.end());
+
+  msg->dimension = (states_.empty()) ? 0 : states_.front().PackedDimension();
+  msg->packed.resize(msg->dimension * states_.size());
+  for (size_t ii = 0; ii < states_.size(); ii++)
+    states_[ii].Pack(msg->packed.data() + ii * msg->dimension);
+}
+
 
 // Visualize this trajectory.
 template<typename S>
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Coarse cost-to-go field over position. A uniform 26-connected grid covers
+// the state space box, and each cell stores its shortest-path distance to the
+// goal cell through cells marked free. Lookups are a single index.
+//
+// Distances are maintained incrementally, as in Lifelong Planning A* / D*
+// Lite with a zero heuristic: when cells change between free and blocked,
+// only the cells whose distance actually changes are re-expanded.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_COST_TO_GO_FIELD_H
+#define FASTRACK_UTILS_COST_TO_GO_FIELD_H
+
+#include <fastrack/utils/types.h>
+
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace fastrack {
+
+class CostToGoField {
+ public:
+  ~CostToGoField() {}
+  explicit CostToGoField(const Vector3d& lower, const Vector3d& upper,
+                         double resolution);
+
+  // Set the goal and recompute the whole field. Returns false if the goal is
+  // outside the grid.
+  bool SetGoal(const Vector3d& goal);
+
+  // Mark the cell containing the given point free or blocked. Changes take
+  // effect on the next call to Update.
+  void SetBlocked(const Vector3d& p, bool blocked);
+
+  // Re-classify every cell by checking its center with the given functor,
+  // which returns true if the point is free, and then repair the field.
+  // Returns the number of cells which changed.
+  template <typename F>
+  size_t Classify(const F& is_free);
+
+  // Repair the field after cells changed. Returns the number of cells
+  // expanded.
+  size_t Update();
+
+  // Cost-to-go at the given point. Infinite if the point is outside the
+  // grid, blocked, or cut off from the goal.
+  double Value(const Vector3d& p) const {
+    size_t idx;
+    return (Index(p, &idx)) ? g_[idx] : constants::kInfinity;
+  }
+
+  // Whether the goal is set and free, i.e. whether Value means anything.
+  bool HasGoal() const { return has_goal_ && !blocked_[goal_idx_]; }
+
+  // Number of cells.
+  size_t NumCells() const { return g_.size(); }
+
+ private:
+  // Index of the cell containing the given point. Returns false if the point
+  // is outside the grid.
+  bool Index(const Vector3d& p, size_t* idx) const;
+
+  // Center of the cell with the given index.
+  Vector3d Center(size_t idx) const;
+
+  // Mark a cell blocked or free, and queue it and its neighbors for repair.
+  void SetCellBlocked(size_t idx, bool blocked);
+
+  // Call f(neighbor, edge_cost) for each neighbor of the given cell. Runs
+  // in place, since this is the innermost loop of every repair.
+  template <typename F>
+  void ForEachNeighbor(size_t idx, const F& f) const;
+
+  // Recompute the one-step lookahead value of a cell and queue it if it is
+  // inconsistent.
+  void UpdateCell(size_t idx);
+
+  // Lower corner, cell size, and number of cells along each axis.
+  const Vector3d lower_;
+  const double resolution_;
+  size_t dims_[3];
+
+  // Per-cell distance, one-step lookahead distance, and occupancy.
+  std::vector<double> g_;
+  std::vector<double> rhs_;
+  std::vector<bool> blocked_;
+
+  // Goal cell.
+  bool has_goal_;
+  size_t goal_idx_;
+
+  // Min-heap of (key, cell). Entries are never removed, so stale ones are
+  // skipped when popped.
+  typedef std::pair<double, size_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue_;
+};  //\class CostToGoField
+
+// ----------------------------- IMPLEMENTATION ----------------------------- //
+
+// Re-classify every cell by checking its center with the given functor,
+// which returns true if the point is free, and then repair the field.
+// Returns the number of cells which changed.
+template <typename F>
+size_t CostToGoField::Classify(const F& is_free) {
+  size_t num_changed = 0;
+  for (size_t ii = 0; ii < NumCells(); ii++) {
+    const bool blocked = !is_free(Center(ii));
+    if (blocked != blocked_[ii]) {
+      SetCellBlocked(ii, blocked);
+      num_changed++;
+    }
+  }
+
+  Update();
+  return num_changed;
+}
+
+// Call f(neighbor, edge_cost) for each neighbor of the given cell.
+template <typename F>
+void CostToGoField::ForEachNeighbor(size_t idx, const F& f) const {
+  const long ix = idx % dims_[0];
+  const long iy = (idx / dims_[0]) % dims_[1];
+  const long iz = idx / (dims_[0] * dims_[1]);
+
+  for (long dz = -1; dz <= 1; dz++) {
+    const long jz = iz + dz;
+    if (jz < 0 || jz >= static_cast<long>(dims_[2])) continue;
+
+    for (long dy = -1; dy <= 1; dy++) {
+      const long jy = iy + dy;
+      if (jy < 0 || jy >= static_cast<long>(dims_[1])) continue;
+
+      for (long dx = -1; dx <= 1; dx++) {
+        const long jx = ix + dx;
+        if (jx < 0 || jx >= static_cast<long>(dims_[0])) continue;
+        if (dx == 0 && dy == 0 && dz == 0) continue;
+
+        f(jx + dims_[0] * (jy + dims_[1] * jz),
+          resolution_ *
+              std::sqrt(static_cast<double>(dx * dx + dy * dy + dz * dz)));
+      }
+    }
+  }
+}
+
+}  //\namespace fastrack
+
+#endif
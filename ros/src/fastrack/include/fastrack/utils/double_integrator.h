@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Closed-form steering for a one-dimensional double integrator with bounded
+// acceleration and velocity. Profiles consist of (at most) three phases:
+// accelerate to a cruise velocity, coast, and accelerate to the final
+// velocity. Both the minimum-time profile and a profile of a given (longer)
+// duration may be computed, the latter to synchronize several axes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_DOUBLE_INTEGRATOR_H
+#define FASTRACK_UTILS_DOUBLE_INTEGRATOR_H
+
+namespace fastrack {
+
+struct DoubleIntegratorProfile {
+  // Initial position and velocity.
+  double x0 = 0.0;
+  double v0 = 0.0;
+
+  // Signed acceleration and duration of the first phase, cruise velocity and
+  // duration of the coasting phase, and signed acceleration and duration of
+  // the last phase.
+  double a1 = 0.0;
+  double t1 = 0.0;
+  double v_cruise = 0.0;
+  double t2 = 0.0;
+  double a3 = 0.0;
+  double t3 = 0.0;
+
+  // Total duration.
+  double Duration() const { return t1 + t2 + t3; }
+
+  // Position and velocity at the given time since the start of the profile.
+  // Times outside [0, Duration()] are clamped.
+  void Evaluate(double t, double* x, double* v) const;
+};  //\struct DoubleIntegratorProfile
+
+// Minimum-time profile from (x0, v0) to (x1, v1), with |a| <= a_max and
+// v_min <= v <= v_max. Requires v_min < 0 < v_max and both boundary
+// velocities within bounds. Returns false if these do not hold.
+bool MinimumTimeProfile(double x0, double v0, double x1, double v1,
+                        double v_min, double v_max, double a_max,
+                        DoubleIntegratorProfile* profile);
+
+// Profile from (x0, v0) to (x1, v1) taking exactly the given duration, under
+// the same bounds. Returns false if there is no such profile, which may
+// happen even for durations above the minimum time.
+bool FixedTimeProfile(double x0, double v0, double x1, double v1,
+                      double v_min, double v_max, double a_max,
+                      double duration, DoubleIntegratorProfile* profile);
+
+}  // namespace fastrack
+
+#endif
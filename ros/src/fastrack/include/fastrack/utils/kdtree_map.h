@@ -41,6 +41,9 @@
 // Eigen vector (fixed size) keys and return nearest neighbors as key-value
 // pairs.
 //
+// Unlike SearchableSet, searches here are always exact, since environments
+// use them for collision checks.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_UTILS_KDTREE_MAP_H
@@ -62,6 +65,11 @@ class KdtreeMap : private Uncopyable {
   ~KdtreeMap() {}
   explicit KdtreeMap() {}
 
+  // Copy all entries into a new index, e.g. for environment snapshots.
+  KdtreeMap(const KdtreeMap& other) : registry_(other.registry_) {
+    for (size_t ii = 0; ii < registry_.size(); ii++) AddToIndex(ii);
+  }
+
   // Insert a new pair into the kdtree.
   bool Insert(const std::pair<VectorKd, V>& entry);
   bool Insert(const VectorKd& key, const V& value) {
@@ -92,6 +100,9 @@ class KdtreeMap : private Uncopyable {
   size_t Size() const { return registry_.size(); }
 
  private:
+  // Add the registry entry with the given index to the kdtree.
+  void AddToIndex(size_t idx);
+
   // A Flann kdtree. Searches in this index return indices, which are then
   // mapped to key-value pairs.
   std::unique_ptr<flann::KDTreeIndex<flann::L2<double>>> index_;
@@ -105,9 +116,16 @@ template <int K, typename V>
 bool KdtreeMap<K, V>::Insert(const std::pair<VectorKd, V>& entry) {
   // Append to registry.
   registry_.push_back(entry);
+  AddToIndex(registry_.size() - 1);
+
+  return true;
+}
 
+// Add the registry entry with the given index to the kdtree.
+template <int K, typename V>
+void KdtreeMap<K, V>::AddToIndex(size_t idx) {
   // Create a FLANN-specific matrix for the key.
-  flann::Matrix<double> flann_point(registry_.back().first.data(), 1, K);
+  flann::Matrix<double> flann_point(registry_[idx].first.data(), 1, K);
 
   // If this is the first point in the index, create the index and exit.
   if (index_ == nullptr) {
@@ -122,8 +140,6 @@ bool KdtreeMap<K, V>::Insert(const std::pair<VectorKd, V>& entry) {
     constexpr float kRebuildThreshold = 2.0;
     index_->addPoints(flann_point, kRebuildThreshold);
   }
-
-  return true;
 }
 
 // Nearest neighbor search.
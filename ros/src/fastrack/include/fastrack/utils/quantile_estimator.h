@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Running quantile estimator over a sliding window of the most recent scalar
+// samples, e.g. to track the p99 latency of a recurring operation.
+//
+// A sorted copy of the window is maintained as samples are added, so that
+// queries are constant time and may be made at a high rate.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_QUANTILE_ESTIMATOR_H
+#define FASTRACK_UTILS_QUANTILE_ESTIMATOR_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace fastrack {
+
+class QuantileEstimator {
+ public:
+  ~QuantileEstimator() {}
+  explicit QuantileEstimator(size_t window_size = 100)
+    : window_size_(window_size),
+      next_idx_(0) {
+    samples_.reserve(window_size_);
+    sorted_.reserve(window_size_);
+  }
+
+  // Add a new sample, overwriting the oldest one once the window is full.
+  // Linear in the window size.
+  void Add(double sample);
+
+  // Estimate the given quantile (in [0, 1]) of the samples in the window.
+  // Returns NaN if there are no samples. Constant time.
+  double Quantile(double q) const;
+
+  // Number of samples currently in the window.
+  size_t Size() const { return samples_.size(); }
+
+  // Discard all samples.
+  void Clear() {
+    samples_.clear();
+    sorted_.clear();
+    next_idx_ = 0;
+  }
+
+ private:
+  // Ring buffer of samples.
+  size_t window_size_;
+  size_t next_idx_;
+  std::vector<double> samples_;
+
+  // The same samples, in sorted order.
+  std::vector<double> sorted_;
+};  //\class QuantileEstimator
+
+}  // namespace fastrack
+
+#endif
@@ -41,6 +41,10 @@
 // themselves templated on the state type (S) and allow for nearest neighbor
 // and radius searches.
 //
+// Searches are exact by default. Since planners usually only need plausible
+// neighbors, NeighborSearchParams can trade recall for speed by building
+// several randomized trees and bounding the number of leaves checked.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_UTILS_SEARCHABLE_SET_H
@@ -54,11 +58,25 @@
 
 namespace fastrack {
 
+// Approximate search settings. The defaults give exact search.
+struct NeighborSearchParams {
+  // Number of randomized kd-trees.
+  int num_trees = 1;
+
+  // Maximum number of leaves to check per query, or FLANN_CHECKS_UNLIMITED.
+  int checks = FLANN_CHECKS_UNLIMITED;
+
+  // Returned neighbors are within a factor (1 + eps) of the true distances.
+  float eps = 0.0;
+};  //\struct NeighborSearchParams
+
 template <typename N, typename S>
 class SearchableSet : private Uncopyable {
  public:
   ~SearchableSet();
-  explicit SearchableSet(const typename N::Ptr& node);
+  explicit SearchableSet(
+      const typename N::Ptr& node,
+      const NeighborSearchParams& params = NeighborSearchParams());
 
   // Access the initial node.
   inline typename N::Ptr InitialNode() const { return registry_.front(); }
@@ -78,6 +96,9 @@ class SearchableSet : private Uncopyable {
   // TODO: fix the distance metric to be something more intelligent.
   std::unique_ptr<flann::KDTreeIndex<flann::L2<double> > > index_;
   std::vector<typename N::Ptr> registry_;
+
+  // Search settings.
+  const NeighborSearchParams params_;
 };
 
 // ------------------------------ IMPLEMENTATION -----------------------------
@@ -97,7 +118,9 @@ SearchableSet<N, S>::~SearchableSet() {
 
 // Construct from a single node.
 template <typename N, typename S>
-SearchableSet<N, S>::SearchableSet(const typename N::Ptr& node) {
+SearchableSet<N, S>::SearchableSet(const typename N::Ptr& node,
+                                   const NeighborSearchParams& params)
+    : params_(params) {
   if (!node.get()) {
     ROS_WARN("SearchableSet: Constructing without initial node.");
   } else {
@@ -121,10 +144,8 @@ bool SearchableSet<N, S>::Insert(const typename N::Ptr& node) {
 
   // If this is the first point in the index, create the index and exit.
   if (index_ == nullptr) {
-    // Single kd-tree.
-    const int kNumTrees = 1;
     index_.reset(new flann::KDTreeIndex<flann::L2<double> >(
-        flann_point, flann::KDTreeIndexParams(kNumTrees)));
+        flann_point, flann::KDTreeIndexParams(params_.num_trees)));
 
     index_->buildIndex();
   } else {
@@ -160,7 +181,8 @@ std::vector<typename N::Ptr> SearchableSet<N, S>::KnnSearch(const S& query,
 
   const int num_neighbors_found = index_->knnSearch(
       flann_query, query_match_indices, query_squared_distances,
-      static_cast<int>(k), flann::SearchParams(-1, 0.0, false));
+      static_cast<int>(k),
+      flann::SearchParams(params_.checks, params_.eps, false));
 
   // Assign output.
   std::vector<typename N::Ptr> neighbors;
@@ -190,7 +212,7 @@ std::vector<typename N::Ptr> SearchableSet<N, S>::RadiusSearch(const S& query,
   // FLANN checks Euclidean distance squared, so we pass in r * r.
   int num_neighbors_found = index_->radiusSearch(
       flann_query, query_match_indices, query_squared_distances, r * r,
-      flann::SearchParams(-1, 0.0, false));
+      flann::SearchParams(params_.checks, params_.eps, false));
   // Assign output.
   std::vector<typename N::Ptr> neighbors;
   for (size_t ii = 0; ii < num_neighbors_found; ii++)
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Compact binary log of everything a planner process sees during a session:
+// replan requests, sensor messages, tracking bound and dynamics service
+// responses, and random seeds. Each record is a ROS-serialized message,
+// prefixed by its type, time stamp, and length. Sessions may be replayed
+// deterministically with the SessionReplayer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_SESSION_LOG_H
+#define FASTRACK_UTILS_SESSION_LOG_H
+
+#include <fastrack/utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fastrack {
+
+// Types of records in a session log.
+enum SessionRecordType : uint8_t {
+  SEED = 0,
+  BOUND = 1,
+  DYNAMICS = 2,
+  SENSOR = 3,
+  REPLAN_REQUEST = 4,
+  RAYS = 5
+};
+
+// A single record in a session log.
+struct SessionRecord {
+  SessionRecordType type;
+  ros::Time stamp;
+  std::vector<uint8_t> data;
+
+  // Deserialize into the given message type.
+  template <typename M>
+  M Deserialize() const {
+    M msg;
+    ros::serialization::IStream stream(const_cast<uint8_t*>(data.data()),
+                                       static_cast<uint32_t>(data.size()));
+    ros::serialization::deserialize(stream, msg);
+    return msg;
+  }
+};  //\struct SessionRecord
+
+class SessionRecorder : private Uncopyable {
+ public:
+  ~SessionRecorder() { Close(); }
+  explicit SessionRecorder() {}
+
+  // Open and close a file. Open returns bool upon success.
+  bool Open(const std::string& file_name);
+  void Close();
+
+  // Is this recorder open?
+  bool IsOpen() const { return file_.is_open(); }
+
+  // Append a message of the given type, stamped with the current time.
+  template <typename M>
+  void Record(SessionRecordType type, const M& msg);
+
+ private:
+  // Write a raw record.
+  void Write(SessionRecordType type, const ros::Time& stamp,
+             const std::vector<uint8_t>& data);
+
+  // Records may arrive from multiple threads.
+  std::mutex mutex_;
+  std::ofstream file_;
+
+  // Records are buffered by the stream, and only flushed to disk now and
+  // then (and on close), rather than after every record.
+  std::chrono::steady_clock::time_point last_flush_;
+};  //\class SessionRecorder
+
+class SessionReader : private Uncopyable {
+ public:
+  ~SessionReader() {}
+  explicit SessionReader() {}
+
+  // Open a file. Returns bool upon success.
+  bool Open(const std::string& file_name);
+
+  // Read the next record. Returns false at the end of the file or on error.
+  bool Next(SessionRecord* record);
+
+ private:
+  std::ifstream file_;
+};  //\class SessionReader
+
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+// Append a message of the given type, stamped with the current time.
+template <typename M>
+void SessionRecorder::Record(SessionRecordType type, const M& msg) {
+  if (!IsOpen()) return;
+
+  // Serialize into a buffer.
+  std::vector<uint8_t> data(ros::serialization::serializationLength(msg));
+  ros::serialization::OStream stream(data.data(),
+                                     static_cast<uint32_t>(data.size()));
+  ros::serialization::serialize(stream, msg);
+
+  Write(type, ros::Time::now(), data);
+}
+
+}  // namespace fastrack
+
+#endif
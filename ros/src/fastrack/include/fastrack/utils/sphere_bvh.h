@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SphereBvh class, a bounding volume hierarchy over a set of
+// spheres for ray casting. Nodes are axis-aligned boxes split at the median
+// along their longest axis. Leaves hold a small block of spheres stored as a
+// structure of arrays (like SphereArray), and the ray-sphere test over a leaf
+// is branch-free so that it vectorizes.
+//
+// The hierarchy is immutable once built and may be queried from many threads
+// at once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_SPHERE_BVH_H
+#define FASTRACK_UTILS_SPHERE_BVH_H
+
+#include <fastrack/bound/sphere_overlap_kernels.h>
+#include <fastrack/utils/types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace fastrack {
+
+using bound::SphereArray;
+
+class SphereBvh {
+ public:
+  ~SphereBvh() {}
+  explicit SphereBvh() {}
+  explicit SphereBvh(const SphereArray& spheres) { Build(spheres); }
+
+  // Rebuild the hierarchy over the given spheres.
+  void Build(const SphereArray& spheres);
+
+  // Distance along the (unit) direction from the origin to the first sphere
+  // surface, if it is closer than 'max_distance'. Otherwise returns
+  // 'max_distance'. Rays starting inside a sphere hit at zero.
+  double Raycast(const Vector3d& origin, const Vector3d& direction,
+                 double max_distance) const;
+
+  // Number of spheres and nodes.
+  size_t NumSpheres() const { return spheres_.Size(); }
+  size_t NumNodes() const { return nodes_.size(); }
+
+ private:
+  // Maximum number of spheres in a leaf.
+  static constexpr size_t kLeafSize = 8;
+
+  // A node is a leaf if 'count' is nonzero, and then holds spheres
+  // [first, first + count). Otherwise its children are 'first' and
+  // 'first + 1'.
+  struct Node {
+    Vector3d lower;
+    Vector3d upper;
+    uint32_t first;
+    uint32_t count;
+  };  //\struct Node
+
+  // Recursively build the node at the given index over spheres
+  // [begin, end) of 'order_'.
+  void BuildNode(size_t idx, size_t begin, size_t end,
+                 const SphereArray& spheres);
+
+  // Entry distance of the ray into the given node's box, or infinity if it
+  // misses within [0, max_distance].
+  static double EnterBox(const Node& node, const Vector3d& origin,
+                         const Vector3d& inverse_direction,
+                         double max_distance);
+
+  // Nearest hit among the spheres in a leaf, or 'max_distance'.
+  double RaycastLeaf(const Node& node, const Vector3d& origin,
+                     const Vector3d& direction, double max_distance) const;
+
+  // Nodes, with the root at index zero.
+  std::vector<Node> nodes_;
+
+  // Spheres, reordered so that every leaf is contiguous.
+  SphereArray spheres_;
+
+  // Scratch ordering of the input spheres during construction.
+  std::vector<size_t> order_;
+};  //\class SphereBvh
+
+// ---------------------------- IMPLEMENTATION  ---------------------------- //
+
+inline void SphereBvh::Build(const SphereArray& spheres) {
+  nodes_.clear();
+  spheres_ = SphereArray();
+  if (spheres.Size() == 0) return;
+
+  order_.resize(spheres.Size());
+  std::iota(order_.begin(), order_.end(), 0);
+
+  nodes_.reserve(2 * spheres.Size() / kLeafSize + 1);
+  nodes_.emplace_back();
+  BuildNode(0, 0, spheres.Size(), spheres);
+
+  // Copy spheres in leaf order.
+  for (const size_t ii : order_) spheres_.Add(spheres.Center(ii), spheres.r[ii]);
+
+  order_.clear();
+}
+
+inline void SphereBvh::BuildNode(size_t idx, size_t begin, size_t end,
+                                 const SphereArray& spheres) {
+  // Bounding box of the spheres, and of their centers.
+  Vector3d lower = Vector3d::Constant(std::numeric_limits<double>::infinity());
+  Vector3d upper = -lower;
+  Vector3d center_lower = lower;
+  Vector3d center_upper = upper;
+  for (size_t ii = begin; ii < end; ii++) {
+    const Vector3d center = spheres.Center(order_[ii]);
+    const Vector3d radius = Vector3d::Constant(spheres.r[order_[ii]]);
+    lower = lower.cwiseMin(center - radius);
+    upper = upper.cwiseMax(center + radius);
+    center_lower = center_lower.cwiseMin(center);
+    center_upper = center_upper.cwiseMax(center);
+  }
+
+  nodes_[idx].lower = lower;
+  nodes_[idx].upper = upper;
+
+  if (end - begin <= kLeafSize) {
+    nodes_[idx].first = static_cast<uint32_t>(begin);
+    nodes_[idx].count = static_cast<uint32_t>(end - begin);
+    return;
+  }
+
+  // Split at the median center along the longest axis of the centers.
+  size_t axis;
+  (center_upper - center_lower).maxCoeff(&axis);
+
+  const size_t middle = begin + (end - begin) / 2;
+  std::nth_element(order_.begin() + begin, order_.begin() + middle,
+                   order_.begin() + end,
+                   [&spheres, axis](size_t a, size_t b) {
+                     return spheres.Center(a)(axis) < spheres.Center(b)(axis);
+                   });
+
+  const size_t first_child = nodes_.size();
+  nodes_.emplace_back();
+  nodes_.emplace_back();
+  nodes_[idx].first = static_cast<uint32_t>(first_child);
+  nodes_[idx].count = 0;
+
+  BuildNode(first_child, begin, middle, spheres);
+  BuildNode(first_child + 1, middle, end, spheres);
+}
+
+inline double SphereBvh::Raycast(const Vector3d& origin,
+                                 const Vector3d& direction,
+                                 double max_distance) const {
+  if (nodes_.empty()) return max_distance;
+
+  const Vector3d inverse_direction = direction.cwiseInverse();
+
+  // Depth-first, nearer child first, skipping boxes beyond the nearest hit.
+  constexpr size_t kMaxStackSize = 64;
+  uint32_t stack[kMaxStackSize];
+  size_t stack_size = 0;
+
+  double nearest = max_distance;
+  if (EnterBox(nodes_[0], origin, inverse_direction, nearest) < nearest)
+    stack[stack_size++] = 0;
+
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+    if (node.count > 0) {
+      nearest = RaycastLeaf(node, origin, direction, nearest);
+      continue;
+    }
+
+    const double t0 =
+        EnterBox(nodes_[node.first], origin, inverse_direction, nearest);
+    const double t1 =
+        EnterBox(nodes_[node.first + 1], origin, inverse_direction, nearest);
+
+    // Push the farther child first so the nearer one is visited first.
+    const bool first_is_nearer = t0 <= t1;
+    const double t_far = first_is_nearer ? t1 : t0;
+    const double t_near = first_is_nearer ? t0 : t1;
+    const uint32_t far = node.first + (first_is_nearer ? 1 : 0);
+    const uint32_t near = node.first + (first_is_nearer ? 0 : 1);
+
+    if (t_far < nearest && stack_size < kMaxStackSize) stack[stack_size++] = far;
+    if (t_near < nearest && stack_size < kMaxStackSize)
+      stack[stack_size++] = near;
+  }
+
+  return nearest;
+}
+
+inline double SphereBvh::EnterBox(const Node& node, const Vector3d& origin,
+                                  const Vector3d& inverse_direction,
+                                  double max_distance) {
+  // Slab test.
+  const Vector3d t_lower =
+      (node.lower - origin).cwiseProduct(inverse_direction);
+  const Vector3d t_upper =
+      (node.upper - origin).cwiseProduct(inverse_direction);
+  const double t_enter =
+      std::max(t_lower.cwiseMin(t_upper).maxCoeff(), 0.0);
+  const double t_exit = std::min(t_lower.cwiseMax(t_upper).minCoeff(),
+                                 max_distance);
+
+  return (t_enter <= t_exit) ? t_enter
+                             : std::numeric_limits<double>::infinity();
+}
+
+inline double SphereBvh::RaycastLeaf(const Node& node, const Vector3d& origin,
+                                     const Vector3d& direction,
+                                     double max_distance) const {
+  const double ox = origin(0), oy = origin(1), oz = origin(2);
+  const double dx = direction(0), dy = direction(1), dz = direction(2);
+
+  const double* xs = spheres_.x.data() + node.first;
+  const double* ys = spheres_.y.data() + node.first;
+  const double* zs = spheres_.z.data() + node.first;
+  const double* rs = spheres_.r.data() + node.first;
+
+  // For each sphere, solve |o + t d - c|^2 = r^2 for the smaller root. The
+  // ray starts inside if the constant term is negative.
+  double nearest = max_distance;
+  for (size_t ii = 0; ii < node.count; ii++) {
+    const double cx = xs[ii] - ox;
+    const double cy = ys[ii] - oy;
+    const double cz = zs[ii] - oz;
+    const double b = cx * dx + cy * dy + cz * dz;
+    const double c = cx * cx + cy * cy + cz * cz - rs[ii] * rs[ii];
+    const double discriminant = b * b - c;
+    const double t = (c < 0.0) ? 0.0 : b - std::sqrt(std::max(discriminant, 0.0));
+    const bool hit = (discriminant >= 0.0) & (t >= 0.0);
+    nearest = (hit & (t < nearest)) ? t : nearest;
+  }
+
+  return nearest;
+}
+
+}  //\namespace fastrack
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ThreadPool class, a fixed set of worker threads which run
+// data-parallel loops. Unlike spawning threads per call, the workers persist
+// between calls, so this is suitable for work which repeats at a high rate
+// (e.g. simulating a sensor at its frame rate).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_THREAD_POOL_H
+#define FASTRACK_UTILS_THREAD_POOL_H
+
+#include <fastrack/utils/uncopyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fastrack {
+
+class ThreadPool : private Uncopyable {
+ public:
+  // Number of threads includes the calling thread, which also does work.
+  // Zero means one per hardware thread.
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  // Run f(begin, end) on consecutive chunks of [0, n), each of at most
+  // 'chunk_size' indices, across all threads. Blocks until every chunk is
+  // done. Calls from different threads are serialized.
+  void ParallelFor(size_t n, size_t chunk_size,
+                   const std::function<void(size_t, size_t)>& f);
+
+  // Total number of threads, including the calling thread.
+  size_t NumThreads() const { return workers_.size() + 1; }
+
+ private:
+  // Worker loop, and the chunk loop shared by workers and the caller.
+  void WorkerLoop();
+  void RunChunks();
+
+  // Worker threads.
+  std::vector<std::thread> workers_;
+
+  // Current loop. Workers wake up whenever 'generation_' changes.
+  const std::function<void(size_t, size_t)>* job_;
+  size_t job_size_;
+  size_t chunk_size_;
+  std::atomic<size_t> next_chunk_;
+  size_t generation_;
+  size_t num_busy_;
+  bool stop_;
+
+  std::mutex mutex_;
+  std::mutex call_mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+};  //\class ThreadPool
+
+// ---------------------------- IMPLEMENTATION  ---------------------------- //
+
+inline ThreadPool::ThreadPool(size_t num_threads)
+    : job_(nullptr),
+      job_size_(0),
+      chunk_size_(1),
+      next_chunk_(0),
+      generation_(0),
+      num_busy_(0),
+      stop_(false) {
+  if (num_threads == 0)
+    num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  for (size_t ii = 1; ii < num_threads; ii++)
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  work_cv_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+inline void ThreadPool::ParallelFor(
+    size_t n, size_t chunk_size,
+    const std::function<void(size_t, size_t)>& f) {
+  if (n == 0) return;
+
+  std::lock_guard<std::mutex> call_lock(call_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &f;
+    job_size_ = n;
+    chunk_size_ = std::max<size_t>(1, chunk_size);
+    next_chunk_ = 0;
+    num_busy_ = workers_.size();
+    generation_++;
+  }
+
+  work_cv_.notify_all();
+  RunChunks();
+
+  // Wait for the workers to finish their last chunks.
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return num_busy_ == 0; });
+  job_ = nullptr;
+}
+
+inline void ThreadPool::WorkerLoop() {
+  size_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this, seen_generation]() {
+        return stop_ || generation_ != seen_generation;
+      });
+
+      if (stop_) return;
+      seen_generation = generation_;
+    }
+
+    RunChunks();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_busy_ == 0) done_cv_.notify_one();
+  }
+}
+
+inline void ThreadPool::RunChunks() {
+  while (true) {
+    const size_t begin = chunk_size_ * next_chunk_++;
+    if (begin >= job_size_) return;
+
+    (*job_)(begin, std::min(job_size_, begin + chunk_size_));
+  }
+}
+
+}  //\namespace fastrack
+
+#endif
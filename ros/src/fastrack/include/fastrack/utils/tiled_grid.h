@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Out-of-core storage for a multi-channel grid, such as a value function and
+// its gradient. On disk, the grid is split into fixed-size tiles, preceded by
+// a coarse level which holds, for each block of cells downsampled by an
+// integer factor in every dimension, the minimum and maximum of every
+// channel over the block. The coarse level always stays in memory. Tiles are
+// paged in by a background thread into a small LRU cache.
+//
+// Lookups never block on disk or on the loader. A lookup in a tile which is
+// not resident (or while the loader holds the cache) returns the coarse
+// bounds instead, and requests the tile. Prefetch requests tiles ahead of
+// time.
+//
+// File layout, in native byte order:
+//   "FTTG", uint32 version, uint32 dimension D, uint32 channels C,
+//   uint64 num_cells[D], uint64 tile_cells[D], uint64 coarse_factor,
+//   coarse level (C minima then C maxima per coarse cell, row-major),
+//   tiles (row-major over tiles, each with C doubles per cell, row-major
+//   within the tile and padded to full size at the grid boundary).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_TILED_GRID_H
+#define FASTRACK_UTILS_TILED_GRID_H
+
+#include <fastrack/utils/uncopyable.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fastrack {
+
+class TiledGrid : private Uncopyable {
+ public:
+  ~TiledGrid();
+  explicit TiledGrid();
+
+  // Write a grid in the tiled format. Each channel holds one value per cell
+  // in row-major order. Returns whether or not writing was successful.
+  static bool Write(const std::string& file_name,
+                    const std::vector<size_t>& num_cells,
+                    const std::vector<const std::vector<double>*>& channels,
+                    const std::vector<size_t>& tile_cells,
+                    size_t coarse_factor);
+
+  // Convert a value function mat file (with 'num_cells', 'data' and
+  // 'deriv_<ii>' in every dimension) to a tiled file with the value and
+  // then the gradient as channels. Tiles have 'tile_cells' cells per side.
+  static bool WriteValueFunction(const std::string& mat_file_name,
+                                 const std::string& tile_file_name,
+                                 size_t tile_cells, size_t coarse_factor);
+
+  // Open a tiled file, keeping at most 'cache_size' tiles resident, and
+  // start the loader. Returns whether or not opening was successful.
+  bool Open(const std::string& file_name, size_t cache_size);
+
+  // Grid size and number of channels.
+  const std::vector<size_t>& NumCells() const { return num_cells_; }
+  size_t NumChannels() const { return num_channels_; }
+
+  // Read all channels at the cell with the given coordinates, without
+  // blocking. Returns true if the tile was resident, in which case 'lower'
+  // and 'upper' both hold the exact values. Otherwise they hold bounds on
+  // every channel over the coarse block containing the cell, and the tile is
+  // requested.
+  bool Lookup(const size_t* cell, double* lower, double* upper) const;
+
+  // Request the tile containing the given cell, if it is not resident.
+  // Never blocks. Requests are served newest first, so prefetch from the
+  // farthest cell to the nearest.
+  void Prefetch(const size_t* cell) const;
+
+  // Number of lookups which hit resident tiles or fell back.
+  size_t NumHits() const { return num_hits_.load(); }
+  size_t NumMisses() const { return num_misses_.load(); }
+
+ private:
+  // Index of the tile containing the given cell, and the offset (in cells)
+  // of the cell within that tile.
+  size_t TileIndex(const size_t* cell, size_t* offset) const;
+
+  // Read the coarse bounds at the given cell.
+  void CoarseLookup(const size_t* cell, double* lower, double* upper) const;
+
+  // Queue a tile for loading. Must hold 'cache_mutex_'.
+  void Request(size_t tile) const;
+
+  // Loader thread loop.
+  void LoaderLoop();
+
+  // Grid layout.
+  std::vector<size_t> num_cells_;
+  std::vector<size_t> tile_cells_;
+  std::vector<size_t> num_tiles_;
+  std::vector<size_t> num_coarse_cells_;
+  size_t num_channels_;
+  size_t coarse_factor_;
+  size_t cells_per_tile_;
+
+  // Coarse level, always resident, with 2 * 'num_channels_' values per
+  // coarse cell.
+  std::vector<double> coarse_;
+
+  // File, and byte offset of the first tile. Only the loader reads tiles.
+  std::ifstream file_;
+  std::streamoff tiles_offset_;
+
+  // LRU cache of resident tiles, with the most recently used at the front
+  // of 'lru_'.
+  struct CachedTile {
+    std::vector<double> data;
+    std::list<size_t>::iterator lru_position;
+  };  //\struct CachedTile
+
+  size_t cache_size_;
+  mutable std::unordered_map<size_t, CachedTile> tiles_;
+  mutable std::list<size_t> lru_;
+
+  // Tiles waiting to be loaded, newest at the back.
+  mutable std::deque<size_t> requests_;
+  mutable std::unordered_set<size_t> requested_;
+
+  // Statistics.
+  mutable std::atomic<size_t> num_hits_;
+  mutable std::atomic<size_t> num_misses_;
+
+  // Loader thread.
+  bool stop_;
+  mutable std::mutex cache_mutex_;
+  mutable std::condition_variable request_cv_;
+  std::thread loader_;
+};  //\class TiledGrid
+
+}  //\namespace fastrack
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Lock-free cache of whole-cell collision check results, tagged with the
+// environment version they were computed against. Positions are quantized
+// into cubic cells of the given resolution, and each cell hashes to a single
+// slot in a fixed-size table. Slots store the full cell key, so a lookup only
+// hits for exactly the cell that was inserted.
+//
+// A cell result is "valid" only if every position inside the cell is valid,
+// which callers establish with one conservative check at the cell center
+// using a tracking bound inflated by half the cell size (see
+// TrackingBound::Inflate). Otherwise the cell is "mixed" and callers fall
+// back to an exact check; nothing is ever cached as invalid.
+//
+// Each slot is guarded by a sequence counter. Readers treat a slot that is
+// being written, or changed while being read, as a miss. Writers skip the
+// insert if another writer holds the slot.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FASTRACK_UTILS_VALIDITY_CACHE_H
+#define FASTRACK_UTILS_VALIDITY_CACHE_H
+
+#include <fastrack/utils/types.h>
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+namespace fastrack {
+
+class ValidityCache {
+ public:
+  ~ValidityCache() {}
+  explicit ValidityCache(double resolution, size_t num_slots = 1 << 18);
+
+  // Look up the cell containing the given position for the given environment
+  // version. Returns true on a hit and sets 'cell_valid', which is true only
+  // if every position in the cell is valid.
+  bool Lookup(const Vector3d& p, unsigned int version, bool* cell_valid) const;
+
+  // Store the result for the cell containing the given position.
+  void Insert(const Vector3d& p, unsigned int version, bool cell_valid);
+
+  // Forget all results.
+  void Clear();
+
+  // Cell geometry.
+  double Resolution() const { return resolution_; }
+  Vector3d CellCenter(const Vector3d& p) const;
+
+  // Hit statistics since the last ResetStats.
+  size_t NumQueries() const { return num_queries_.load(); }
+  size_t NumHits() const { return num_hits_.load(); }
+  double HitRate() const {
+    const size_t num_queries = NumQueries();
+    return (num_queries > 0)
+               ? static_cast<double>(NumHits()) / num_queries : 0.0;
+  }
+  void ResetStats() {
+    num_queries_ = 0;
+    num_hits_ = 0;
+  }
+
+ private:
+  // Integer cell coordinates.
+  struct Cell {
+    int32_t index[3];
+  };  //\struct Cell
+
+  // One table entry. 'sequence' is odd while the entry is being written.
+  struct Slot {
+    std::atomic<uint32_t> sequence;
+    std::atomic<int32_t> index[3];
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> kind;
+  };  //\struct Slot
+
+  // Compute the cell containing a position. Returns false if the cell index
+  // does not fit, in which case the position is never cached.
+  bool CellOf(const Vector3d& p, Cell* cell) const;
+
+  // Slot a cell hashes to.
+  Slot& SlotOf(const Cell& cell) const;
+
+  // Overwrite a slot unless another writer holds it.
+  static void Write(Slot& slot, const Cell& cell, uint32_t version,
+                    uint32_t kind);
+
+  // Cell size.
+  const double resolution_;
+
+  // Number of slots is a power of two.
+  const size_t num_slots_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Hit statistics.
+  mutable std::atomic<size_t> num_queries_;
+  mutable std::atomic<size_t> num_hits_;
+};  //\class ValidityCache
+
+}  // namespace fastrack
+
+#endif
@@ -81,6 +81,17 @@ class AnalyticalKinematicBoxQuadrotorDecoupled6D
   ~AnalyticalKinematicBoxQuadrotorDecoupled6D() {}
   explicit AnalyticalKinematicBoxQuadrotorDecoupled6D() : ValueFunction() {}
 
+  // Initialize from tracker control bounds, maximum planner speed, and
+  // disturbance/expansion parameters. Returns whether or not initialization
+  // was successful. Can be used as an alternative to intialization from a
+  // NodeHandle.
+  bool InitializeFromParameters(const QuadrotorControl& tracker_lower,
+                                const QuadrotorControl& tracker_upper,
+                                const Vector3d& max_planner_speed,
+                                const Vector3d& velocity_disturbance,
+                                const Vector3d& acceleration_disturbance,
+                                const Vector3d& velocity_expansion);
+
   // Value and gradient at particular relative states.
   double Value(const PositionVelocity& vehicle_x,
                const PositionVelocity& planner_x) const;
@@ -89,6 +100,17 @@ class AnalyticalKinematicBoxQuadrotorDecoupled6D
       const PositionVelocity& vehicle_x,
       const PositionVelocity& planner_x) const;
 
+  // Statically typed gradient, returned by value. Does not allocate.
+  PositionVelocityRelPositionVelocity RelativeGradient(
+      const PositionVelocity& vehicle_x,
+      const PositionVelocity& planner_x) const;
+
+  // Get the optimal control given the vehicle state and planner state.
+  // Hides ValueFunction::OptimalControl and avoids both the heap-allocated
+  // gradient and the virtual relative dynamics call.
+  QuadrotorControl OptimalControl(const PositionVelocity& vehicle_x,
+                                  const PositionVelocity& planner_x) const;
+
   // Priority of the optimal control at the given vehicle and planner states.
   // This is a number between 0 and 1, where 1 means the final control signal
   // should be exactly the optimal control signal computed by this
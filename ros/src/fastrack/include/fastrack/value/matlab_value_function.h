@@ -44,6 +44,24 @@
 // NOTE: this class is templated on relative state (RS) and dynamics (RD)
 // whereas the base class ValueFunction is NOT.
 //
+// Optionally, the optimal control and priority may be precomputed at the
+// center of every grid cell. The relative dynamics must then split the
+// optimal control into a part which depends only on the value gradient
+// (RelativeOptimalControl) and a part which depends on the tracker and planner
+// states (CompleteOptimalControl). Cells where the tabulated control or
+// priority changes by more than a tolerance between neighbors, i.e. near
+// switching surfaces, and cells on the boundary of the grid fall back to
+// interpolating the gradient.
+//
+// Alternatively, the grid may be paged in from a tiled file (see TiledGrid)
+// so that it need not fit in memory. The mat file then only needs to hold
+// the metadata. Lookups in tiles which are not resident use coarse bounds on
+// the grid: the upper bound on the value, which is conservative, and the
+// middle of the bounds on the gradient. Value interpolation never takes a
+// finite difference between a coarse and a fine value. Tiles are prefetched
+// along the relative state's velocity, estimated from successive distinct
+// queries. The control table is not available in this mode.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef FASTRACK_VALUE_MATLAB_VALUE_FUNCTION_H
@@ -53,12 +71,18 @@
 #include <fastrack/dynamics/relative_dynamics.h>
 #include <fastrack/state/relative_state.h>
 #include <fastrack/utils/matlab_file_reader.h>
+#include <fastrack/utils/tiled_grid.h>
 #include <fastrack/utils/types.h>
 #include <fastrack/value/value_function.h>
 
 #include <ros/assert.h>
 #include <ros/ros.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 namespace fastrack {
 namespace value {
@@ -68,17 +92,45 @@ template <typename TS, typename TC, typename TD, typename PS, typename PC,
 class MatlabValueFunction : public ValueFunction<TS, TC, TD, PS, PC, PD, B> {
  public:
   ~MatlabValueFunction() {}
-  explicit MatlabValueFunction() : ValueFunction<TS, TC, TD, PS, PC, PD, B>() {}
+  explicit MatlabValueFunction()
+      : ValueFunction<TS, TC, TD, PS, PC, PD, B>(),
+        prefetch_steps_(10),
+        has_last_relative_x_(false) {}
 
   // Initialize from file. Returns whether or not loading was successful.
   // Can be used as an alternative to intialization from a NodeHandle.
   bool InitializeFromMatFile(const std::string& file_name);
 
+  // Initialize from a mat file with only metadata, and a tiled file with the
+  // value and gradient, keeping at most 'cache_size' tiles in memory.
+  bool InitializeFromTiles(const std::string& mat_file_name,
+                           const std::string& tile_file_name,
+                           size_t cache_size);
+  const TiledGrid* Tiles() const { return tiles_.get(); }
+
+  // Precompute the optimal control and priority at every grid cell. Neighbors
+  // whose controls (in any component) or priorities differ by more than
+  // 'tolerance' are marked invalid and use the gradient instead. Returns the
+  // fraction of cells which are valid, or a negative number on failure.
+  double BuildControlTable(double tolerance);
+  bool HasControlTable() const { return !control_table_.empty(); }
+
   // Value and gradient at particular relative states.
   double Value(const TS& tracker_x, const PS& planner_x) const;
   std::unique_ptr<RelativeState<TS, PS>> Gradient(const TS& tracker_x,
                                                   const PS& planner_x) const;
 
+  // Statically typed gradient, returned by value. Does not allocate.
+  RS RelativeGradient(const TS& tracker_x, const PS& planner_x) const;
+
+  // Get the optimal control given the tracker state and planner state.
+  // Hides ValueFunction::OptimalControl and dispatches statically on the
+  // relative state/dynamics and tracker control bound types, so this path
+  // never allocates. The virtual interface remains available through a
+  // ValueFunction pointer or reference. Uses the control table if it has
+  // been built and is valid at this relative state.
+  TC OptimalControl(const TS& tracker_x, const PS& planner_x) const;
+
   // Priority of the optimal control at the given tracker and planner states.
   // This is a number between 0 and 1, where 1 means the final control signal
   // should be exactly the optimal control signal computed by this
@@ -86,6 +138,23 @@ class MatlabValueFunction : public ValueFunction<TS, TC, TD, PS, PC, PD, B> {
   double Priority(const TS& tracker_x, const PS& planner_x) const;
 
  private:
+  // Fixed-size vector of relative state dimension. Grid computations below
+  // use this type so that they do not allocate.
+  typedef typename RS::FixedVector RelativeVector;
+
+  // Coordinates of a grid cell, and all channels stored at a cell in tiled
+  // mode (value first, then the gradient).
+  typedef std::array<size_t, RelativeVector::RowsAtCompileTime> GridCell;
+  typedef std::array<double, RelativeVector::RowsAtCompileTime + 1>
+      CellChannels;
+
+  // Precomputed optimal control and priority at a single grid cell.
+  struct ControlTableEntry {
+    TC control;
+    double priority;
+    bool valid;
+  };  //\struct ControlTableEntry
+
   // Load parameters.
   bool LoadParameters(const ros::NodeHandle& n) {
     ros::NodeHandle nl(n);
@@ -96,28 +165,80 @@ class MatlabValueFunction : public ValueFunction<TS, TC, TD, PS, PC, PD, B> {
     std::cout << "---------------------" << std::endl;
     std::cout << file_name << std::endl;
 
-    return InitializeFromMatFile(file_name);
+    // Tiled grid is optional.
+    std::string tile_file_name;
+    nl.getParam("tiles/file_name", tile_file_name);
+    if (!tile_file_name.empty()) {
+      int cache_size = 64;
+      nl.getParam("tiles/cache_size", cache_size);
+      nl.getParam("tiles/prefetch_steps", prefetch_steps_);
+      return InitializeFromTiles(file_name, tile_file_name,
+                                 static_cast<size_t>(std::max(1, cache_size)));
+    }
+
+    if (!InitializeFromMatFile(file_name)) return false;
+
+    // Control table is optional.
+    bool use_control_table = false;
+    nl.getParam("control_table/enabled", use_control_table);
+    if (!use_control_table) return true;
+
+    double tolerance = 0.01;
+    nl.getParam("control_table/tolerance", tolerance);
+
+    const double valid_fraction = BuildControlTable(tolerance);
+    if (valid_fraction < 0.0) return false;
+
+    ROS_INFO("%s: Control table is valid in %f%% of cells.",
+             this->name_.c_str(), 100.0 * valid_fraction);
+    return true;
   }
 
+  // Load everything but the grid itself if 'load_grid' is false.
+  bool LoadMatFile(const std::string& file_name, bool load_grid);
+
+  // Priority corresponding to the given value.
+  double PriorityFromValue(double value) const;
+
+  // Maximum absolute difference between two controls, over all components.
+  static double ControlDistance(const TC& u1, const TC& u2);
+
+  // Convert a (relative) state to grid cell coordinates, clamping to the
+  // grid and optionally warning if the state is outside it.
+  void StateToCell(const RelativeVector& x, bool warn, GridCell* cell) const;
+
   // Convert a (relative) state to an index into 'data_'.
-  size_t StateToIndex(const VectorXd& x) const;
+  size_t StateToIndex(const RelativeVector& x) const;
+
+  // Read bounds on all channels at the given state from the tiles. Returns
+  // true if they are exact, i.e. the tile was resident.
+  bool TiledAccessor(const RelativeVector& x, CellChannels* lower,
+                     CellChannels* upper) const;
+
+  // Request tiles along the relative state's estimated velocity.
+  void Prefetch(const RelativeVector& x) const;
+
+  // Accessor for value at the given state. Optionally reports whether the
+  // value is exact, rather than a coarse upper bound.
+  double ValueAccessor(const RelativeVector& x, bool* exact = nullptr) const;
 
   // Compute the difference vector between this (relative) state and the center
   // of the nearest cell (i.e. cell center minus state).
-  VectorXd DirectionToCenter(const VectorXd& x) const;
+  RelativeVector DirectionToCenter(const RelativeVector& x) const;
 
   // Accessor for precomputed gradient at the given state.
-  VectorXd GradientAccessor(const VectorXd& x) const;
+  RelativeVector GradientAccessor(const RelativeVector& x) const;
 
   // Compute the grid point below a given state in dimension idx.
-  double LowerGridPoint(const VectorXd& x, size_t idx) const;
+  double LowerGridPoint(const RelativeVector& x, size_t idx) const;
 
   // Compute center of nearest grid cell to the given state.
-  VectorXd NearestCenterPoint(const VectorXd& x) const;
+  RelativeVector NearestCenterPoint(const RelativeVector& x) const;
 
   // Recursive helper function for gradient multilinear interpolation.
   // Takes in a state and index along which to interpolate.
-  VectorXd RecursiveGradientInterpolator(const VectorXd& x, size_t idx) const;
+  RelativeVector RecursiveGradientInterpolator(const RelativeVector& x,
+                                               size_t idx) const;
 
   // Lower and upper bounds for the value function. Used for computing the
   // 'priority' of the optimal control signal.
@@ -136,6 +257,21 @@ class MatlabValueFunction : public ValueFunction<TS, TC, TD, PS, PC, PD, B> {
   // Gradient information at each cell. One list per dimension, each in the
   // same order as 'data_'.
   std::vector<std::vector<double>> gradient_;
+
+  // Precomputed optimal control and priority at each cell, in the same order
+  // as 'data_'. Empty unless BuildControlTable has been called.
+  std::vector<ControlTableEntry> control_table_;
+
+  // Tiled grid, replacing 'data_' and 'gradient_' if set.
+  std::unique_ptr<TiledGrid> tiles_;
+
+  // Prefetch horizon in queries, and the last distinct queried state for
+  // estimating its velocity. Prefetching is skipped while another thread
+  // holds the mutex.
+  int prefetch_steps_;
+  mutable std::mutex prefetch_mutex_;
+  mutable RelativeVector last_relative_x_;
+  mutable bool has_last_relative_x_;
 };  //\class MatlabValueFunction
 
 // ---------------------------- IMPLEMENTATION  ---------------------------- //
@@ -145,16 +281,21 @@ template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
 double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Value(
     const TS& tracker_x, const PS& planner_x) const {
-  const VectorXd relative_x = RS(tracker_x, planner_x).ToVector();
+  const RelativeVector relative_x = RS(tracker_x, planner_x).ToFixedVector();
+  Prefetch(relative_x);
 
   // Get distance from cell center in each dimension.
-  const VectorXd center_distance = DirectionToCenter(relative_x);
+  const RelativeVector center_distance = DirectionToCenter(relative_x);
+
+  // Interpolate. A coarse value is already a bound over its whole block, so
+  // it is used as is.
+  bool exact;
+  const double nn_value = ValueAccessor(relative_x, &exact);
+  if (!exact) return nn_value;
 
-  // Interpolate.
-  const double nn_value = data_[StateToIndex(relative_x)];
   double approx_value = nn_value;
 
-  VectorXd neighbor = relative_x;
+  RelativeVector neighbor = relative_x;
   for (size_t ii = 0; ii < relative_x.size(); ii++) {
     // Get neighboring value.
     if (center_distance(ii) >= 0.0)
@@ -162,9 +303,12 @@ double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Value(
     else
       neighbor(ii) -= cell_size_[ii];
 
-    const double neighbor_value = data_[StateToIndex(neighbor)];
+    const double neighbor_value = ValueAccessor(neighbor, &exact);
     neighbor(ii) = relative_x(ii);
 
+    // Skip differences across levels.
+    if (!exact) continue;
+
     // Compute forward difference.
     const double slope = (center_distance(ii) >= 0.0)
                              ? (neighbor_value - nn_value) / cell_size_[ii]
@@ -183,15 +327,44 @@ template <typename TS, typename TC, typename TD, typename PS, typename PC,
 std::unique_ptr<RelativeState<TS, PS>>
 MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Gradient(
     const TS& tracker_x, const PS& planner_x) const {
-  const VectorXd relative_x = RS(tracker_x, planner_x).ToVector();
+  return std::unique_ptr<RS>(new RS(RelativeGradient(tracker_x, planner_x)));
+}
 
-  // std::cout << "tracker_x: " << tracker_x.ToVector().transpose() << std::endl;
-  // std::cout << "planner_x: " << planner_x.ToVector().transpose() << std::endl;
-  // std::cout << "relative_x: " << relative_x.transpose() << std::endl;
-  // std::cout << "gradient: " << RecursiveGradientInterpolator(relative_x, 0).transpose() << std::endl;
+// Statically typed gradient, returned by value.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+RS MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::RelativeGradient(
+    const TS& tracker_x, const PS& planner_x) const {
+  const RelativeVector relative_x = RS(tracker_x, planner_x).ToFixedVector();
+  return RS(RecursiveGradientInterpolator(relative_x, 0));
+}
 
-  return std::unique_ptr<RS>(
-      new RS(RecursiveGradientInterpolator(relative_x, 0)));
+// Get the optimal control given the tracker state and planner state.
+// The relative dynamics were constructed as an RD in InitializeFromMatFile.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+TC MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::OptimalControl(
+    const TS& tracker_x, const PS& planner_x) const {
+  if (!this->initialized_)
+    throw std::runtime_error("Uninitialized call to OptimalControl.");
+
+  const auto& relative_dynamics =
+      static_cast<const RD&>(*this->relative_dynamics_);
+  const RelativeVector relative_x = RS(tracker_x, planner_x).ToFixedVector();
+  Prefetch(relative_x);
+
+  // Single lookup if the control table is valid here.
+  if (!control_table_.empty()) {
+    const ControlTableEntry& entry = control_table_[StateToIndex(relative_x)];
+    if (entry.valid)
+      return relative_dynamics.CompleteOptimalControl(tracker_x, planner_x,
+                                                      entry.control);
+  }
+
+  return relative_dynamics.OptimalControl(
+      tracker_x, planner_x, RS(RecursiveGradientInterpolator(relative_x, 0)),
+      this->tracker_dynamics_.GetControlBound(),
+      this->planner_dynamics_.GetControlBound());
 }
 
 // Priority of the optimal control at the given tracker and planner states.
@@ -202,8 +375,21 @@ template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
 double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Priority(
     const TS& tracker_x, const PS& planner_x) const {
-  const double value = Value(tracker_x, planner_x);
+  // Single lookup if the control table is valid here.
+  if (!control_table_.empty()) {
+    const RelativeVector relative_x = RS(tracker_x, planner_x).ToFixedVector();
+    const ControlTableEntry& entry = control_table_[StateToIndex(relative_x)];
+    if (entry.valid) return entry.priority;
+  }
+
+  return PriorityFromValue(Value(tracker_x, planner_x));
+}
 
+// Priority corresponding to the given value.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
+                           B>::PriorityFromValue(double value) const {
   if (value < priority_lower_) return 0.0;
 
   // HACK! If value is too high, just use LQR instead.
@@ -211,50 +397,221 @@ double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Priority(
   return (value - priority_lower_) / (priority_upper_ - priority_lower_);
 }
 
-// Convert a (relative) state to an index into 'data_'.
+// Precompute the optimal control and priority at every grid cell.
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
-size_t MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::StateToIndex(
-    const VectorXd& x) const {
+double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
+                           B>::BuildControlTable(double tolerance) {
+  if (tiles_) {
+    ROS_ERROR("%s: Control table is not available with a tiled grid.",
+              this->name_.c_str());
+    return -1.0;
+  }
+
+  if (!this->relative_dynamics_ || data_.empty()) {
+    ROS_ERROR("%s: Cannot build control table before loading the grid.",
+              this->name_.c_str());
+    return -1.0;
+  }
+
+  if (tolerance < 0.0) {
+    ROS_ERROR("%s: Control table tolerance must be nonnegative.",
+              this->name_.c_str());
+    return -1.0;
+  }
+
+  const auto& relative_dynamics =
+      static_cast<const RD&>(*this->relative_dynamics_);
+  const auto& tracker_u_bound = this->tracker_dynamics_.GetControlBound();
+
+  // Evaluate at every cell from the precomputed gradient and value.
+  control_table_.clear();
+  control_table_.reserve(data_.size());
+  for (size_t idx = 0; idx < data_.size(); idx++) {
+    RelativeVector gradient;
+    for (size_t ii = 0; ii < gradient.size(); ii++)
+      gradient(ii) = gradient_[ii][idx];
+
+    control_table_.push_back(
+        {relative_dynamics.RelativeOptimalControl(RS(gradient),
+                                                  tracker_u_bound),
+         PriorityFromValue(data_[idx]), true});
+  }
+
+  // Invalidate cells on the grid boundary, and both cells of every pair of
+  // neighbors which disagree. Neighbors in dimension ii are 'stride' apart in
+  // row-major order.
+  size_t stride = data_.size();
+  for (size_t ii = 0; ii < num_cells_.size(); ii++) {
+    stride /= num_cells_[ii];
+
+    for (size_t idx = 0; idx < control_table_.size(); idx++) {
+      auto& entry = control_table_[idx];
+      const size_t coordinate = (idx / stride) % num_cells_[ii];
+      if (coordinate == 0 || coordinate == num_cells_[ii] - 1)
+        entry.valid = false;
+
+      if (coordinate + 1 == num_cells_[ii]) continue;
+
+      auto& neighbor = control_table_[idx + stride];
+      if (ControlDistance(entry.control, neighbor.control) > tolerance ||
+          std::abs(entry.priority - neighbor.priority) > tolerance) {
+        entry.valid = false;
+        neighbor.valid = false;
+      }
+    }
+  }
+
+  const size_t num_valid = std::count_if(
+      control_table_.begin(), control_table_.end(),
+      [](const ControlTableEntry& entry) { return entry.valid; });
+  return static_cast<double>(num_valid) /
+         static_cast<double>(control_table_.size());
+}
+
+// Maximum absolute difference between two controls, over all components.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
+                           B>::ControlDistance(const TC& u1, const TC& u2) {
+  const auto msg1 = u1.ToRos();
+  const auto msg2 = u2.ToRos();
+
+  double distance = 0.0;
+  for (size_t ii = 0; ii < msg1.u.size(); ii++)
+    distance = std::max(distance, std::abs(msg1.u[ii] - msg2.u[ii]));
+
+  return distance;
+}
+
+// Convert a (relative) state to grid cell coordinates, clamping to the
+// grid and optionally warning if the state is outside it.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+void MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::StateToCell(
+    const RelativeVector& x, bool warn, GridCell* cell) const {
   // Quantize each dimension of the state.
-  std::vector<size_t> quantized;
   for (size_t ii = 0; ii < x.size(); ii++) {
+    size_t quantized;
     if (x(ii) < lower_[ii]) {
-      ROS_WARN_THROTTLE(1.0,
-                        "%s: State is too small in dimension %zu: %f vs %f",
-                        this->name_.c_str(), ii, x(ii), lower_[ii]);
-      quantized.push_back(0);
+      if (warn) {
+        ROS_WARN_THROTTLE(1.0,
+                          "%s: State is too small in dimension %zu: %f vs %f",
+                          this->name_.c_str(), ii, x(ii), lower_[ii]);
+      }
+
+      quantized = 0;
     } else if (x(ii) > upper_[ii]) {
-      ROS_WARN_THROTTLE(1.0,
-                        "%s: State is too large in dimension %zu: %f vs %f",
-                        this->name_.c_str(), ii, x(ii), upper_[ii]);
-      quantized.push_back(num_cells_[ii] - 1);
+      if (warn) {
+        ROS_WARN_THROTTLE(1.0,
+                          "%s: State is too large in dimension %zu: %f vs %f",
+                          this->name_.c_str(), ii, x(ii), upper_[ii]);
+      }
+
+      quantized = num_cells_[ii] - 1;
     } else {
       // In bounds, so quantize. This works because of 0-indexing and casting.
-      quantized.push_back(
-          static_cast<size_t>((x(ii) - lower_[ii]) / cell_size_[ii]));
+      // Clamp anyway, since x may equal the upper bound.
+      quantized = std::min(
+          static_cast<size_t>((x(ii) - lower_[ii]) / cell_size_[ii]),
+          num_cells_[ii] - 1);
     }
-  }
 
-  // Convert to row-major order.
-  size_t idx = quantized[0];
-  for (size_t ii = 1; ii < quantized.size(); ii++) {
-    idx *= num_cells_[ii];
-    idx += quantized[ii];
+    (*cell)[ii] = quantized;
   }
+}
+
+// Convert a (relative) state to an index into 'data_'.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+size_t MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::StateToIndex(
+    const RelativeVector& x) const {
+  GridCell cell;
+  StateToCell(x, true, &cell);
+
+  // Accumulate in row-major order.
+  size_t idx = 0;
+  for (size_t ii = 0; ii < cell.size(); ii++)
+    idx = idx * num_cells_[ii] + cell[ii];
 
   return idx;
 }
 
+// Read bounds on all channels at the given state from the tiles. Returns
+// true if they are exact, i.e. the tile was resident.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::TiledAccessor(
+    const RelativeVector& x, CellChannels* lower, CellChannels* upper) const {
+  GridCell cell;
+  StateToCell(x, true, &cell);
+
+  return tiles_->Lookup(cell.data(), lower->data(), upper->data());
+}
+
+// Request tiles along the relative state's estimated velocity, i.e. its
+// change since the last distinct query, for the next 'prefetch_steps_'
+// queries. Value and OptimalControl usually query the same state back to
+// back, and the repeat must not count as standing still.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+void MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::Prefetch(
+    const RelativeVector& x) const {
+  if (!tiles_ || prefetch_steps_ <= 0) return;
+
+  std::unique_lock<std::mutex> lock(prefetch_mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) return;
+
+  if (has_last_relative_x_) {
+    if (x == last_relative_x_) return;
+    const RelativeVector step = x - last_relative_x_;
+
+    // Far to near, since the loader serves the newest request first.
+    GridCell cell;
+    for (int kk = prefetch_steps_; kk >= 1; kk--) {
+      StateToCell(x + static_cast<double>(kk) * step, false, &cell);
+      tiles_->Prefetch(cell.data());
+    }
+  }
+
+  last_relative_x_ = x;
+  has_last_relative_x_ = true;
+}
+
+// Accessor for value at the given state.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::ValueAccessor(
+    const RelativeVector& x, bool* exact) const {
+  if (tiles_) {
+    CellChannels lower, upper;
+    const bool resident = TiledAccessor(x, &lower, &upper);
+    if (exact) *exact = resident;
+    return upper[0];
+  }
+
+  if (exact) *exact = true;
+  return data_[StateToIndex(x)];
+}
+
 // Accessor for precomputed gradient at the given state.
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
-VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
-                             B>::GradientAccessor(const VectorXd& x) const {
+typename RS::FixedVector
+MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::GradientAccessor(
+    const RelativeVector& x) const {
+  RelativeVector gradient;
+  if (tiles_) {
+    CellChannels lower, upper;
+    TiledAccessor(x, &lower, &upper);
+    for (size_t ii = 0; ii < gradient.size(); ii++)
+      gradient(ii) = 0.5 * (lower[ii + 1] + upper[ii + 1]);
+
+    return gradient;
+  }
+
   // Convert to index and read gradient one dimension at a time.
   const size_t idx = StateToIndex(x);
-
-  VectorXd gradient(x.size());
   for (size_t ii = 0; ii < gradient.size(); ii++)
     gradient(ii) = gradient_[ii][idx];
 
@@ -265,8 +622,9 @@ VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
 // of the nearest cell (i.e. cell center minus state).
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
-VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
-                             B>::DirectionToCenter(const VectorXd& x) const {
+typename RS::FixedVector
+MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::DirectionToCenter(
+    const RelativeVector& x) const {
   return NearestCenterPoint(x) - x;
 }
 
@@ -274,7 +632,7 @@ VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
 double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::LowerGridPoint(
-    const VectorXd& x, size_t idx) const {
+    const RelativeVector& x, size_t idx) const {
   // Get center of nearest cell.
   const double center =
       0.5 * cell_size_[idx] + lower_[idx] +
@@ -287,9 +645,10 @@ double MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::LowerGridPoint(
 // Compute the center of the cell nearest to the given state.
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
-VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
-                             B>::NearestCenterPoint(const VectorXd& x) const {
-  VectorXd center(x.size());
+typename RS::FixedVector
+MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::NearestCenterPoint(
+    const RelativeVector& x) const {
+  RelativeVector center;
 
   for (size_t ii = 0; ii < center.size(); ii++)
     center[ii] =
@@ -303,9 +662,9 @@ VectorXd MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
 // Takes in a state and index along which to interpolate.
 template <typename TS, typename TC, typename TD, typename PS, typename PC,
           typename PD, typename RS, typename RD, typename B>
-VectorXd
+typename RS::FixedVector
 MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
-                    B>::RecursiveGradientInterpolator(const VectorXd& x,
+                    B>::RecursiveGradientInterpolator(const RelativeVector& x,
                                                       size_t idx) const {
   // Assume x's entries prior to idx are equal to the upper/lower bounds of
   // the cell containing x.
@@ -318,10 +677,10 @@ MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
   const double fractional_dist = (x(idx) - lower) / cell_size_[idx];
 
   // Split x along dimension idx.
-  VectorXd x_lower = x;
+  RelativeVector x_lower = x;
   x_lower(idx) = lower;
 
-  VectorXd x_upper = x;
+  RelativeVector x_upper = x;
   x_upper(idx) = upper;
 
   // Base case.
@@ -343,6 +702,43 @@ template <typename TS, typename TC, typename TD, typename PS, typename PC,
 bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
                          B>::InitializeFromMatFile(const std::string&
                                                        file_name) {
+  return LoadMatFile(file_name, true);
+}
+
+// Initialize from a mat file with only metadata, and a tiled file with the
+// value and gradient, keeping at most 'cache_size' tiles in memory.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
+                         B>::InitializeFromTiles(const std::string&
+                                                     mat_file_name,
+                                                 const std::string&
+                                                     tile_file_name,
+                                                 size_t cache_size) {
+  if (!LoadMatFile(mat_file_name, false)) return false;
+
+  tiles_.reset(new TiledGrid);
+  if (!tiles_->Open(tile_file_name, cache_size)) {
+    tiles_.reset();
+    return false;
+  }
+
+  if (tiles_->NumCells() != num_cells_ ||
+      tiles_->NumChannels() != num_cells_.size() + 1) {
+    ROS_ERROR("%s: Tiled grid does not match %s.", this->name_.c_str(),
+              mat_file_name.c_str());
+    tiles_.reset();
+    return false;
+  }
+
+  return true;
+}
+
+// Load everything but the grid itself if 'load_grid' is false.
+template <typename TS, typename TC, typename TD, typename PS, typename PC,
+          typename PD, typename RS, typename RD, typename B>
+bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD, B>::LoadMatFile(
+    const std::string& file_name, bool load_grid) {
   // Open up this file.
   MatlabFileReader reader(file_name);
   if (!reader.IsOpen()) return false;
@@ -353,7 +749,7 @@ bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
   if (!reader.ReadVector("num_cells", &num_cells_)) return false;
   if (!reader.ReadVector("lower", &lower_)) return false;
   if (!reader.ReadVector("upper", &upper_)) return false;
-  if (!reader.ReadVector("data", &data_)) return false;
+  if (load_grid && !reader.ReadVector("data", &data_)) return false;
 
   // Check loaded variables.
   if (priority_lower_ >= priority_upper_) {
@@ -367,6 +763,13 @@ bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
     return false;
   }
 
+  if (num_cells_.size() != RS::StateDimension()) {
+    ROS_ERROR("%s: Grid dimension %zu does not match relative state "
+              "dimension %zu.",
+              this->name_.c_str(), num_cells_.size(), RS::StateDimension());
+    return false;
+  }
+
   const double total_num_cells = std::accumulate(
       num_cells_.begin(), num_cells_.end(), 1, std::multiplies<size_t>());
   if (total_num_cells == 0) {
@@ -374,7 +777,7 @@ bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
     return false;
   }
 
-  if (data_.size() != total_num_cells) {
+  if (load_grid && data_.size() != total_num_cells) {
     ROS_ERROR("%s: Grid data was of the wrong size.", this->name_.c_str());
     return false;
   }
@@ -385,7 +788,7 @@ bool MatlabValueFunction<TS, TC, TD, PS, PC, PD, RS, RD,
                             static_cast<double>(num_cells_[ii]));
 
   // Load gradients.
-  for (size_t ii = 0; ii < num_cells_.size(); ii++) {
+  for (size_t ii = 0; load_grid && ii < num_cells_.size(); ii++) {
     gradient_.emplace_back();
     auto& partial = gradient_.back();
     if (!reader.ReadVector("deriv_" + std::to_string(ii), &partial)) {
@@ -90,6 +90,9 @@ class ValueFunction : private Uncopyable {
       const TS& tracker_x, const PS& planner_x) const = 0;
 
   // Get the optimal control given the tracker state and planner state.
+  // This goes through the virtual Gradient and RelativeDynamics interface.
+  // Derived classes which know their concrete relative state and dynamics
+  // types hide it with a statically typed version that does not allocate.
   inline TC OptimalControl(const TS& tracker_x, const PS& planner_x) const {
     if (!initialized_)
       throw std::runtime_error("Uninitialized call to OptimalControl.");
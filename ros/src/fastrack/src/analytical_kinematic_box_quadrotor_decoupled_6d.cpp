@@ -56,7 +56,7 @@ bool AnalyticalKinematicBoxQuadrotorDecoupled6D::LoadParameters(
     const ros::NodeHandle& n) {
   ros::NodeHandle nl(n);
 
-  // Set dynamics parameters.
+  // Tracker control bounds.
   QuadrotorControl qc_lower, qc_upper;
   qc_lower.yaw_rate = 0.0;
   qc_upper.yaw_rate = 0.0;
@@ -68,13 +68,42 @@ bool AnalyticalKinematicBoxQuadrotorDecoupled6D::LoadParameters(
   qc_lower.pitch = -qc_upper.pitch;
   qc_lower.roll = -qc_upper.roll;
 
-  tracker_dynamics_.Initialize(QuadrotorControlBoundBox(qc_lower, qc_upper));
-
-  VectorXd max_planner_speed(3);
+  // Maximum planner speed.
+  Vector3d max_planner_speed;
   if (!nl.getParam("planner/vx", max_planner_speed(0))) return false;
   if (!nl.getParam("planner/vy", max_planner_speed(1))) return false;
   if (!nl.getParam("planner/vz", max_planner_speed(2))) return false;
 
+  // Velocity/acceleration disturbance bounds.
+  Vector3d vel_dist, acc_dist;
+  if (!nl.getParam("disturbance/velocity/x", vel_dist(0))) return false;
+  if (!nl.getParam("disturbance/velocity/y", vel_dist(1))) return false;
+  if (!nl.getParam("disturbance/velocity/z", vel_dist(2))) return false;
+  if (!nl.getParam("disturbance/acceleration/x", acc_dist(0))) return false;
+  if (!nl.getParam("disturbance/acceleration/y", acc_dist(1))) return false;
+  if (!nl.getParam("disturbance/acceleration/z", acc_dist(2))) return false;
+
+  // Velocity expansion.
+  Vector3d vel_exp;
+  if (!nl.getParam("expansion/velocity/x", vel_exp(0))) return false;
+  if (!nl.getParam("expansion/velocity/y", vel_exp(1))) return false;
+  if (!nl.getParam("expansion/velocity/z", vel_exp(2))) return false;
+
+  return InitializeFromParameters(qc_lower, qc_upper, max_planner_speed,
+                                  vel_dist, acc_dist, vel_exp);
+}
+
+// Initialize from tracker control bounds, maximum planner speed, and
+// disturbance/expansion parameters.
+bool AnalyticalKinematicBoxQuadrotorDecoupled6D::InitializeFromParameters(
+    const QuadrotorControl& tracker_lower,
+    const QuadrotorControl& tracker_upper, const Vector3d& max_planner_speed,
+    const Vector3d& velocity_disturbance,
+    const Vector3d& acceleration_disturbance,
+    const Vector3d& velocity_expansion) {
+  // Set dynamics parameters.
+  tracker_dynamics_.Initialize(
+      QuadrotorControlBoundBox(tracker_lower, tracker_upper));
   planner_dynamics_.Initialize(
       VectorBoundBox(-max_planner_speed, max_planner_speed));
 
@@ -83,7 +112,7 @@ bool AnalyticalKinematicBoxQuadrotorDecoupled6D::LoadParameters(
 
   // Compute maximum acceleration. Make sure all elements are positive.
   const auto x_dot_max = tracker_dynamics_.Evaluate(
-      PositionVelocity(Vector3d::Zero(), Vector3d::Zero()), qc_upper);
+      PositionVelocity(Vector3d::Zero(), Vector3d::Zero()), tracker_upper);
 
   max_acc_ = x_dot_max.Velocity();
   max_acc_(0) = std::abs(max_acc_(0));
@@ -91,17 +120,11 @@ bool AnalyticalKinematicBoxQuadrotorDecoupled6D::LoadParameters(
   max_acc_(2) = std::abs(max_acc_(2));
 
   // Velocity/acceleration disturbance bounds.
-  if (!nl.getParam("disturbance/velocity/x", vel_dist_(0))) return false;
-  if (!nl.getParam("disturbance/velocity/y", vel_dist_(1))) return false;
-  if (!nl.getParam("disturbance/velocity/z", vel_dist_(2))) return false;
-  if (!nl.getParam("disturbance/acceleration/x", acc_dist_(0))) return false;
-  if (!nl.getParam("disturbance/acceleration/y", acc_dist_(1))) return false;
-  if (!nl.getParam("disturbance/acceleration/z", acc_dist_(2))) return false;
+  vel_dist_ = velocity_disturbance;
+  acc_dist_ = acceleration_disturbance;
 
   // Position/velocity expansion.
-  if (!nl.getParam("expansion/velocity/x", vel_exp_(0))) return false;
-  if (!nl.getParam("expansion/velocity/y", vel_exp_(1))) return false;
-  if (!nl.getParam("expansion/velocity/z", vel_exp_(2))) return false;
+  vel_exp_ = velocity_expansion;
   pos_exp_ = vel_exp_.cwiseProduct(2.0 * max_planner_speed + 0.5 * vel_exp_)
                  .cwiseQuotient(max_acc_ - acc_dist_);
 
@@ -116,6 +139,7 @@ bool AnalyticalKinematicBoxQuadrotorDecoupled6D::LoadParameters(
                                (max_planner_speed(2) + vel_dist_(2)) /
                                (max_acc_(2) - acc_dist_(2));
 
+  initialized_ = true;
   return true;
 }
 
@@ -168,6 +192,16 @@ std::unique_ptr<RelativeState<PositionVelocity, PositionVelocity>>
 AnalyticalKinematicBoxQuadrotorDecoupled6D::Gradient(
     const PositionVelocity& tracker_x,
     const PositionVelocity& planner_x) const {
+  return std::unique_ptr<RelativeState<PositionVelocity, PositionVelocity>>(
+      new PositionVelocityRelPositionVelocity(
+          RelativeGradient(tracker_x, planner_x)));
+}
+
+// Statically typed gradient, returned by value.
+PositionVelocityRelPositionVelocity
+AnalyticalKinematicBoxQuadrotorDecoupled6D::RelativeGradient(
+    const PositionVelocity& tracker_x,
+    const PositionVelocity& planner_x) const {
   // Get relative state.
   const PositionVelocityRelPositionVelocity relative_x(tracker_x, planner_x);
   const Vector3d& rx_position = relative_x.State().Position();
@@ -206,8 +240,23 @@ AnalyticalKinematicBoxQuadrotorDecoupled6D::Gradient(
     }
   }
 
-  return std::unique_ptr<RelativeState<PositionVelocity, PositionVelocity>>(
-      new PositionVelocityRelPositionVelocity(pos_grad, vel_grad));
+  return PositionVelocityRelPositionVelocity(pos_grad, vel_grad);
+}
+
+// Get the optimal control given the vehicle state and planner state.
+QuadrotorControl AnalyticalKinematicBoxQuadrotorDecoupled6D::OptimalControl(
+    const PositionVelocity& tracker_x,
+    const PositionVelocity& planner_x) const {
+  if (!initialized_)
+    throw std::runtime_error("Uninitialized call to OptimalControl.");
+
+  // Relative dynamics were set in InitializeFromParameters.
+  const auto& relative_dynamics = static_cast<
+      const QuadrotorDecoupled6DRelKinematics<QuadrotorControlBoundBox>&>(
+      *relative_dynamics_);
+  return relative_dynamics.OptimalControl(
+      tracker_x, planner_x, RelativeGradient(tracker_x, planner_x),
+      tracker_dynamics_.GetControlBound(), planner_dynamics_.GetControlBound());
 }
 
 // Priority of the optimal control at the given vehicle and planner states.
@@ -42,6 +42,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <fastrack/environment/balls_in_box.h>
+#include <fastrack/sensor/ray_casting.h>
 
 namespace fastrack {
 namespace environment {
@@ -49,36 +50,30 @@ namespace environment {
 // Derived classes must provide a collision checker which returns true if
 // and only if the provided position is a valid collision-free configuration.
 // Ignores 'time' since this is a time-invariant environment.
+// Known bound types are dispatched to their specialized kernels.
 bool BallsInBox::IsValid(const Vector3d& position, const TrackingBound& bound,
                          double time) const {
-  if (!initialized_) {
-    ROS_WARN("%s: Tried to collision check an uninitialized BallsInBox.",
-             name_.c_str());
-    return false;
-  }
-
-  // Check that this position is within the outer environment boundaries.
-  if (!bound.ContainedWithinBox(position, lower_, upper_)) return false;
-
-  // Check against each obstacle.
   // NOTE! Just using a linear search here for simplicity.
-  if (centers_.size() > 100) {
+  if (obstacles_.Size() > 100) {
     ROS_WARN_THROTTLE(1.0,
                       "%s: Caution! Linear search may be slowing you down.",
                       name_.c_str());
   }
 
-  for (size_t ii = 0; ii < centers_.size(); ii++) {
-    if (bound.OverlapsSphere(position, centers_[ii], radii_[ii])) return false;
-  }
+  if (const auto* box = dynamic_cast<const bound::Box*>(&bound))
+    return IsValid<bound::Box>(position, *box, time);
+  if (const auto* cylinder = dynamic_cast<const bound::Cylinder*>(&bound))
+    return IsValid<bound::Cylinder>(position, *cylinder, time);
+  if (const auto* sphere = dynamic_cast<const bound::Sphere*>(&bound))
+    return IsValid<bound::Sphere>(position, *sphere, time);
 
-  return true;
+  return IsValid<TrackingBound>(position, bound, time);
 }
 
 // Update this environment with the information contained in the given
-// sensor measurement.
-// NOTE! This function needs to publish on `updated_topic_`.
-void BallsInBox::SensorCallback(
+// sensor measurement. Returns whether the model changed.
+// NOTE! This function needs to publish on `updated_topic_` if so.
+bool BallsInBox::SensorCallback(
     const fastrack_msgs::SensedSpheres::ConstPtr& msg) {
   // Check list lengths.
   if (msg->centers.size() != msg->radii.size())
@@ -88,7 +83,7 @@ void BallsInBox::SensorCallback(
 
   // Add each unique obstacle to list.
   // NOTE! Just using a linear search here for simplicity.
-  if (centers_.size() > 100)
+  if (obstacles_.Size() > 100)
     ROS_WARN_THROTTLE(1.0,
                       "%s: Caution! Linear search may be slowing you down.",
                       name_.c_str());
@@ -101,9 +96,9 @@ void BallsInBox::SensorCallback(
 
     // If not unique, discard.
     bool unique = true;
-    for (size_t jj = 0; jj < centers_.size(); jj++) {
-      if (p.isApprox(centers_[jj], constants::kEpsilon) &&
-          std::abs(r - radii_[jj]) < constants::kEpsilon) {
+    for (size_t jj = 0; jj < obstacles_.Size(); jj++) {
+      if (p.isApprox(obstacles_.Center(jj), constants::kEpsilon) &&
+          std::abs(r - obstacles_.r[jj]) < constants::kEpsilon) {
         unique = false;
         break;
       }
@@ -111,8 +106,7 @@ void BallsInBox::SensorCallback(
 
     if (unique) {
       any_unique = true;
-      centers_.push_back(p);
-      radii_.push_back(r);
+      obstacles_.Add(p, r);
     }
   }
 
@@ -123,6 +117,8 @@ void BallsInBox::SensorCallback(
     // Visualize.
     Visualize();
   }
+
+  return any_unique;
 }
 
 // Generate a sensor measurement as a service response.
@@ -137,20 +133,45 @@ fastrack_msgs::SensedSpheres BallsInBox::SimulateSensor(
 
   // Check each obstacle and, if in range, add to response.
   geometry_msgs::Vector3 c;
-  for (size_t ii = 0; ii < centers_.size(); ii++) {
-    if ((params.position - centers_[ii]).norm() < params.range + radii_[ii]) {
-      c.x = centers_[ii](0);
-      c.y = centers_[ii](1);
-      c.z = centers_[ii](2);
+  for (size_t ii = 0; ii < obstacles_.Size(); ii++) {
+    const Vector3d center = obstacles_.Center(ii);
+    if ((params.position - center).norm() < params.range + obstacles_.r[ii]) {
+      c.x = center(0);
+      c.y = center(1);
+      c.z = center(2);
 
       msg.centers.push_back(c);
-      msg.radii.push_back(radii_[ii]);
+      msg.radii.push_back(obstacles_.r[ii]);
     }
   }
 
   return msg;
 }
 
+// Generate a ray-cast depth scan. Rays are cast in parallel.
+fastrack_msgs::SensedRays BallsInBox::SimulateSensor(
+    const RaySensorParams& params) const {
+  std::lock_guard<std::mutex> lock(ray_mutex_);
+
+  // Rebuild the hierarchy if the obstacles have changed.
+  if (bvh_version_ != Version() || bvh_.NumSpheres() != obstacles_.Size()) {
+    bvh_.Build(obstacles_);
+    bvh_version_ = Version();
+  }
+
+  if (!ray_pool_) ray_pool_.reset(new ThreadPool(params.num_threads));
+
+  // Cast.
+  fastrack_msgs::SensedRays msg;
+  const ros::Time start = ros::Time::now();
+  const size_t num_hits = sensor::CastRays(bvh_, params, ray_pool_.get(), &msg);
+  ROS_INFO_THROTTLE(10.0, "%s: Cast %zu rays (%zu hits) in %f ms.",
+                    name_.c_str(), msg.hits.size(), num_hits,
+                    1e3 * (ros::Time::now() - start).toSec());
+
+  return msg;
+}
+
 // Derived classes must have some sort of visualization through RViz.
 void BallsInBox::Visualize() const {
   if (vis_pub_.getNumSubscribers() <= 0) return;
@@ -190,7 +211,7 @@ void BallsInBox::Visualize() const {
   vis_pub_.publish(cube);
 
   // Visualize obstacles as spheres.
-  for (size_t ii = 0; ii < centers_.size(); ii++) {
+  for (size_t ii = 0; ii < obstacles_.Size(); ii++) {
     visualization_msgs::Marker sphere;
     sphere.ns = "sphere";
     sphere.header.frame_id = fixed_frame_;
@@ -199,9 +220,9 @@ void BallsInBox::Visualize() const {
     sphere.type = visualization_msgs::Marker::SPHERE;
     sphere.action = visualization_msgs::Marker::ADD;
 
-    sphere.scale.x = 2.0 * radii_[ii];
-    sphere.scale.y = 2.0 * radii_[ii];
-    sphere.scale.z = 2.0 * radii_[ii];
+    sphere.scale.x = 2.0 * obstacles_.r[ii];
+    sphere.scale.y = 2.0 * obstacles_.r[ii];
+    sphere.scale.z = 2.0 * obstacles_.r[ii];
 
     sphere.color.a = 0.9;
     sphere.color.r = 0.7;
@@ -209,7 +230,7 @@ void BallsInBox::Visualize() const {
     sphere.color.b = 0.5;
 
     geometry_msgs::Point p;
-    const Vector3d point = centers_[ii];
+    const Vector3d point = obstacles_.Center(ii);
     p.x = point(0);
     p.y = point(1);
     p.z = point(2);
@@ -243,9 +264,9 @@ bool BallsInBox::LoadParameters(const ros::NodeHandle& n) {
       ROS_WARN("%s: Pre-specified obstacles are malformed.", name_.c_str());
     } else {
       for (size_t ii = 0; ii < obstacle_xs.size(); ii++) {
-        centers_.emplace_back(
-            Vector3d(obstacle_xs[ii], obstacle_ys[ii], obstacle_zs[ii]));
-        radii_.push_back(obstacle_rs[ii]);
+        obstacles_.Add(
+            Vector3d(obstacle_xs[ii], obstacle_ys[ii], obstacle_zs[ii]),
+            obstacle_rs[ii]);
       }
     }
   } else {
@@ -286,8 +307,8 @@ void BallsInBox::GenerateObstacles(size_t num, double min_radius,
 
   // Create obstacles.
   for (size_t ii = 0; ii < num; ii++) {
-    centers_.push_back(Vector3d(unif_x(rng), unif_y(rng), unif_z(rng)));
-    radii_.push_back(unif_r(rng));
+    const Vector3d center(unif_x(rng), unif_y(rng), unif_z(rng));
+    obstacles_.Add(center, unif_r(rng));
   }
 }
 
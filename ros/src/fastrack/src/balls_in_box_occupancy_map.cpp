@@ -44,6 +44,23 @@
 namespace fastrack {
 namespace environment {
 
+namespace {
+// Returns true if the sphere strictly contains the whole box.
+bool SphereContainsBox(const Vector3d& center, double radius,
+                       const Vector3d& lower, const Vector3d& upper) {
+  const Vector3d farthest =
+      (lower - center).cwiseAbs().cwiseMax((upper - center).cwiseAbs());
+  return farthest.squaredNorm() < radius * radius;
+}
+
+// Returns true if the sphere touches the box.
+bool SphereOverlapsBox(const Vector3d& center, double radius,
+                       const Vector3d& lower, const Vector3d& upper) {
+  const Vector3d closest = center.cwiseMax(lower).cwiseMin(upper);
+  return (closest - center).squaredNorm() <= radius * radius;
+}
+}  //\namespace
+
 // Occupancy probability for a single point.
 double BallsInBoxOccupancyMap::OccupancyProbability(const Vector3d& p,
                                                     double time) const {
@@ -77,57 +94,35 @@ double BallsInBoxOccupancyMap::OccupancyProbability(const Vector3d& p,
   return kUnknownProbability;
 }
 
-// Occupancy probability for a box tracking error bound centered at the given
-// point. Occupancy is set to occupied if ANY of the bound is occupied. Next,
-// if ANY of the bound is unknown the result is unknown. Otherwise, free.
+// Occupancy probability for a tracking error bound centered at the given
+// point. Known bound types are dispatched to their templated versions.
 double BallsInBoxOccupancyMap::OccupancyProbability(const Vector3d& p,
                                                     const TrackingBound& bound,
                                                     double time) const {
-  if (!initialized_) {
-    ROS_WARN("%s: Tried to collision check without initializing.",
-             name_.c_str());
-    return kOccupiedProbability;
-  }
-
-  // Check box limits.
-  if (!bound.ContainedWithinBox(p, lower_, upper_)) return kOccupiedProbability;
-
-  // Helper function to check if any sphere in the given KdtreeMap overlaps
-  // the given Box.
-  auto overlaps = [&p, &bound](const KdtreeMap<3, double>& kdtree) {
-    // Get k-nearest neighbors as a heuristic.
-    // NOTE: using KnnSearch instead of RadiusSearch because it seems to
-    // be more precise. When the Kdtree is huge it may make more sense to
-    // radius search, or it may not matter.
-    constexpr size_t kNumNearestNeighbors = 10;
-    const auto neighbors = kdtree.KnnSearch(p, kNumNearestNeighbors);
-
-    // Check for overlaps.
-    for (const auto& entry : neighbors) {
-      const Vector3d& center = entry.first;
-      const double& radius = entry.second;
-      if (bound.OverlapsSphere(p, center, radius)) return true;
-    }
-
-    return false;
-  };  //\overlaps
-
-  // Check if this point is inside any obstacles.
-  if (overlaps(obstacles_)) return kOccupiedProbability;
-
-  // Check if this point contains any unknown space.
-  if (!overlaps(sensor_fovs_)) return kUnknownProbability;
-
-  return kFreeProbability;
+  if (const auto* box = dynamic_cast<const bound::Box*>(&bound))
+    return OccupancyProbability<bound::Box>(p, *box, time);
+  if (const auto* cylinder = dynamic_cast<const bound::Cylinder*>(&bound))
+    return OccupancyProbability<bound::Cylinder>(p, *cylinder, time);
+  if (const auto* sphere = dynamic_cast<const bound::Sphere*>(&bound))
+    return OccupancyProbability<bound::Sphere>(p, *sphere, time);
+
+  return OccupancyProbability<TrackingBound>(p, bound, time);
 }
 
 // Update this environment with the information contained in the given
-// sensor measurement.
-// NOTE! This function needs to publish on `updated_topic_`.
-void BallsInBoxOccupancyMap::SensorCallback(
+// sensor measurement. Returns whether the model changed.
+// NOTE! This function needs to publish on `updated_topic_` if so.
+bool BallsInBoxOccupancyMap::SensorCallback(
     const fastrack_msgs::SensedSpheres::ConstPtr& msg) {
   bool updated_env = false;
 
+  // Pick up any grid a snapshot had to build, so that it is relabeled below
+  // and shared by the next snapshot.
+  AdoptCoarseGrid();
+
+  // Keep track of new spheres, so we can update the coarse grid.
+  std::vector<std::pair<Vector3d, double>> new_spheres;
+
   // Add sensor FOV to kdtree.
   const Vector3d sensor_position(msg->sensor_position.x, msg->sensor_position.y,
                                  msg->sensor_position.z);
@@ -140,6 +135,9 @@ void BallsInBoxOccupancyMap::SensorCallback(
   if (neighboring_fovs.empty() ||
       (neighboring_fovs[0].first - sensor_position).norm() > kSmallNumber) {
     sensor_fovs_.Insert(std::make_pair(sensor_position, msg->sensor_radius));
+    new_spheres.emplace_back(sensor_position, msg->sensor_radius);
+    largest_sensor_radius_ =
+        std::max(largest_sensor_radius_, msg->sensor_radius);
     updated_env = true;
   }
 
@@ -169,16 +167,22 @@ void BallsInBoxOccupancyMap::SensorCallback(
     if (unique) {
       updated_env = true;
       obstacles_.Insert({p, r});
+      new_spheres.emplace_back(p, r);
+      largest_obstacle_radius_ = std::max(largest_obstacle_radius_, r);
     }
   }
 
   if (updated_env) {
+    // Relabel affected coarse grid cells before anyone replans.
+    UpdateCoarseGrid(new_spheres);
+
     // Let the system know this environment has been updated.
     updated_pub_.publish(std_msgs::Empty());
   }
 
   // Visualize.
   Visualize();
+  return updated_env;
 }
 
 // Generate a sensor measurement as a service response.
@@ -211,9 +215,153 @@ fastrack_msgs::SensedSpheres BallsInBoxOccupancyMap::SimulateSensor(
 bool BallsInBoxOccupancyMap::LoadParameters(const ros::NodeHandle& n) {
   if (!OccupancyMap::LoadParameters(n)) return false;
 
+  ros::NodeHandle nl(n);
+
+  // Optional coarse grid resolution.
+  nl.getParam("env/coarse_resolution", coarse_resolution_);
+
   return true;
 }
 
+// Get a coarse grid which is valid for bounds with the given half extents,
+// building a new one if necessary. A grid built for a larger bound is still
+// valid (just more conservative) for a smaller one.
+std::shared_ptr<const CoarseOccupancyGrid> BallsInBoxOccupancyMap::CoarseGrid(
+    const Vector3d& inflation) const {
+  auto grid = std::atomic_load(&coarse_grid_);
+  if (grid && (inflation.array() <= grid->Inflation().array()).all())
+    return grid;
+
+  std::lock_guard<std::mutex> lock(coarse_grid_mutex_);
+
+  // Someone else may have rebuilt it while we were waiting.
+  grid = std::atomic_load(&coarse_grid_);
+  if (grid && (inflation.array() <= grid->Inflation().array()).all())
+    return grid;
+
+  // Cover both the old and the new bound, so alternating bounds do not
+  // rebuild every time.
+  grid = BuildCoarseGrid(
+      (grid) ? Vector3d(inflation.cwiseMax(grid->Inflation())) : inflation);
+  std::atomic_store(&coarse_grid_, grid);
+
+  // Hand it back to the live map.
+  std::lock_guard<std::mutex> handoff_lock(coarse_grid_handoff_->mutex);
+  coarse_grid_handoff_->grid = grid;
+  coarse_grid_handoff_->version = Version();
+  return grid;
+}
+
+// Build a coarse grid for the given half extents from scratch.
+std::shared_ptr<const CoarseOccupancyGrid>
+BallsInBoxOccupancyMap::BuildCoarseGrid(const Vector3d& inflation) const {
+  const ros::Time start = ros::Time::now();
+  auto grid = std::make_shared<CoarseOccupancyGrid>(
+      lower_, upper_, coarse_resolution_, inflation);
+  for (size_t ii = 0; ii < grid->NumCells(); ii++)
+    grid->SetLabel(ii, ClassifyCell(*grid, ii));
+
+  ROS_INFO("%s: Built coarse grid with %zu cells in %f seconds.",
+           name_.c_str(), grid->NumCells(),
+           (ros::Time::now() - start).toSec());
+
+  return grid;
+}
+
+// Take over a grid handed back by a snapshot, if it covers larger bounds
+// than the current one. Rebuilds it if it was built from an older model.
+void BallsInBoxOccupancyMap::AdoptCoarseGrid() {
+  if (coarse_resolution_ <= 0.0) return;
+
+  std::shared_ptr<const CoarseOccupancyGrid> offered;
+  unsigned int offered_version;
+  {
+    std::lock_guard<std::mutex> lock(coarse_grid_handoff_->mutex);
+    offered = coarse_grid_handoff_->grid;
+    offered_version = coarse_grid_handoff_->version;
+  }
+
+  std::lock_guard<std::mutex> lock(coarse_grid_mutex_);
+  const auto grid = std::atomic_load(&coarse_grid_);
+  if (!offered || offered == grid ||
+      (grid && (offered->Inflation().array() <=
+                grid->Inflation().array()).all()))
+    return;
+
+  std::atomic_store(&coarse_grid_,
+                    (offered_version == Version())
+                        ? offered
+                        : BuildCoarseGrid(offered->Inflation()));
+}
+
+// Label the cell with the given index from the obstacles and sensor FOVs.
+// A cell is occupied if it lies entirely inside an obstacle, and free if it
+// lies entirely inside a sensor FOV and no obstacle touches the cell inflated
+// by the bound. It is unknown if nothing touches the inflated cell.
+CoarseOccupancyGrid::CellLabel BallsInBoxOccupancyMap::ClassifyCell(
+    const CoarseOccupancyGrid& grid, size_t idx) const {
+  Vector3d lower, upper;
+  grid.CellBox(idx, &lower, &upper);
+
+  const Vector3d inflated_lower = lower - grid.Inflation();
+  const Vector3d inflated_upper = upper + grid.Inflation();
+  const Vector3d center = 0.5 * (lower + upper);
+  const double reach = 0.5 * (inflated_upper - inflated_lower).norm();
+
+  // Check obstacles.
+  if (!obstacles_.Registry().empty()) {
+    bool touches_obstacle = false;
+    for (const auto& entry : obstacles_.RadiusSearch(
+             center, reach + largest_obstacle_radius_)) {
+      if (SphereContainsBox(entry.first, entry.second, lower, upper))
+        return CoarseOccupancyGrid::OCCUPIED;
+
+      touches_obstacle |= SphereOverlapsBox(entry.first, entry.second,
+                                            inflated_lower, inflated_upper);
+    }
+
+    if (touches_obstacle) return CoarseOccupancyGrid::AMBIGUOUS;
+  }
+
+  // Check sensor FOVs.
+  bool touches_fov = false;
+  if (!sensor_fovs_.Registry().empty()) {
+    for (const auto& entry : sensor_fovs_.RadiusSearch(
+             center, reach + largest_sensor_radius_)) {
+      if (SphereContainsBox(entry.first, entry.second, lower, upper))
+        return CoarseOccupancyGrid::FREE;
+
+      touches_fov |= SphereOverlapsBox(entry.first, entry.second,
+                                       inflated_lower, inflated_upper);
+    }
+  }
+
+  return (touches_fov) ? CoarseOccupancyGrid::AMBIGUOUS
+                       : CoarseOccupancyGrid::UNKNOWN;
+}
+
+// Relabel the coarse grid cells affected by the given new spheres. Works on a
+// copy of the grid which is swapped in at the end.
+void BallsInBoxOccupancyMap::UpdateCoarseGrid(
+    const std::vector<std::pair<Vector3d, double>>& spheres) {
+  std::lock_guard<std::mutex> lock(coarse_grid_mutex_);
+
+  const auto grid = std::atomic_load(&coarse_grid_);
+  if (!grid || spheres.empty()) return;
+
+  auto new_grid = std::make_shared<CoarseOccupancyGrid>(*grid);
+  for (const auto& entry : spheres) {
+    const Vector3d reach =
+        Vector3d::Constant(entry.second) + grid->Inflation();
+    for (size_t idx :
+         new_grid->CellsOverlapping(entry.first - reach, entry.first + reach))
+      new_grid->SetLabel(idx, ClassifyCell(*new_grid, idx));
+  }
+
+  std::atomic_store(&coarse_grid_,
+                    std::shared_ptr<const CoarseOccupancyGrid>(new_grid));
+}
+
 // Derived classes must have some sort of visualization through RViz.
 void BallsInBoxOccupancyMap::Visualize() const {
   if (vis_pub_.getNumSubscribers() <= 0) return;
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Coarse cost-to-go field over position, maintained incrementally.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/cost_to_go_field.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace fastrack {
+
+CostToGoField::CostToGoField(const Vector3d& lower, const Vector3d& upper,
+                             double resolution)
+    : lower_(lower), resolution_(resolution), has_goal_(false), goal_idx_(0) {
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double num_cells = std::ceil((upper(ii) - lower(ii)) / resolution);
+    dims_[ii] = std::max<size_t>(1, static_cast<size_t>(num_cells));
+  }
+
+  const size_t num_cells = dims_[0] * dims_[1] * dims_[2];
+  g_.resize(num_cells, constants::kInfinity);
+  rhs_.resize(num_cells, constants::kInfinity);
+  blocked_.resize(num_cells, false);
+}
+
+// Set the goal and recompute the whole field. Returns false if the goal is
+// outside the grid.
+bool CostToGoField::SetGoal(const Vector3d& goal) {
+  size_t goal_idx;
+  if (!Index(goal, &goal_idx)) return false;
+
+  std::fill(g_.begin(), g_.end(), constants::kInfinity);
+  std::fill(rhs_.begin(), rhs_.end(), constants::kInfinity);
+  queue_ = decltype(queue_)();
+
+  has_goal_ = true;
+  goal_idx_ = goal_idx;
+  UpdateCell(goal_idx_);
+  Update();
+  return true;
+}
+
+// Mark the cell containing the given point free or blocked. Changes take
+// effect on the next call to Update.
+void CostToGoField::SetBlocked(const Vector3d& p, bool blocked) {
+  size_t idx;
+  if (Index(p, &idx) && blocked_[idx] != blocked) SetCellBlocked(idx, blocked);
+}
+
+// Repair the field after cells changed. Returns the number of cells
+// expanded.
+size_t CostToGoField::Update() {
+  size_t num_expanded = 0;
+  while (!queue_.empty()) {
+    const QueueEntry top = queue_.top();
+    queue_.pop();
+
+    // Skip stale entries.
+    const size_t idx = top.second;
+    if (g_[idx] == rhs_[idx] || top.first != std::min(g_[idx], rhs_[idx]))
+      continue;
+
+    num_expanded++;
+    if (g_[idx] > rhs_[idx]) {
+      // Overconsistent, i.e. got cheaper. Settle it.
+      g_[idx] = rhs_[idx];
+    } else {
+      // Underconsistent, i.e. got more expensive. Invalidate it and
+      // requeue it at its new value.
+      g_[idx] = constants::kInfinity;
+      UpdateCell(idx);
+    }
+
+    ForEachNeighbor(idx, [this](size_t jdx, double) { UpdateCell(jdx); });
+  }
+
+  return num_expanded;
+}
+
+// Index of the cell containing the given point. Returns false if the point
+// is outside the grid.
+bool CostToGoField::Index(const Vector3d& p, size_t* idx) const {
+  size_t cell[3];
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double c = std::floor((p(ii) - lower_(ii)) / resolution_);
+    if (!(c >= 0.0 && c < static_cast<double>(dims_[ii]))) return false;
+    cell[ii] = static_cast<size_t>(c);
+  }
+
+  *idx = cell[0] + dims_[0] * (cell[1] + dims_[1] * cell[2]);
+  return true;
+}
+
+// Center of the cell with the given index.
+Vector3d CostToGoField::Center(size_t idx) const {
+  const size_t ix = idx % dims_[0];
+  const size_t iy = (idx / dims_[0]) % dims_[1];
+  const size_t iz = idx / (dims_[0] * dims_[1]);
+
+  return lower_ + resolution_ * Vector3d(ix + 0.5, iy + 0.5, iz + 0.5);
+}
+
+// Mark a cell blocked or free, and queue it and its neighbors for repair.
+// Edges touching a blocked cell have infinite cost, so the neighbors'
+// lookahead values may change too.
+void CostToGoField::SetCellBlocked(size_t idx, bool blocked) {
+  blocked_[idx] = blocked;
+  if (!has_goal_) return;
+
+  UpdateCell(idx);
+  ForEachNeighbor(idx, [this](size_t jdx, double) { UpdateCell(jdx); });
+}
+
+// Recompute the one-step lookahead value of a cell and queue it if it is
+// inconsistent.
+void CostToGoField::UpdateCell(size_t idx) {
+  if (blocked_[idx]) {
+    rhs_[idx] = constants::kInfinity;
+  } else if (idx == goal_idx_) {
+    rhs_[idx] = 0.0;
+  } else {
+    double rhs = constants::kInfinity;
+    ForEachNeighbor(idx, [this, &rhs](size_t jdx, double cost) {
+      if (!blocked_[jdx]) rhs = std::min(rhs, g_[jdx] + cost);
+    });
+
+    rhs_[idx] = rhs;
+  }
+
+  if (g_[idx] != rhs_[idx]) queue_.emplace(std::min(g_[idx], rhs_[idx]), idx);
+}
+
+}  //\namespace fastrack
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Closed-form steering for a one-dimensional double integrator with bounded
+// acceleration and velocity. Profiles consist of (at most) three phases:
+// accelerate to a cruise velocity, coast, and accelerate to the final
+// velocity. Both the minimum-time profile and a profile of a given (longer)
+// duration may be computed, the latter to synchronize several axes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/double_integrator.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace fastrack {
+
+namespace {
+
+// Numerical slack for bound and consistency checks.
+constexpr double kTolerance = 1e-9;
+
+// Fill in a profile that accelerates from v0 to the given cruise velocity,
+// coasts for the given time, and accelerates to v1, all at full acceleration.
+void BuildProfile(double x0, double v0, double v1, double v_cruise,
+                  double a_max, double coast_time,
+                  DoubleIntegratorProfile* profile) {
+  profile->x0 = x0;
+  profile->v0 = v0;
+  profile->v_cruise = v_cruise;
+
+  profile->a1 = (v_cruise >= v0) ? a_max : -a_max;
+  profile->t1 = std::abs(v_cruise - v0) / a_max;
+  profile->t2 = std::max(0.0, coast_time);
+  profile->a3 = (v1 >= v_cruise) ? a_max : -a_max;
+  profile->t3 = std::abs(v1 - v_cruise) / a_max;
+}
+
+// Are the bounds sensible, and the boundary velocities within them?
+bool CheckBounds(double v0, double v1, double v_min, double v_max,
+                 double a_max) {
+  return a_max > 0.0 && v_min < 0.0 && v_max > 0.0 &&
+         v0 >= v_min - kTolerance && v0 <= v_max + kTolerance &&
+         v1 >= v_min - kTolerance && v1 <= v_max + kTolerance;
+}
+
+}  // namespace
+
+// Position and velocity at the given time since the start of the profile.
+// Times outside [0, Duration()] are clamped.
+void DoubleIntegratorProfile::Evaluate(double t, double* x, double* v) const {
+  t = std::min(std::max(t, 0.0), Duration());
+
+  // First phase.
+  const double tau1 = std::min(t, t1);
+  double position = x0 + v0 * tau1 + 0.5 * a1 * tau1 * tau1;
+  double velocity = v0 + a1 * tau1;
+
+  // Coasting phase.
+  if (t > t1) {
+    const double tau2 = std::min(t - t1, t2);
+    position += v_cruise * tau2;
+    velocity = v_cruise;
+  }
+
+  // Last phase.
+  if (t > t1 + t2) {
+    const double tau3 = std::min(t - t1 - t2, t3);
+    position += v_cruise * tau3 + 0.5 * a3 * tau3 * tau3;
+    velocity = v_cruise + a3 * tau3;
+  }
+
+  if (x) *x = position;
+  if (v) *v = velocity;
+}
+
+// Minimum-time profile from (x0, v0) to (x1, v1), with |a| <= a_max and
+// v_min <= v <= v_max. Requires v_min < 0 < v_max and both boundary
+// velocities within bounds. Returns false if these do not hold.
+bool MinimumTimeProfile(double x0, double v0, double x1, double v1,
+                        double v_min, double v_max, double a_max,
+                        DoubleIntegratorProfile* profile) {
+  if (!profile || !CheckBounds(v0, v1, v_min, v_max, a_max)) return false;
+
+  // Distance covered by changing velocity directly from v0 to v1. If we must
+  // go further, accelerate up to a peak velocity and back down; otherwise
+  // the reverse. Either way, the peak is capped by the velocity bounds and
+  // the remaining distance is covered by coasting at the cap.
+  const double dx = x1 - x0;
+  const double direct = 0.5 * (v0 + v1) * std::abs(v1 - v0) / a_max;
+  const double mean_square = 0.5 * (v0 * v0 + v1 * v1);
+
+  double v_cruise;
+  if (dx >= direct)
+    v_cruise = std::min(
+        v_max, std::sqrt(std::max(0.0, a_max * dx + mean_square)));
+  else
+    v_cruise = std::max(
+        v_min, -std::sqrt(std::max(0.0, mean_square - a_max * dx)));
+
+  // Distance covered while accelerating, and time to coast the rest.
+  const double t1 = std::abs(v_cruise - v0) / a_max;
+  const double t3 = std::abs(v1 - v_cruise) / a_max;
+  const double accelerating = 0.5 * (v0 + v_cruise) * t1 +
+                              0.5 * (v_cruise + v1) * t3;
+  const double coast_time = (std::abs(v_cruise) > kTolerance)
+                                ? (dx - accelerating) / v_cruise
+                                : 0.0;
+
+  BuildProfile(x0, v0, v1, v_cruise, a_max, coast_time, profile);
+  return true;
+}
+
+// Profile from (x0, v0) to (x1, v1) taking exactly the given duration, under
+// the same bounds. Returns false if there is no such profile, which may
+// happen even for durations above the minimum time.
+bool FixedTimeProfile(double x0, double v0, double x1, double v1,
+                      double v_min, double v_max, double a_max,
+                      double duration, DoubleIntegratorProfile* profile) {
+  if (!profile || duration < 0.0 ||
+      !CheckBounds(v0, v1, v_min, v_max, a_max))
+    return false;
+
+  // For each choice of direction of the two acceleration phases (s1, s3),
+  // the distance covered in the given duration is quadratic in the cruise
+  // velocity:
+  //   A v^2 + B v + C = 0,
+  // where C also absorbs the desired distance. Solve for each and keep the
+  // first root consistent with its choice of directions and the bounds.
+  const double dx = x1 - x0;
+  const double position_tolerance = 1e-6 * (1.0 + std::abs(dx));
+
+  for (const double s1 : {1.0, -1.0}) {
+    for (const double s3 : {-1.0, 1.0}) {
+      const double a = 0.5 * (s3 - s1) / a_max;
+      const double b = duration + (s1 * v0 - s3 * v1) / a_max;
+      const double c = 0.5 * (s3 * v1 * v1 - s1 * v0 * v0) / a_max - dx;
+
+      // Candidate cruise velocities.
+      double roots[2];
+      size_t num_roots = 0;
+      if (a == 0.0) {
+        if (std::abs(b) > kTolerance) roots[num_roots++] = -c / b;
+      } else {
+        // At exactly the minimum time the root is double, so allow for
+        // roundoff in the discriminant.
+        const double discriminant = b * b - 4.0 * a * c;
+        if (discriminant < -kTolerance * (b * b + std::abs(4.0 * a * c)))
+          continue;
+
+        const double sqrt_discriminant = std::sqrt(std::max(0.0, discriminant));
+        roots[num_roots++] = 0.5 * (-b + sqrt_discriminant) / a;
+        roots[num_roots++] = 0.5 * (-b - sqrt_discriminant) / a;
+      }
+
+      for (size_t ii = 0; ii < num_roots; ii++) {
+        const double v_cruise = roots[ii];
+
+        // Check bounds and consistency with the chosen directions.
+        if (v_cruise < v_min - kTolerance || v_cruise > v_max + kTolerance ||
+            s1 * (v_cruise - v0) < -kTolerance ||
+            s3 * (v1 - v_cruise) < -kTolerance)
+          continue;
+
+        const double t1 = std::abs(v_cruise - v0) / a_max;
+        const double t3 = std::abs(v1 - v_cruise) / a_max;
+        if (t1 + t3 > duration + kTolerance) continue;
+
+        // Make sure we actually end up in the right place.
+        DoubleIntegratorProfile candidate;
+        BuildProfile(x0, v0, v1, v_cruise, a_max, duration - t1 - t3,
+                     &candidate);
+
+        double x_end;
+        candidate.Evaluate(candidate.Duration(), &x_end, nullptr);
+        if (std::abs(x_end - x1) > position_tolerance) continue;
+
+        *profile = candidate;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace fastrack
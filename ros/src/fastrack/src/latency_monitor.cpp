@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LatencyMonitor class, which listens for traced control messages
+// and periodically publishes percentiles of end-to-end latencies:
+// -- state-to-control: age of the tracker state behind each control
+// -- plan-to-reference: age of the planner trajectory behind each control
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/tracking/latency_monitor.h>
+
+namespace fastrack {
+namespace tracking {
+
+// Callback for processing traced control messages.
+void LatencyMonitor::ControlCallback(
+  const fastrack_msgs::Control::ConstPtr& msg) {
+  const ros::Time now = ros::Time::now();
+
+  // Untraced messages have zero origins.
+  if (!msg->origin.isZero())
+    state_to_control_.Add((now - msg->origin).toSec());
+  if (!msg->reference_origin.isZero())
+    plan_to_reference_.Add((now - msg->reference_origin).toSec());
+}
+
+// Timer callback. Publish latency statistics.
+void LatencyMonitor::TimerCallback(const ros::TimerEvent& e) const {
+  stats_pub_.publish(Summarize("state_to_control", state_to_control_));
+  stats_pub_.publish(Summarize("plan_to_reference", plan_to_reference_));
+}
+
+// Summarize the given latency estimator.
+fastrack_msgs::LatencyStats LatencyMonitor::Summarize(
+  const std::string& name, const QuantileEstimator& latency) {
+  fastrack_msgs::LatencyStats stats;
+  stats.name = name;
+  stats.count = latency.Size();
+  stats.p50 = latency.Quantile(0.5);
+  stats.p90 = latency.Quantile(0.9);
+  stats.p99 = latency.Quantile(0.99);
+  stats.max = latency.Quantile(1.0);
+
+  return stats;
+}
+
+// Initialize this class with all parameters and callbacks.
+bool LatencyMonitor::Initialize(const ros::NodeHandle& n) {
+  name_ = ros::names::append(n.getNamespace(), "LatencyMonitor");
+
+  // Load parameters.
+  if (!LoadParameters(n)) {
+    ROS_ERROR("%s: Failed to load parameters.", name_.c_str());
+    return false;
+  }
+
+  // Register callbacks.
+  if (!RegisterCallbacks(n)) {
+    ROS_ERROR("%s: Failed to register callbacks.", name_.c_str());
+    return false;
+  }
+
+  initialized_ = true;
+  return true;
+}
+
+// Load parameters.
+bool LatencyMonitor::LoadParameters(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
+  // Topics.
+  if (!nl.getParam("topic/control", control_topic_)) return false;
+  if (!nl.getParam("topic/stats", stats_topic_)) return false;
+
+  // Time step for publishing statistics.
+  if (!nl.getParam("time_step", time_step_)) return false;
+
+  // Number of samples in the sliding window.
+  int window = 0;
+  if (!nl.getParam("window", window)) return false;
+  if (window <= 0) {
+    ROS_ERROR("%s: Window must be positive.", name_.c_str());
+    return false;
+  }
+
+  state_to_control_ = QuantileEstimator(static_cast<size_t>(window));
+  plan_to_reference_ = QuantileEstimator(static_cast<size_t>(window));
+
+  return true;
+}
+
+// Register callbacks.
+bool LatencyMonitor::RegisterCallbacks(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
+  // Subscribers.
+  control_sub_ = nl.subscribe(control_topic_.c_str(), 1,
+    &LatencyMonitor::ControlCallback, this);
+
+  // Publishers.
+  stats_pub_ = nl.advertise<fastrack_msgs::LatencyStats>(
+    stats_topic_.c_str(), 10, false);
+
+  // Timer.
+  timer_ = nl.createTimer(ros::Duration(time_step_),
+    &LatencyMonitor::TimerCallback, this);
+
+  return true;
+}
+
+} //\namespace tracking
+} //\namespace fastrack
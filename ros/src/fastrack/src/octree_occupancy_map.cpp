@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// OctreeOccupancyMap: occupancy map stored in a multi-resolution octree.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/environment/octree_occupancy_map.h>
+
+namespace fastrack {
+namespace environment {
+
+// Occupancy probability for a single point.
+double OctreeOccupancyMap::OccupancyProbability(const Vector3d& p,
+                                                double time) const {
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check without initializing.",
+             name_.c_str());
+    return kOccupiedProbability;
+  }
+
+  // Check box limits.
+  if (p(0) < lower_(0) || p(0) > upper_(0) || p(1) < lower_(1) ||
+      p(1) > upper_(1) || p(2) < lower_(2) || p(2) > upper_(2))
+    return kOccupiedProbability;
+
+  return LabelProbability(octree_->Query(p));
+}
+
+// Occupancy probability for a tracking error bound centered at the given
+// point. Known bound types are dispatched to their templated versions.
+double OctreeOccupancyMap::OccupancyProbability(const Vector3d& p,
+                                                const TrackingBound& bound,
+                                                double time) const {
+  if (const auto* box = dynamic_cast<const bound::Box*>(&bound))
+    return OccupancyProbability<bound::Box>(p, *box, time);
+  if (const auto* cylinder = dynamic_cast<const bound::Cylinder*>(&bound))
+    return OccupancyProbability<bound::Cylinder>(p, *cylinder, time);
+  if (const auto* sphere = dynamic_cast<const bound::Sphere*>(&bound))
+    return OccupancyProbability<bound::Sphere>(p, *sphere, time);
+
+  return OccupancyProbability<TrackingBound>(p, bound, time);
+}
+
+// Update this environment with the information contained in the given
+// sensor measurement. Returns whether the model changed.
+// NOTE! This function needs to publish on `updated_topic_` if so.
+bool OctreeOccupancyMap::SensorCallback(
+    const fastrack_msgs::SensedSpheres::ConstPtr& msg) {
+  // Mark the sensor FOV free. Leaves which are already occupied stay occupied.
+  const Vector3d sensor_position(msg->sensor_position.x, msg->sensor_position.y,
+                                 msg->sensor_position.z);
+  bool updated_env =
+      octree_->InsertFreeSphere(sensor_position, msg->sensor_radius);
+
+  // Check list lengths.
+  if (msg->centers.size() != msg->radii.size())
+    ROS_WARN("%s: Malformed SensedSpheres msg.", name_.c_str());
+
+  const size_t num_obstacles = std::min(msg->centers.size(), msg->radii.size());
+
+  // Mark each obstacle occupied.
+  for (size_t ii = 0; ii < num_obstacles; ii++) {
+    const Vector3d p(msg->centers[ii].x, msg->centers[ii].y,
+                     msg->centers[ii].z);
+    updated_env |= octree_->InsertOccupiedSphere(p, msg->radii[ii]);
+  }
+
+  // Let the system know this environment has been updated.
+  if (updated_env) updated_pub_.publish(std_msgs::Empty());
+
+  // Visualize.
+  Visualize();
+  return updated_env;
+}
+
+// Incorporate a ray-cast scan. Returns whether the model changed, and also
+// publishes on `updated_topic_` if so.
+bool OctreeOccupancyMap::RaysCallback(
+    const fastrack_msgs::SensedRays::ConstPtr& msg) {
+  // Check list lengths.
+  if (msg->endpoints.size() != msg->hits.size())
+    ROS_WARN("%s: Malformed SensedRays msg.", name_.c_str());
+
+  const size_t num_rays = std::min(msg->endpoints.size(), msg->hits.size());
+
+  // Clear along each ray, and mark hits occupied.
+  const Vector3d sensor_position(msg->sensor_position.x, msg->sensor_position.y,
+                                 msg->sensor_position.z);
+  bool updated_env = false;
+  for (size_t ii = 0; ii < num_rays; ii++) {
+    const Vector3d endpoint(msg->endpoints[ii].x, msg->endpoints[ii].y,
+                            msg->endpoints[ii].z);
+    updated_env |=
+        octree_->InsertRay(sensor_position, endpoint, msg->hits[ii] != 0);
+  }
+
+  // Let the system know this environment has been updated.
+  if (updated_env) updated_pub_.publish(std_msgs::Empty());
+
+  // Visualize.
+  Visualize();
+  return updated_env;
+}
+
+// Generate a sensor measurement as a service response.
+fastrack_msgs::SensedSpheres OctreeOccupancyMap::SimulateSensor(
+    const SphereSensorParams& params) const {
+  fastrack_msgs::SensedSpheres msg;
+
+  const Vector3d range = Vector3d::Constant(params.range);
+  octree_->ForEachLeaf(
+      params.position - range, params.position + range,
+      [&params, &msg](const Vector3d& lower, double size,
+                      OccupancyOctree::Label label) {
+        if (label != OccupancyOctree::OCCUPIED) return;
+
+        // Check if the circumscribing sphere is actually in range.
+        const Vector3d center = lower + Vector3d::Constant(0.5 * size);
+        const double radius = 0.5 * std::sqrt(3.0) * size;
+        if ((params.position - center).norm() >= params.range + radius)
+          return;
+
+        geometry_msgs::Vector3 c;
+        c.x = center(0);
+        c.y = center(1);
+        c.z = center(2);
+
+        msg.centers.push_back(c);
+        msg.radii.push_back(radius);
+      });
+
+  return msg;
+}
+
+// Load parameters. This may be overridden by derived classes if needed
+// (they should still call this one via OccupancyMap::LoadParameters).
+bool OctreeOccupancyMap::LoadParameters(const ros::NodeHandle& n) {
+  if (!OccupancyMap::LoadParameters(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Leaf resolution.
+  if (!nl.getParam("env/octree/resolution", resolution_)) return false;
+  if (resolution_ <= 0.0) {
+    ROS_ERROR("%s: Octree resolution must be positive.", name_.c_str());
+    return false;
+  }
+
+  octree_.reset(new OccupancyOctree(lower_, upper_, resolution_));
+
+  // Optional maximum query depth. Defaults to the full depth of the octree.
+  int max_query_depth = static_cast<int>(octree_->MaxDepth());
+  nl.getParam("env/octree/max_query_depth", max_query_depth);
+  max_query_depth_ = static_cast<size_t>(std::max(0, max_query_depth));
+
+  // Optional topic for ray-cast scans.
+  nl.getParam("topic/rays_sub", rays_topic_);
+
+  ROS_INFO("%s: Octree has depth %zu with %f m leaves.", name_.c_str(),
+           octree_->MaxDepth(), resolution_);
+  return true;
+}
+
+// Register callbacks.
+bool OctreeOccupancyMap::RegisterCallbacks(const ros::NodeHandle& n) {
+  if (!OccupancyMap::RegisterCallbacks(n)) return false;
+
+  ros::NodeHandle nl = UpdateNodeHandle(n);
+
+  if (!rays_topic_.empty()) {
+    rays_sub_ = nl.subscribe(rays_topic_.c_str(), 1,
+                             &OctreeOccupancyMap::RecordAndRaysCallback, this);
+  }
+
+  return true;
+}
+
+// Visualize the environment box and occupied leaves. Leaves have different
+// sizes, so they are published as one cube list per depth.
+void OctreeOccupancyMap::Visualize() const {
+  if (vis_pub_.getNumSubscribers() <= 0) return;
+
+  // Set up box marker.
+  visualization_msgs::Marker cube;
+  cube.ns = "cube";
+  cube.header.frame_id = fixed_frame_;
+  cube.header.stamp = ros::Time::now();
+  cube.id = 0;
+  cube.type = visualization_msgs::Marker::CUBE;
+  cube.action = visualization_msgs::Marker::ADD;
+  cube.color.a = 0.5;
+  cube.color.r = 0.3;
+  cube.color.g = 0.7;
+  cube.color.b = 0.7;
+
+  geometry_msgs::Point center;
+
+  // Fill in center and scale.
+  cube.scale.x = upper_(0) - lower_(0);
+  center.x = lower_(0) + 0.5 * cube.scale.x;
+
+  cube.scale.y = upper_(1) - lower_(1);
+  center.y = lower_(1) + 0.5 * cube.scale.y;
+
+  cube.scale.z = upper_(2) - lower_(2);
+  center.z = lower_(2) + 0.5 * cube.scale.z;
+
+  cube.pose.position = center;
+  cube.pose.orientation.x = 0.0;
+  cube.pose.orientation.y = 0.0;
+  cube.pose.orientation.z = 0.0;
+  cube.pose.orientation.w = 1.0;
+
+  // Publish cube marker.
+  vis_pub_.publish(cube);
+
+  // Collect occupied leaves by depth.
+  std::vector<visualization_msgs::Marker> leaves(octree_->MaxDepth() + 1);
+  for (size_t ii = 0; ii < leaves.size(); ii++) {
+    const double size = resolution_ * std::pow(2.0, leaves.size() - 1 - ii);
+
+    auto& marker = leaves[ii];
+    marker.ns = "occupied";
+    marker.header.frame_id = fixed_frame_;
+    marker.header.stamp = ros::Time::now();
+    marker.id = static_cast<int>(ii);
+    marker.type = visualization_msgs::Marker::CUBE_LIST;
+    marker.action = visualization_msgs::Marker::ADD;
+
+    marker.scale.x = size;
+    marker.scale.y = size;
+    marker.scale.z = size;
+
+    marker.color.a = 0.9;
+    marker.color.r = 0.7;
+    marker.color.g = 0.5;
+    marker.color.b = 0.5;
+
+    marker.pose.orientation.w = 1.0;
+  }
+
+  octree_->ForEachLeaf(
+      lower_, upper_,
+      [this, &leaves](const Vector3d& lower, double size,
+                      OccupancyOctree::Label label) {
+        if (label != OccupancyOctree::OCCUPIED) return;
+
+        // Depth from the ratio of sizes, which are powers of two.
+        const size_t depth = leaves.size() - 1 -
+            static_cast<size_t>(std::round(std::log2(size / resolution_)));
+
+        geometry_msgs::Point p;
+        p.x = lower(0) + 0.5 * size;
+        p.y = lower(1) + 0.5 * size;
+        p.z = lower(2) + 0.5 * size;
+        leaves[depth].points.push_back(p);
+      });
+
+  for (const auto& marker : leaves) {
+    if (!marker.points.empty()) vis_pub_.publish(marker);
+  }
+}
+
+}  //\namespace environment
+}  //\namespace fastrack
@@ -227,6 +227,14 @@ fastrack_msgs::State PlanarDubins3D::ToRos() const {
   return msg;
 }
 
+// Write the same values as ToRos into a flat buffer.
+void PlanarDubins3D::Pack(double* x) const {
+  x[0] = x_;
+  x[1] = y_;
+  x[2] = theta_;
+  x[3] = v_;
+}
+
 // Get bounds of state space.
 const PlanarDubins3D& PlanarDubins3D::GetLower() { return lower_; }
 const PlanarDubins3D& PlanarDubins3D::GetUpper() { return upper_; }
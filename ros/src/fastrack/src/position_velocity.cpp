@@ -253,6 +253,16 @@ fastrack_msgs::State PositionVelocity::ToRos() const {
   return msg;
 }
 
+// Write the same values as ToRos into a flat buffer.
+void PositionVelocity::Pack(double* x) const {
+  x[0] = position_(0);
+  x[1] = position_(1);
+  x[2] = position_(2);
+  x[3] = velocity_(0);
+  x[4] = velocity_(1);
+  x[5] = velocity_(2);
+}
+
 // Get bounds of state space.
 const PositionVelocity& PositionVelocity::GetLower() { return lower_; }
 const PositionVelocity& PositionVelocity::GetUpper() { return upper_; }
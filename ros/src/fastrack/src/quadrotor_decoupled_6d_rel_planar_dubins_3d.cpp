@@ -69,48 +69,9 @@ std::unique_ptr<RelativeState<PositionVelocity, PlanarDubins3D>>
 QuadrotorDecoupled6DRelPlanarDubins3D::Evaluate(
     const PositionVelocity& tracker_x, const QuadrotorControl& tracker_u,
     const PlanarDubins3D& planner_x, const double& planner_u) const {
-  // Compute relative state.
-  const PositionVelocityRelPlanarDubins3D relative_x(tracker_x, planner_x);
-
-  // Net instantaneous tangent velocity (PositionVelocity minus Dubins).
-  // This is used in the derivatives of relative position (distance, bearing).
-  // It is NOT used in the velocity derivatives because velocity states are
-  // absolute (even though they are expressed in the changing Dubins frame).
-  const auto net_tangent_velocity =
-      relative_x.TangentVelocity() - planner_x.V();
-
-  // Relative distance derivative.
-  const double distance_dot =
-      net_tangent_velocity * std::cos(relative_x.Bearing()) +
-      relative_x.NormalVelocity() * std::sin(relative_x.Bearing());
-
-  // Relative bearing derivative.
-  const double bearing_dot =
-      -planner_u +
-      (-net_tangent_velocity * std::sin(relative_x.Bearing()) +
-       relative_x.NormalVelocity() * std::cos(relative_x.Bearing())) /
-          relative_x.Distance();  // omega_circ = v_circ / R
-
-  // Tracker accelerations expressed in inertial world frame.
-  const double tracker_accel_x = constants::G * std::tan(tracker_u.pitch);
-  const double tracker_accel_y = -constants::G * std::tan(tracker_u.roll);
-
-  // Relative tangent and normal velocity derivatives.
-  // NOTE! Must rotate roll/pitch into planner frame.
-  const double c = std::cos(planner_x.Theta());
-  const double s = std::sin(planner_x.Theta());
-
-  const double tangent_velocity_dot = tracker_accel_x * c +
-                                      tracker_accel_y * s +
-                                      planner_u * relative_x.NormalVelocity();
-  const double normal_velocity_dot = -tracker_accel_x * s +
-                                     tracker_accel_y * c -
-                                     planner_u * relative_x.TangentVelocity();
-
   return std::unique_ptr<PositionVelocityRelPlanarDubins3D>(
-      new PositionVelocityRelPlanarDubins3D(distance_dot, bearing_dot,
-                                            tangent_velocity_dot,
-                                            normal_velocity_dot));
+      new PositionVelocityRelPlanarDubins3D(
+          EvaluateRelative(tracker_x, tracker_u, planner_x, planner_u)));
 }
 
 // Derived classes must be able to compute an optimal control given
@@ -121,35 +82,10 @@ QuadrotorControl QuadrotorDecoupled6DRelPlanarDubins3D::OptimalControl(
     const RelativeState<PositionVelocity, PlanarDubins3D>& value_gradient,
     const ControlBound<QuadrotorControl>& tracker_u_bound,
     const ControlBound<double>& planner_u_bound) const {
-  // Get internal state of value gradient and map tracker control (negative)
-  // coefficients to QuadrotorControl, so we get a negative gradient.
-  const auto& grad =
-      static_cast<const PositionVelocityRelPlanarDubins3D&>(value_gradient);
-
-  // Translate gradient into (negative) control-affine terms for pitch and roll.
-  const double c = std::cos(planner_x.Theta());
-  const double s = std::sin(planner_x.Theta());
-
-  QuadrotorControl negative_grad;
-  negative_grad.pitch =
-      -(grad.TangentVelocity() * c - grad.NormalVelocity() * s);
-  negative_grad.roll =
-      -(-grad.TangentVelocity() * s - grad.NormalVelocity() * c);
-  negative_grad.thrust = 0.0;    // Vertical position controlled externally.
-  negative_grad.yaw_rate = 0.0;  // Yaw controlled externally.
-
-  // Project onto tracker control bound and make sure to zero out yaw_rate.
-  QuadrotorControl u = tracker_u_bound.ProjectToSurface(negative_grad);
-
-  // Adjust non-bang-bang control inputs.
-  u.yaw_rate = 0.0;            // Yaw controlled externally.
-  constexpr double k_p = 1.5;  // HACK! PD constants are hard-coded.
-  constexpr double k_d = 1.0;  // (from k_manual.txt in crazyflie_clean).
-  u.thrust =
-      constants::G + k_p * (planner_x.Z() - tracker_x.Z()) +
-      k_d * (planner_x.Vz() - tracker_x.Vz());  // Vertical PD controller.
-
-  return u;
+  return OptimalControl(
+      tracker_x, planner_x,
+      static_cast<const PositionVelocityRelPlanarDubins3D&>(value_gradient),
+      tracker_u_bound, planner_u_bound);
 }
 
 }  // namespace dynamics
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Running quantile estimator over a sliding window of the most recent scalar
+// samples, e.g. to track the p99 latency of a recurring operation.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/quantile_estimator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace fastrack {
+
+// Add a new sample, overwriting the oldest one once the window is full.
+void QuantileEstimator::Add(double sample) {
+  if (window_size_ == 0) return;
+
+  if (samples_.size() < window_size_) {
+    samples_.push_back(sample);
+  } else {
+    // Drop the oldest sample from the sorted window.
+    sorted_.erase(std::lower_bound(sorted_.begin(), sorted_.end(),
+                                   samples_[next_idx_]));
+    samples_[next_idx_] = sample;
+  }
+
+  sorted_.insert(std::upper_bound(sorted_.begin(), sorted_.end(), sample),
+                 sample);
+
+  next_idx_ = (next_idx_ + 1) % window_size_;
+}
+
+// Estimate the given quantile (in [0, 1]) of the samples in the window.
+// Returns NaN if there are no samples.
+double QuantileEstimator::Quantile(double q) const {
+  if (samples_.empty()) return std::numeric_limits<double>::quiet_NaN();
+
+  // Nearest-rank quantile, rounding up so that high quantiles stay
+  // conservative with small windows.
+  const double clamped = std::min(1.0, std::max(0.0, q));
+  const size_t rank = static_cast<size_t>(
+      std::ceil(clamped * static_cast<double>(samples_.size())));
+  const size_t idx = (rank == 0) ? 0 : rank - 1;
+  return sorted_[idx];
+}
+
+}  // namespace fastrack
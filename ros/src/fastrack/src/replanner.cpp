@@ -67,10 +67,14 @@ void Replanner::ReplanRequestCallback(
   if (!replan_srv_.call(replan)) {
     ROS_ERROR("%s: Replan server error.", name_.c_str());
     replan.response.traj.states.clear();
+    replan.response.traj.packed.clear();
     replan.response.traj.times.clear();
   }
 
-  // Publish trajectory.
+  // Carry the request's trace over to the trajectory, and publish.
+  replan.response.traj.origin = msg->origin;
+  replan.response.traj.trace = msg->trace;
+  replan.response.traj.trace.push_back(ros::Time::now());
   traj_pub_.publish(replan.response.traj);
 }
 
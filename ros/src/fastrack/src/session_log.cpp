@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Compact binary log of everything a planner process sees during a session:
+// replan requests, sensor messages, tracking bound and dynamics service
+// responses, and random seeds. Each record is a ROS-serialized message,
+// prefixed by its type, time stamp, and length. Sessions may be replayed
+// deterministically with the SessionReplayer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/session_log.h>
+
+#include <cstring>
+
+namespace fastrack {
+
+namespace {
+// File header, including format version.
+static constexpr char kMagic[] = "FTSESS01";
+static constexpr size_t kMagicLength = sizeof(kMagic) - 1;
+
+// How often to flush records to disk, so that most of a log survives a crash.
+static constexpr std::chrono::milliseconds kFlushPeriod(1000);
+}  // namespace
+
+// Open a file. Returns bool upon success.
+bool SessionRecorder::Open(const std::string& file_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_.is_open()) file_.close();
+
+  file_.open(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file_.is_open()) return false;
+
+  file_.write(kMagic, kMagicLength);
+  last_flush_ = std::chrono::steady_clock::now();
+  return file_.good();
+}
+
+// Close the file, flushing any buffered records.
+void SessionRecorder::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_.is_open()) file_.close();
+}
+
+// Write a raw record.
+void SessionRecorder::Write(SessionRecordType type, const ros::Time& stamp,
+                            const std::vector<uint8_t>& data) {
+  const uint8_t t = type;
+  const uint32_t sec = stamp.sec;
+  const uint32_t nsec = stamp.nsec;
+  const uint32_t length = static_cast<uint32_t>(data.size());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.write(reinterpret_cast<const char*>(&t), sizeof(t));
+  file_.write(reinterpret_cast<const char*>(&sec), sizeof(sec));
+  file_.write(reinterpret_cast<const char*>(&nsec), sizeof(nsec));
+  file_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+  file_.write(reinterpret_cast<const char*>(data.data()), length);
+
+  // Flush periodically rather than per record, which would stall whoever is
+  // recording (e.g. the sensor updater) on disk writes.
+  const auto now = std::chrono::steady_clock::now();
+  if (now - last_flush_ >= kFlushPeriod) {
+    file_.flush();
+    last_flush_ = now;
+  }
+}
+
+// Open a file. Returns bool upon success.
+bool SessionReader::Open(const std::string& file_name) {
+  if (file_.is_open()) file_.close();
+
+  file_.open(file_name, std::ios::in | std::ios::binary);
+  if (!file_.is_open()) return false;
+
+  // Check header.
+  char magic[kMagicLength];
+  file_.read(magic, kMagicLength);
+  return file_.good() && std::memcmp(magic, kMagic, kMagicLength) == 0;
+}
+
+// Read the next record. Returns false at the end of the file or on error.
+bool SessionReader::Next(SessionRecord* record) {
+  if (!record || !file_.is_open()) return false;
+
+  uint8_t t;
+  uint32_t sec, nsec, length;
+  file_.read(reinterpret_cast<char*>(&t), sizeof(t));
+  file_.read(reinterpret_cast<char*>(&sec), sizeof(sec));
+  file_.read(reinterpret_cast<char*>(&nsec), sizeof(nsec));
+  file_.read(reinterpret_cast<char*>(&length), sizeof(length));
+  if (!file_.good() || t > RAYS) return false;
+
+  record->type = static_cast<SessionRecordType>(t);
+  record->stamp = ros::Time(sec, nsec);
+  record->data.resize(length);
+  file_.read(reinterpret_cast<char*>(record->data.data()), length);
+
+  return file_.good();
+}
+
+}  // namespace fastrack
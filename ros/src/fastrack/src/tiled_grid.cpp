@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Out-of-core storage for a multi-channel grid, paged in by tiles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/matlab_file_reader.h>
+#include <fastrack/utils/tiled_grid.h>
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+namespace fastrack {
+
+namespace {
+// File header.
+static constexpr char kMagic[4] = {'F', 'T', 'T', 'G'};
+static constexpr uint32_t kVersion = 2;
+
+// Maximum number of queued requests per cached tile. Older requests are
+// dropped first, since the state has moved on since.
+static constexpr size_t kRequestsPerTile = 4;
+
+// Largest number of doubles a file may hold, so that byte offsets fit.
+static constexpr size_t kMaxDoubles =
+    static_cast<size_t>(std::numeric_limits<std::streamoff>::max()) /
+    (2 * sizeof(double));
+
+// Product of the given factors. Returns false on overflow.
+bool Product(const std::vector<size_t>& factors, size_t* product) {
+  *product = 1;
+  for (size_t f : factors) {
+    if (f != 0 && *product > std::numeric_limits<size_t>::max() / f)
+      return false;
+    *product *= f;
+  }
+
+  return true;
+}
+
+// Advance a row-major multi-index within the given extents. Returns false
+// after the last index.
+bool Increment(const std::vector<size_t>& extents, std::vector<size_t>* index) {
+  for (size_t ii = extents.size(); ii-- > 0;) {
+    if (++(*index)[ii] < extents[ii]) return true;
+    (*index)[ii] = 0;
+  }
+
+  return false;
+}
+
+// Row-major index of the given multi-index.
+size_t RowMajor(const std::vector<size_t>& extents, const size_t* index) {
+  size_t idx = 0;
+  for (size_t ii = 0; ii < extents.size(); ii++)
+    idx = idx * extents[ii] + index[ii];
+
+  return idx;
+}
+
+// Number of blocks of the given size needed to cover each extent.
+std::vector<size_t> NumBlocks(const std::vector<size_t>& extents,
+                              const std::vector<size_t>& block) {
+  std::vector<size_t> num_blocks(extents.size());
+  for (size_t ii = 0; ii < extents.size(); ii++)
+    num_blocks[ii] = (extents[ii] + block[ii] - 1) / block[ii];
+
+  return num_blocks;
+}
+
+template <typename T>
+void WriteRaw(std::ofstream& file, const T& value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadRaw(std::ifstream& file, T* value) {
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char*>(value), sizeof(T)));
+}
+
+}  // namespace
+
+TiledGrid::TiledGrid()
+    : num_channels_(0),
+      coarse_factor_(1),
+      cells_per_tile_(0),
+      tiles_offset_(0),
+      cache_size_(0),
+      num_hits_(0),
+      num_misses_(0),
+      stop_(false) {}
+
+TiledGrid::~TiledGrid() {
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    stop_ = true;
+  }
+
+  request_cv_.notify_all();
+  if (loader_.joinable()) loader_.join();
+}
+
+// Write a grid in the tiled format. Each channel holds one value per cell
+// in row-major order. Returns whether or not writing was successful.
+bool TiledGrid::Write(const std::string& file_name,
+                      const std::vector<size_t>& num_cells,
+                      const std::vector<const std::vector<double>*>& channels,
+                      const std::vector<size_t>& tile_cells,
+                      size_t coarse_factor) {
+  const size_t dimension = num_cells.size();
+  if (dimension == 0 || tile_cells.size() != dimension || channels.empty() ||
+      coarse_factor == 0 ||
+      std::count(num_cells.begin(), num_cells.end(), 0) > 0 ||
+      std::count(tile_cells.begin(), tile_cells.end(), 0) > 0) {
+    ROS_ERROR("TiledGrid: Invalid grid layout.");
+    return false;
+  }
+
+  size_t total_num_cells = 1;
+  for (size_t n : num_cells) total_num_cells *= n;
+  for (const auto* channel : channels) {
+    if (!channel || channel->size() != total_num_cells) {
+      ROS_ERROR("TiledGrid: Channel was of the wrong size.");
+      return false;
+    }
+  }
+
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ROS_ERROR("TiledGrid: Could not open %s.", file_name.c_str());
+    return false;
+  }
+
+  // Header.
+  file.write(kMagic, sizeof(kMagic));
+  WriteRaw(file, kVersion);
+  WriteRaw(file, static_cast<uint32_t>(dimension));
+  WriteRaw(file, static_cast<uint32_t>(channels.size()));
+  for (size_t n : num_cells) WriteRaw(file, static_cast<uint64_t>(n));
+  for (size_t t : tile_cells) WriteRaw(file, static_cast<uint64_t>(t));
+  WriteRaw(file, static_cast<uint64_t>(coarse_factor));
+
+  // Coarse level. Each coarse cell holds the minimum and maximum of every
+  // channel over the fine cells it covers, so that lookups which fall back
+  // to it can stay conservative.
+  const std::vector<size_t> num_coarse_cells =
+      NumBlocks(num_cells, std::vector<size_t>(dimension, coarse_factor));
+  std::vector<size_t> coarse(dimension, 0);
+  std::vector<size_t> fine(dimension);
+  std::vector<size_t> block(dimension);
+  std::vector<double> lower(channels.size()), upper(channels.size());
+  do {
+    for (size_t ii = 0; ii < dimension; ii++)
+      block[ii] = std::min(coarse_factor,
+                           num_cells[ii] - coarse[ii] * coarse_factor);
+
+    std::fill(lower.begin(), lower.end(), std::numeric_limits<double>::max());
+    std::fill(upper.begin(), upper.end(),
+              std::numeric_limits<double>::lowest());
+
+    std::vector<size_t> local(dimension, 0);
+    do {
+      for (size_t ii = 0; ii < dimension; ii++)
+        fine[ii] = coarse[ii] * coarse_factor + local[ii];
+
+      const size_t idx = RowMajor(num_cells, fine.data());
+      for (size_t jj = 0; jj < channels.size(); jj++) {
+        lower[jj] = std::min(lower[jj], (*channels[jj])[idx]);
+        upper[jj] = std::max(upper[jj], (*channels[jj])[idx]);
+      }
+    } while (Increment(block, &local));
+
+    for (double l : lower) WriteRaw(file, l);
+    for (double u : upper) WriteRaw(file, u);
+  } while (Increment(num_coarse_cells, &coarse));
+
+  // Tiles, padded at the boundary.
+  const std::vector<size_t> num_tiles = NumBlocks(num_cells, tile_cells);
+  std::vector<size_t> tile(dimension, 0);
+  do {
+    std::vector<size_t> local(dimension, 0);
+    do {
+      bool inside = true;
+      for (size_t ii = 0; ii < dimension; ii++) {
+        fine[ii] = tile[ii] * tile_cells[ii] + local[ii];
+        inside &= fine[ii] < num_cells[ii];
+      }
+
+      const size_t idx = (inside) ? RowMajor(num_cells, fine.data()) : 0;
+      for (const auto* channel : channels)
+        WriteRaw(file, (inside) ? (*channel)[idx] : 0.0);
+    } while (Increment(tile_cells, &local));
+  } while (Increment(num_tiles, &tile));
+
+  return file.good();
+}
+
+// Convert a value function mat file (with 'num_cells', 'data' and
+// 'deriv_<ii>' in every dimension) to a tiled file with the value and
+// then the gradient as channels. Tiles have 'tile_cells' cells per side.
+bool TiledGrid::WriteValueFunction(const std::string& mat_file_name,
+                                   const std::string& tile_file_name,
+                                   size_t tile_cells, size_t coarse_factor) {
+  MatlabFileReader reader(mat_file_name);
+  if (!reader.IsOpen()) return false;
+
+  std::vector<size_t> num_cells;
+  if (!reader.ReadVector("num_cells", &num_cells)) return false;
+
+  std::vector<std::vector<double>> grids(num_cells.size() + 1);
+  if (!reader.ReadVector("data", &grids[0])) return false;
+  for (size_t ii = 0; ii < num_cells.size(); ii++) {
+    if (!reader.ReadVector("deriv_" + std::to_string(ii), &grids[ii + 1])) {
+      ROS_ERROR("TiledGrid: Could not read deriv_%zu.", ii);
+      return false;
+    }
+  }
+
+  std::vector<const std::vector<double>*> channels;
+  for (const auto& grid : grids) channels.push_back(&grid);
+
+  return Write(tile_file_name, num_cells, channels,
+               std::vector<size_t>(num_cells.size(), tile_cells),
+               coarse_factor);
+}
+
+// Open a tiled file, keeping at most 'cache_size' tiles resident, and
+// start the loader. Returns whether or not opening was successful.
+bool TiledGrid::Open(const std::string& file_name, size_t cache_size) {
+  if (loader_.joinable()) {
+    ROS_ERROR("TiledGrid: Already open.");
+    return false;
+  }
+
+  file_.open(file_name, std::ios::binary);
+  if (!file_.is_open()) {
+    ROS_ERROR("TiledGrid: Could not open %s.", file_name.c_str());
+    return false;
+  }
+
+  // Header.
+  char magic[sizeof(kMagic)];
+  uint32_t version, dimension, num_channels;
+  if (!file_.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !ReadRaw(file_, &version) || version != kVersion ||
+      !ReadRaw(file_, &dimension) || !ReadRaw(file_, &num_channels) ||
+      dimension == 0 || num_channels == 0) {
+    ROS_ERROR("TiledGrid: %s is not a tiled grid.", file_name.c_str());
+    return false;
+  }
+
+  uint64_t value;
+  num_cells_.clear();
+  tile_cells_.clear();
+  for (size_t ii = 0; ii < 2 * dimension + 1; ii++) {
+    if (!ReadRaw(file_, &value) || value == 0 || value > kMaxDoubles) {
+      ROS_ERROR("TiledGrid: Invalid layout in %s.", file_name.c_str());
+      return false;
+    }
+
+    if (ii < dimension)
+      num_cells_.push_back(value);
+    else if (ii < 2 * dimension)
+      tile_cells_.push_back(value);
+    else
+      coarse_factor_ = value;
+  }
+
+  num_channels_ = num_channels;
+  cache_size_ = std::max<size_t>(1, cache_size);
+  num_tiles_ = NumBlocks(num_cells_, tile_cells_);
+  num_coarse_cells_ = NumBlocks(
+      num_cells_, std::vector<size_t>(dimension, coarse_factor_));
+
+  // Make sure the coarse level and all tiles are there before allocating
+  // anything, so that a corrupt header cannot ask for absurd sizes.
+  size_t coarse_size = 0, tiles_size = 0;
+  std::vector<size_t> coarse_factors(num_coarse_cells_);
+  coarse_factors.push_back(2 * num_channels_);
+  std::vector<size_t> tile_factors(num_tiles_);
+  tile_factors.insert(tile_factors.end(), tile_cells_.begin(),
+                      tile_cells_.end());
+  tile_factors.push_back(num_channels_);
+  if (!Product(coarse_factors, &coarse_size) ||
+      !Product(tile_factors, &tiles_size) ||
+      coarse_size > kMaxDoubles || tiles_size > kMaxDoubles - coarse_size) {
+    ROS_ERROR("TiledGrid: Invalid layout in %s.", file_name.c_str());
+    return false;
+  }
+
+  const std::streamoff coarse_offset = file_.tellg();
+  file_.seekg(0, std::ios::end);
+  const std::streamoff expected_size =
+      coarse_offset +
+      static_cast<std::streamoff>((coarse_size + tiles_size) * sizeof(double));
+  if (file_.tellg() < expected_size) {
+    ROS_ERROR("TiledGrid: Truncated tiles in %s.", file_name.c_str());
+    return false;
+  }
+
+  cells_per_tile_ = 1;
+  for (size_t t : tile_cells_) cells_per_tile_ *= t;
+
+  // Coarse level.
+  file_.seekg(coarse_offset);
+  coarse_.resize(coarse_size);
+  if (!file_.read(reinterpret_cast<char*>(coarse_.data()),
+                  coarse_size * sizeof(double))) {
+    ROS_ERROR("TiledGrid: Truncated coarse level in %s.", file_name.c_str());
+    return false;
+  }
+
+  tiles_offset_ = file_.tellg();
+
+  loader_ = std::thread(&TiledGrid::LoaderLoop, this);
+  return true;
+}
+
+// Read all channels at the cell with the given coordinates, without
+// blocking. Returns false if the tile was not resident, in which case the
+// coarse bounds were read and the tile requested.
+bool TiledGrid::Lookup(const size_t* cell, double* lower,
+                       double* upper) const {
+  size_t offset;
+  const size_t tile = TileIndex(cell, &offset);
+
+  std::unique_lock<std::mutex> lock(cache_mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    const auto iter = tiles_.find(tile);
+    if (iter != tiles_.end()) {
+      // Mark as most recently used.
+      lru_.splice(lru_.begin(), lru_, iter->second.lru_position);
+
+      const double* data = iter->second.data.data() + offset * num_channels_;
+      std::copy(data, data + num_channels_, lower);
+      std::copy(data, data + num_channels_, upper);
+      num_hits_++;
+      return true;
+    }
+
+    Request(tile);
+  }
+
+  CoarseLookup(cell, lower, upper);
+  num_misses_++;
+  return false;
+}
+
+// Request the tile containing the given cell, if it is not resident.
+// Never blocks.
+void TiledGrid::Prefetch(const size_t* cell) const {
+  size_t offset;
+  const size_t tile = TileIndex(cell, &offset);
+
+  std::unique_lock<std::mutex> lock(cache_mutex_, std::try_to_lock);
+  if (lock.owns_lock() && !tiles_.count(tile)) Request(tile);
+}
+
+// Index of the tile containing the given cell, and the offset (in cells)
+// of the cell within that tile.
+size_t TiledGrid::TileIndex(const size_t* cell, size_t* offset) const {
+  size_t tile = 0;
+  *offset = 0;
+  for (size_t ii = 0; ii < num_cells_.size(); ii++) {
+    tile = tile * num_tiles_[ii] + cell[ii] / tile_cells_[ii];
+    *offset = *offset * tile_cells_[ii] + cell[ii] % tile_cells_[ii];
+  }
+
+  return tile;
+}
+
+// Read the coarse bounds at the given cell.
+void TiledGrid::CoarseLookup(const size_t* cell, double* lower,
+                             double* upper) const {
+  size_t idx = 0;
+  for (size_t ii = 0; ii < num_cells_.size(); ii++)
+    idx = idx * num_coarse_cells_[ii] + cell[ii] / coarse_factor_;
+
+  const double* data = coarse_.data() + 2 * idx * num_channels_;
+  std::copy(data, data + num_channels_, lower);
+  std::copy(data + num_channels_, data + 2 * num_channels_, upper);
+}
+
+// Queue a tile for loading. Must hold 'cache_mutex_'.
+void TiledGrid::Request(size_t tile) const {
+  if (!requested_.insert(tile).second) return;
+
+  requests_.push_back(tile);
+  if (requests_.size() > kRequestsPerTile * cache_size_) {
+    requested_.erase(requests_.front());
+    requests_.pop_front();
+  }
+
+  request_cv_.notify_one();
+}
+
+// Loader thread loop. Serves the newest request first, since that is
+// closest to where the state is now.
+void TiledGrid::LoaderLoop() {
+  const size_t tile_size = cells_per_tile_ * num_channels_;
+
+  std::unique_lock<std::mutex> lock(cache_mutex_);
+  while (true) {
+    request_cv_.wait(lock, [this]() { return stop_ || !requests_.empty(); });
+    if (stop_) break;
+
+    const size_t tile = requests_.back();
+    requests_.pop_back();
+
+    // Read from disk without holding the lock.
+    lock.unlock();
+    std::vector<double> data(tile_size);
+    file_.seekg(tiles_offset_ + static_cast<std::streamoff>(
+                                    tile * tile_size * sizeof(double)));
+    const bool success = static_cast<bool>(file_.read(
+        reinterpret_cast<char*>(data.data()), tile_size * sizeof(double)));
+    lock.lock();
+
+    requested_.erase(tile);
+    if (!success) {
+      ROS_ERROR_THROTTLE(1.0, "TiledGrid: Could not read tile %zu.", tile);
+      file_.clear();
+      continue;
+    }
+
+    // Insert, and evict the least recently used tile if full.
+    if (tiles_.count(tile)) continue;
+
+    lru_.push_front(tile);
+    tiles_[tile] = {std::move(data), lru_.begin()};
+    if (tiles_.size() > cache_size_) {
+      tiles_.erase(lru_.back());
+      lru_.pop_back();
+    }
+  }
+}
+
+}  //\namespace fastrack
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Lock-free cache of whole-cell collision check results, tagged with the
+// environment version they were computed against.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/validity_cache.h>
+
+#include <cmath>
+#include <limits>
+
+namespace fastrack {
+
+namespace {
+// Slot kinds.
+static constexpr uint32_t kEmpty = 0;
+static constexpr uint32_t kValid = 1;
+static constexpr uint32_t kMixed = 2;
+
+// Finalizer from splitmix64.
+uint64_t Mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+}  //\namespace
+
+ValidityCache::ValidityCache(double resolution, size_t num_slots)
+  : resolution_(resolution),
+    num_slots_([num_slots]() {
+      size_t n = 1;
+      while (n < num_slots) n <<= 1;
+      return n;
+    }()),
+    slots_(new Slot[num_slots_]),
+    num_queries_(0),
+    num_hits_(0) {
+  for (size_t ii = 0; ii < num_slots_; ii++)
+    slots_[ii].sequence.store(0, std::memory_order_relaxed);
+
+  Clear();
+}
+
+// Look up the cell containing the given position for the given environment
+// version. Returns true on a hit and sets 'cell_valid'.
+bool ValidityCache::Lookup(const Vector3d& p, unsigned int version,
+                           bool* cell_valid) const {
+  num_queries_.fetch_add(1, std::memory_order_relaxed);
+
+  Cell cell;
+  if (!CellOf(p, &cell))
+    return false;
+
+  // Read a consistent copy of the slot.
+  const Slot& slot = SlotOf(cell);
+  const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence & 1)
+    return false;
+
+  Cell stored;
+  for (size_t ii = 0; ii < 3; ii++)
+    stored.index[ii] = slot.index[ii].load(std::memory_order_relaxed);
+  const uint32_t stored_version = slot.version.load(std::memory_order_relaxed);
+  const uint32_t kind = slot.kind.load(std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+    return false;
+
+  // Only the exact cell and version count.
+  if (kind == kEmpty || stored_version != version)
+    return false;
+  for (size_t ii = 0; ii < 3; ii++) {
+    if (stored.index[ii] != cell.index[ii])
+      return false;
+  }
+
+  num_hits_.fetch_add(1, std::memory_order_relaxed);
+  *cell_valid = (kind == kValid);
+  return true;
+}
+
+// Store the result for the cell containing the given position.
+void ValidityCache::Insert(const Vector3d& p, unsigned int version,
+                           bool cell_valid) {
+  Cell cell;
+  if (!CellOf(p, &cell))
+    return;
+
+  Write(SlotOf(cell), cell, version, cell_valid ? kValid : kMixed);
+}
+
+// Forget all results.
+void ValidityCache::Clear() {
+  const Cell cell = {{0, 0, 0}};
+  for (size_t ii = 0; ii < num_slots_; ii++)
+    Write(slots_[ii], cell, 0, kEmpty);
+}
+
+// Center of the cell containing the given position.
+Vector3d ValidityCache::CellCenter(const Vector3d& p) const {
+  Vector3d center;
+  for (size_t ii = 0; ii < 3; ii++)
+    center(ii) = (std::floor(p(ii) / resolution_) + 0.5) * resolution_;
+
+  return center;
+}
+
+// Compute the cell containing a position.
+bool ValidityCache::CellOf(const Vector3d& p, Cell* cell) const {
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double index = std::floor(p(ii) / resolution_);
+    if (!(index >= std::numeric_limits<int32_t>::min() &&
+          index <= std::numeric_limits<int32_t>::max()))
+      return false;
+
+    cell->index[ii] = static_cast<int32_t>(index);
+  }
+
+  return true;
+}
+
+// Slot a cell hashes to.
+ValidityCache::Slot& ValidityCache::SlotOf(const Cell& cell) const {
+  uint64_t hash = 0;
+  for (size_t ii = 0; ii < 3; ii++)
+    hash = Mix(hash ^ static_cast<uint32_t>(cell.index[ii]));
+
+  return slots_[hash & (num_slots_ - 1)];
+}
+
+// Overwrite a slot unless another writer holds it.
+void ValidityCache::Write(Slot& slot, const Cell& cell, uint32_t version,
+                          uint32_t kind) {
+  uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  if ((sequence & 1) ||
+      !slot.sequence.compare_exchange_strong(sequence, sequence + 1,
+                                             std::memory_order_relaxed))
+    return;
+
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t ii = 0; ii < 3; ii++)
+    slot.index[ii].store(cell.index[ii], std::memory_order_relaxed);
+  slot.version.store(version, std::memory_order_relaxed);
+  slot.kind.store(kind, std::memory_order_relaxed);
+
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace fastrack
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ClosedLoopSimulator.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/control/quadrotor_control.h>
+#include <fastrack/simulation/closed_loop_simulator.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/value/analytical_kinematic_box_quadrotor_decoupled_6d.h>
+
+#include <gtest/gtest.h>
+
+using namespace fastrack;
+using control::QuadrotorControl;
+using simulation::ClosedLoopSimulationReport;
+using simulation::ClosedLoopSimulator;
+using simulation::ClosedLoopSimulatorParams;
+using state::PositionVelocity;
+using trajectory::Trajectory;
+using value::AnalyticalKinematicBoxQuadrotorDecoupled6D;
+
+namespace {
+// Same parameters as the analytical tracker demo.
+static const QuadrotorControl kTrackerLower(-0.1, -0.1, 0.0, 7.81);
+static const QuadrotorControl kTrackerUpper(0.1, 0.1, 0.0, 11.81);
+static const Vector3d kMaxPlannerSpeed = Vector3d::Constant(0.5);
+static const Vector3d kVelocityDisturbance = Vector3d::Constant(0.1);
+static const Vector3d kAccelerationDisturbance = Vector3d::Constant(0.01);
+static const Vector3d kVelocityExpansion = Vector3d::Constant(0.1);
+
+// Reference trajectory timing.
+static constexpr double kSegmentDuration = 1.0;
+static constexpr size_t kNumSegments = 5;
+static constexpr double kReferenceTimeStep = 0.05;
+static constexpr double kReferenceDuration = kSegmentDuration * kNumSegments;
+
+// Number of rollouts and references.
+static constexpr size_t kNumRollouts = 64;
+static constexpr size_t kNumReferences = 8;
+
+// Piecewise constant velocity references at up to the maximum planner speed,
+// with velocity resampled every segment_duration seconds.
+std::vector<Trajectory<PositionVelocity>> RandomReferences(
+    double segment_duration) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+
+  std::vector<Trajectory<PositionVelocity>> references;
+  for (size_t ii = 0; ii < kNumReferences; ii++) {
+    std::vector<PositionVelocity> states;
+    std::vector<double> times;
+
+    Vector3d position = Vector3d::Zero();
+    double t = 0.0;
+    Vector3d velocity = Vector3d::Zero();
+    for (double s = 0.0; t < kReferenceDuration; s += kReferenceTimeStep) {
+      if (times.empty() || s >= segment_duration) {
+        velocity = Vector3d(unif(rng) * kMaxPlannerSpeed(0),
+                            unif(rng) * kMaxPlannerSpeed(1),
+                            unif(rng) * kMaxPlannerSpeed(2));
+        s = 0.0;
+      }
+
+      states.emplace_back(position, velocity);
+      times.push_back(t);
+      position += kReferenceTimeStep * velocity;
+      t += kReferenceTimeStep;
+    }
+
+    references.emplace_back(states, times);
+  }
+
+  return references;
+}
+
+// Simulation parameters with disturbances at the design bounds.
+ClosedLoopSimulatorParams DesignParams() {
+  ClosedLoopSimulatorParams params;
+  params.num_rollouts = kNumRollouts;
+  params.velocity_disturbance = kVelocityDisturbance;
+  params.acceleration_disturbance = kAccelerationDisturbance;
+  return params;
+}
+
+}  // namespace
+
+class ClosedLoopSimulatorTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    ASSERT_TRUE(value_.InitializeFromParameters(
+        kTrackerLower, kTrackerUpper, kMaxPlannerSpeed, kVelocityDisturbance,
+        kAccelerationDisturbance, kVelocityExpansion));
+    straight_references_ = RandomReferences(kReferenceDuration);
+    references_ = RandomReferences(kSegmentDuration);
+  }
+
+  AnalyticalKinematicBoxQuadrotorDecoupled6D value_;
+  std::vector<Trajectory<PositionVelocity>> straight_references_;
+  std::vector<Trajectory<PositionVelocity>> references_;
+};
+
+TEST_F(ClosedLoopSimulatorTest, TestStraightLineWithinDesignDisturbance) {
+  ClosedLoopSimulator<AnalyticalKinematicBoxQuadrotorDecoupled6D,
+                      PositionVelocity>
+      simulator(value_);
+  ASSERT_TRUE(simulator.InitializeFromParameters(DesignParams()));
+
+  const ClosedLoopSimulationReport report =
+      simulator.Simulate(straight_references_);
+  EXPECT_EQ(report.num_rollouts, kNumRollouts);
+  EXPECT_GT(report.num_steps, 0);
+  EXPECT_EQ(report.num_violating_rollouts, 0);
+  EXPECT_EQ(report.num_violating_steps, 0);
+  EXPECT_GT(report.ControlsPerSecond(), 0.0);
+}
+
+TEST_F(ClosedLoopSimulatorTest, TestDetectsViolations) {
+  ClosedLoopSimulator<AnalyticalKinematicBoxQuadrotorDecoupled6D,
+                      PositionVelocity>
+      simulator(value_);
+
+  // Disturb well beyond what the bound was computed for.
+  ClosedLoopSimulatorParams params = DesignParams();
+  params.velocity_disturbance = Vector3d::Constant(2.0);
+  params.acceleration_disturbance = Vector3d::Constant(2.0);
+  ASSERT_TRUE(simulator.InitializeFromParameters(params));
+
+  const ClosedLoopSimulationReport report = simulator.Simulate(references_);
+  EXPECT_GT(report.num_violating_rollouts, 0);
+  EXPECT_GT(report.ViolationRate(), 0.0);
+}
+
+TEST_F(ClosedLoopSimulatorTest, TestDeterministicAcrossThreads) {
+  ClosedLoopSimulator<AnalyticalKinematicBoxQuadrotorDecoupled6D,
+                      PositionVelocity>
+      simulator(value_);
+
+  ClosedLoopSimulatorParams params = DesignParams();
+  params.acceleration_disturbance = Vector3d::Constant(1.0);
+  params.num_threads = 1;
+  ASSERT_TRUE(simulator.InitializeFromParameters(params));
+  const ClosedLoopSimulationReport serial = simulator.Simulate(references_);
+
+  params.num_threads = 4;
+  ASSERT_TRUE(simulator.InitializeFromParameters(params));
+  const ClosedLoopSimulationReport parallel = simulator.Simulate(references_);
+
+  EXPECT_EQ(serial.num_steps, parallel.num_steps);
+  EXPECT_EQ(serial.num_violating_steps, parallel.num_violating_steps);
+  EXPECT_EQ(serial.num_violating_rollouts, parallel.num_violating_rollouts);
+  EXPECT_TRUE(serial.max_abs_error.isApprox(parallel.max_abs_error));
+}
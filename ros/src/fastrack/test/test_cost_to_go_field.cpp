@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for CostToGoField.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/cost_to_go_field.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+// A flat 10 x 10 x 1 grid with unit cells.
+static const Vector3d kLower(0.0, 0.0, 0.0);
+static const Vector3d kUpper(10.0, 10.0, 1.0);
+static constexpr double kResolution = 1.0;
+
+// Center of the given cell.
+Vector3d Cell(size_t ix, size_t iy) { return Vector3d(ix + 0.5, iy + 0.5, 0.5); }
+
+}  // namespace
+
+TEST(CostToGoField, TestOpenSpace) {
+  fastrack::CostToGoField field(kLower, kUpper, kResolution);
+  EXPECT_FALSE(field.HasGoal());
+  EXPECT_FALSE(field.SetGoal(Vector3d(-1.0, 0.5, 0.5)));
+  ASSERT_TRUE(field.SetGoal(Cell(0, 0)));
+  EXPECT_TRUE(field.HasGoal());
+
+  // Diagonal moves first, then straight.
+  EXPECT_NEAR(field.Value(Cell(0, 0)), 0.0, 1e-12);
+  EXPECT_NEAR(field.Value(Cell(3, 0)), 3.0, 1e-12);
+  EXPECT_NEAR(field.Value(Cell(5, 2)), 3.0 + 2.0 * std::sqrt(2.0), 1e-12);
+  EXPECT_EQ(field.Value(Vector3d(11.0, 0.5, 0.5)), fastrack::constants::kInfinity);
+}
+
+TEST(CostToGoField, TestWall) {
+  fastrack::CostToGoField field(kLower, kUpper, kResolution);
+  ASSERT_TRUE(field.SetGoal(Cell(0, 0)));
+
+  // Wall along x = 5, except for a gap at the top.
+  for (size_t iy = 0; iy < 9; iy++) field.SetBlocked(Cell(5, iy), true);
+  field.Update();
+
+  EXPECT_EQ(field.Value(Cell(5, 0)), fastrack::constants::kInfinity);
+  EXPECT_GT(field.Value(Cell(6, 0)), 9.0);
+
+  // Close the gap, and the far side is cut off.
+  field.SetBlocked(Cell(5, 9), true);
+  field.Update();
+  EXPECT_EQ(field.Value(Cell(6, 0)), fastrack::constants::kInfinity);
+  EXPECT_NEAR(field.Value(Cell(4, 0)), 4.0, 1e-12);
+
+  // Tear down the wall, and distances go back to open space.
+  for (size_t iy = 0; iy < 10; iy++) field.SetBlocked(Cell(5, iy), false);
+  field.Update();
+  EXPECT_NEAR(field.Value(Cell(6, 0)), 6.0, 1e-12);
+}
+
+TEST(CostToGoField, TestIncrementalMatchesBatch) {
+  std::default_random_engine rng(0);
+  std::bernoulli_distribution coin(0.3);
+
+  fastrack::CostToGoField incremental(kLower, kUpper, kResolution);
+  ASSERT_TRUE(incremental.SetGoal(Cell(2, 3)));
+
+  for (size_t round = 0; round < 10; round++) {
+    // Randomly flip cells, never the goal.
+    std::vector<bool> blocked(100);
+    for (size_t ii = 0; ii < 100; ii++)
+      blocked[ii] = (ii != 2 + 10 * 3) && coin(rng);
+
+    const auto is_free = [&blocked](const Vector3d& p) {
+      return !blocked[static_cast<size_t>(p.x()) +
+                      10 * static_cast<size_t>(p.y())];
+    };
+    incremental.Classify(is_free);
+
+    // Solve from scratch on the same occupancy.
+    fastrack::CostToGoField batch(kLower, kUpper, kResolution);
+    batch.Classify(is_free);
+    ASSERT_TRUE(batch.SetGoal(Cell(2, 3)));
+
+    for (size_t ix = 0; ix < 10; ix++) {
+      for (size_t iy = 0; iy < 10; iy++) {
+        const double expected = batch.Value(Cell(ix, iy));
+        if (expected == fastrack::constants::kInfinity)
+          EXPECT_EQ(incremental.Value(Cell(ix, iy)), expected);
+        else
+          EXPECT_NEAR(incremental.Value(Cell(ix, iy)), expected, 1e-9);
+      }
+    }
+  }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for double integrator steering.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/double_integrator.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Bounds and number of random trials to use for tests.
+static constexpr double kMaxAcceleration = 2.0;
+static constexpr double kMinVelocity = -1.5;
+static constexpr double kMaxVelocity = 1.0;
+static constexpr size_t kNumTrials = 1000;
+static constexpr double kTolerance = 1e-6;
+
+// Check that the profile ends at the given state and respects the bounds.
+void CheckProfile(const fastrack::DoubleIntegratorProfile& profile, double x1,
+                  double v1) {
+  double x, v;
+  profile.Evaluate(profile.Duration(), &x, &v);
+  EXPECT_NEAR(x, x1, kTolerance);
+  EXPECT_NEAR(v, v1, kTolerance);
+
+  EXPECT_LE(std::abs(profile.a1), kMaxAcceleration + kTolerance);
+  EXPECT_LE(std::abs(profile.a3), kMaxAcceleration + kTolerance);
+  EXPECT_GE(profile.v_cruise, kMinVelocity - kTolerance);
+  EXPECT_LE(profile.v_cruise, kMaxVelocity + kTolerance);
+}
+
+}  // namespace
+
+TEST(DoubleIntegrator, TestRestToRest) {
+  fastrack::DoubleIntegratorProfile profile;
+
+  // Bang-bang: accelerate for 1 s, decelerate for 1 s.
+  EXPECT_TRUE(fastrack::MinimumTimeProfile(0.0, 0.0, 1.0, 0.0, -10.0, 10.0,
+                                           1.0, &profile));
+  EXPECT_NEAR(profile.Duration(), 2.0, kTolerance);
+  EXPECT_NEAR(profile.t2, 0.0, kTolerance);
+
+  // Velocity limited: accelerate for 0.5 s, coast for 1.5 s, decelerate.
+  EXPECT_TRUE(fastrack::MinimumTimeProfile(0.0, 0.0, 1.0, 0.0, -0.5, 0.5,
+                                           1.0, &profile));
+  EXPECT_NEAR(profile.Duration(), 2.5, kTolerance);
+  EXPECT_NEAR(profile.t2, 1.5, kTolerance);
+
+  // Boundary velocities must be within bounds.
+  EXPECT_FALSE(fastrack::MinimumTimeProfile(0.0, 1.0, 1.0, 0.0, -0.5, 0.5,
+                                            1.0, &profile));
+}
+
+TEST(DoubleIntegrator, TestMinimumTime) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> position(-5.0, 5.0);
+  std::uniform_real_distribution<double> velocity(kMinVelocity, kMaxVelocity);
+
+  for (size_t ii = 0; ii < kNumTrials; ii++) {
+    const double x0 = position(rng);
+    const double v0 = velocity(rng);
+    const double x1 = position(rng);
+    const double v1 = velocity(rng);
+
+    fastrack::DoubleIntegratorProfile profile;
+    ASSERT_TRUE(fastrack::MinimumTimeProfile(x0, v0, x1, v1, kMinVelocity,
+                                             kMaxVelocity, kMaxAcceleration,
+                                             &profile));
+    CheckProfile(profile, x1, v1);
+
+    // Nothing should be faster, and the minimum time itself is attainable.
+    fastrack::DoubleIntegratorProfile fixed;
+    EXPECT_FALSE(fastrack::FixedTimeProfile(
+        x0, v0, x1, v1, kMinVelocity, kMaxVelocity, kMaxAcceleration,
+        0.9 * profile.Duration(), &fixed));
+    ASSERT_TRUE(fastrack::FixedTimeProfile(
+        x0, v0, x1, v1, kMinVelocity, kMaxVelocity, kMaxAcceleration,
+        profile.Duration(), &fixed));
+    EXPECT_NEAR(fixed.Duration(), profile.Duration(), kTolerance);
+    CheckProfile(fixed, x1, v1);
+  }
+}
+
+TEST(DoubleIntegrator, TestFixedTime) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> position(-5.0, 5.0);
+  std::uniform_real_distribution<double> stretch(1.0, 3.0);
+
+  // Starting and ending at rest, every duration above the minimum is
+  // attainable.
+  for (size_t ii = 0; ii < kNumTrials; ii++) {
+    const double x0 = position(rng);
+    const double x1 = position(rng);
+
+    fastrack::DoubleIntegratorProfile profile;
+    ASSERT_TRUE(fastrack::MinimumTimeProfile(x0, 0.0, x1, 0.0, kMinVelocity,
+                                             kMaxVelocity, kMaxAcceleration,
+                                             &profile));
+
+    const double duration = stretch(rng) * profile.Duration();
+    ASSERT_TRUE(fastrack::FixedTimeProfile(x0, 0.0, x1, 0.0, kMinVelocity,
+                                           kMaxVelocity, kMaxAcceleration,
+                                           duration, &profile));
+    EXPECT_NEAR(profile.Duration(), duration, kTolerance);
+    CheckProfile(profile, x1, 0.0);
+  }
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for environment snapshots.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/box.h>
+#include <fastrack/environment/balls_in_box.h>
+#include <fastrack/utils/types.h>
+#include <fastrack_msgs/SensedSpheres.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using fastrack::bound::Box;
+using fastrack::environment::BallsInBox;
+
+namespace {
+// Environment extent and obstacle radius.
+static constexpr double kEnvironmentSize = 10.0;
+static constexpr double kRadius = 0.5;
+
+// Number of concurrent updates.
+static constexpr size_t kNumUpdates = 1000;
+
+// BallsInBox which can be updated directly, the same way a sensor callback
+// would be incorporated.
+class TestBallsInBox : public BallsInBox {
+ public:
+  explicit TestBallsInBox() : BallsInBox() {
+    name_ = "TestBallsInBox";
+    lower_ = Vector3d::Zero();
+    upper_ = Vector3d::Constant(kEnvironmentSize);
+    initialized_ = true;
+  }
+
+  // Count copies, i.e. snapshots taken.
+  TestBallsInBox(const TestBallsInBox& other) : BallsInBox(other) {
+    num_copies_++;
+  }
+
+  static std::atomic<size_t> num_copies_;
+
+  void AddObstacle(const Vector3d& p) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    obstacles_.Add(p, kRadius);
+    ModelChanged();
+  }
+
+  // Incorporate a sensor message as if it had arrived on the sensor topic.
+  void Sense(const fastrack_msgs::SensedSpheres::ConstPtr& msg) {
+    RecordAndSensorCallback(msg);
+  }
+
+  size_t NumObstacles() const { return obstacles_.Size(); }
+
+  // Hold the update lock, as if a sensor update were in progress.
+  std::unique_lock<std::mutex> LockUpdates() {
+    return std::unique_lock<std::mutex>(update_mutex_);
+  }
+};  //\class TestBallsInBox
+
+std::atomic<size_t> TestBallsInBox::num_copies_(0);
+
+Box MakeBox(double half_width) {
+  Box box;
+  box.x = half_width;
+  box.y = half_width;
+  box.z = half_width;
+  return box;
+}
+
+}  // namespace
+
+TEST(EnvironmentSnapshot, TestSnapshotIsImmutable) {
+  TestBallsInBox env;
+  const Box bound = MakeBox(0.1);
+  const Vector3d p = Vector3d::Constant(0.5 * kEnvironmentSize);
+
+  const auto before = env.Snapshot<TestBallsInBox>();
+  EXPECT_TRUE(before->IsValid(p, bound));
+
+  // Updating the live environment leaves the snapshot alone.
+  env.AddObstacle(p);
+  EXPECT_FALSE(env.IsValid(p, bound));
+  EXPECT_TRUE(before->IsValid(p, bound));
+  EXPECT_EQ(before->Version() + 1, env.Version());
+
+  // New snapshots see the update.
+  const auto after = env.Snapshot<TestBallsInBox>();
+  EXPECT_FALSE(after->IsValid(p, bound));
+  EXPECT_EQ(after->Version(), env.Version());
+}
+
+TEST(EnvironmentSnapshot, TestSnapshotsAreShared) {
+  TestBallsInBox env;
+  const auto first = env.Snapshot<TestBallsInBox>();
+  EXPECT_EQ(first, env.Snapshot<TestBallsInBox>());
+
+  env.AddObstacle(Vector3d::Zero());
+  EXPECT_NE(first, env.Snapshot<TestBallsInBox>());
+}
+
+TEST(EnvironmentSnapshot, TestUpdatesAreCoalesced) {
+  TestBallsInBox env;
+  const auto first = env.Snapshot<TestBallsInBox>();
+  const size_t num_copies = TestBallsInBox::num_copies_;
+
+  // Updates alone do not copy the model.
+  for (size_t ii = 0; ii < 10; ii++)
+    env.AddObstacle(Vector3d::Constant(static_cast<double>(ii)));
+  EXPECT_EQ(TestBallsInBox::num_copies_, num_copies);
+
+  // The next request copies it once.
+  const auto second = env.Snapshot<TestBallsInBox>();
+  EXPECT_EQ(second, env.Snapshot<TestBallsInBox>());
+  EXPECT_EQ(second->Version(), env.Version());
+  EXPECT_EQ(TestBallsInBox::num_copies_, num_copies + 1);
+}
+
+TEST(EnvironmentSnapshot, TestSnapshotsDoNotWaitForUpdates) {
+  TestBallsInBox env;
+  const auto first = env.Snapshot<TestBallsInBox>();
+
+  // Readers get the previous snapshot while an update is in progress.
+  std::unique_lock<std::mutex> lock = env.LockUpdates();
+  auto second = std::async(std::launch::async, [&env]() {
+    return env.Snapshot<TestBallsInBox>();
+  });
+  EXPECT_EQ(second.wait_for(std::chrono::seconds(1)),
+            std::future_status::ready);
+  EXPECT_EQ(first, second.get());
+  lock.unlock();
+
+  // Even if the model has changed since.
+  env.AddObstacle(Vector3d::Zero());
+  lock.lock();
+  auto third = std::async(std::launch::async, [&env]() {
+    return env.Snapshot<TestBallsInBox>();
+  });
+  EXPECT_EQ(third.wait_for(std::chrono::seconds(1)),
+            std::future_status::ready);
+  EXPECT_EQ(first, third.get());
+  lock.unlock();
+
+  EXPECT_NE(first, env.Snapshot<TestBallsInBox>());
+}
+
+TEST(EnvironmentSnapshot, TestVersionOnlyChangesWithModel) {
+  TestBallsInBox env;
+  const auto first = env.Snapshot<TestBallsInBox>();
+
+  fastrack_msgs::SensedSpheres::Ptr msg(new fastrack_msgs::SensedSpheres);
+  geometry_msgs::Vector3 center;
+  center.x = center.y = center.z = 0.5 * kEnvironmentSize;
+  msg->centers.push_back(center);
+  msg->radii.push_back(kRadius);
+
+  // A new obstacle bumps the version.
+  env.Sense(msg);
+  EXPECT_EQ(env.Version(), first->Version() + 1);
+  const auto second = env.Snapshot<TestBallsInBox>();
+  EXPECT_NE(first, second);
+
+  // Sensing it again does not, so snapshots stay shared.
+  env.Sense(msg);
+  EXPECT_EQ(env.Version(), second->Version());
+  EXPECT_EQ(second, env.Snapshot<TestBallsInBox>());
+}
+
+TEST(EnvironmentSnapshot, TestConcurrentUpdates) {
+  TestBallsInBox env;
+
+  // Add obstacles on one thread while taking snapshots on this one. Every
+  // snapshot must be internally consistent.
+  std::atomic<bool> done(false);
+  std::thread updater([&env, &done]() {
+    for (size_t ii = 0; ii < kNumUpdates; ii++)
+      env.AddObstacle(Vector3d::Constant(0.01 * (ii % 1000)));
+    done = true;
+  });
+
+  size_t last_size = 0;
+  while (!done) {
+    const auto snapshot = env.Snapshot<TestBallsInBox>();
+    EXPECT_EQ(snapshot->NumObstacles(), snapshot->Version());
+    EXPECT_GE(snapshot->NumObstacles(), last_size);
+    last_size = snapshot->NumObstacles();
+  }
+
+  updater.join();
+  EXPECT_EQ(env.Snapshot<TestBallsInBox>()->NumObstacles(), kNumUpdates);
+}
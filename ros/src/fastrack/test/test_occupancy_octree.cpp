@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for OccupancyOctree.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/box.h>
+#include <fastrack/environment/occupancy_octree.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+using fastrack::bound::Box;
+using fastrack::environment::OccupancyOctree;
+
+namespace {
+// Environment extent and leaf resolution.
+static constexpr double kEnvironmentSize = 10.0;
+static constexpr double kResolution = 0.1;
+
+// Sensor FOV and obstacle.
+static const Vector3d kSensorPosition(5.0, 5.0, 5.0);
+static constexpr double kSensorRadius = 3.0;
+static const Vector3d kObstaclePosition(6.0, 5.0, 5.0);
+static constexpr double kObstacleRadius = 0.5;
+
+// Number of random queries.
+static constexpr size_t kNumQueries = 1000;
+
+Box MakeBox(double half_width) {
+  Box box;
+  box.x = half_width;
+  box.y = half_width;
+  box.z = half_width;
+  return box;
+}
+
+}  // namespace
+
+TEST(OccupancyOctree, TestInitiallyUnknown) {
+  const OccupancyOctree octree(Vector3d::Zero(),
+                               Vector3d::Constant(kEnvironmentSize),
+                               kResolution);
+  EXPECT_EQ(octree.NumNodes(), 1u);
+  EXPECT_EQ(octree.Query(kSensorPosition), OccupancyOctree::UNKNOWN);
+  EXPECT_EQ(octree.Query(Vector3d::Constant(-1.0)), OccupancyOctree::OCCUPIED);
+}
+
+TEST(OccupancyOctree, TestPointQueries) {
+  OccupancyOctree octree(Vector3d::Zero(), Vector3d::Constant(kEnvironmentSize),
+                         kResolution);
+  EXPECT_TRUE(octree.InsertFreeSphere(kSensorPosition, kSensorRadius));
+  EXPECT_TRUE(octree.InsertOccupiedSphere(kObstaclePosition, kObstacleRadius));
+
+  // Inserting the same obstacle again changes nothing.
+  EXPECT_FALSE(octree.InsertOccupiedSphere(kObstaclePosition, kObstacleRadius));
+
+  // Free space never overrides occupied space.
+  EXPECT_FALSE(octree.InsertFreeSphere(kObstaclePosition, kObstacleRadius));
+
+  // Points inside the obstacle are occupied. Points far enough from the
+  // obstacle and well inside the sensor FOV are free, and points outside the
+  // sensor FOV are unknown.
+  const double leaf_diagonal = std::sqrt(3.0) * kResolution;
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(0.0, kEnvironmentSize);
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    const Vector3d p(unif(rng), unif(rng), unif(rng));
+    const double obstacle_distance = (p - kObstaclePosition).norm();
+    const double sensor_distance = (p - kSensorPosition).norm();
+
+    if (obstacle_distance < kObstacleRadius) {
+      EXPECT_EQ(octree.Query(p), OccupancyOctree::OCCUPIED);
+    } else if (obstacle_distance > kObstacleRadius + leaf_diagonal &&
+               sensor_distance < kSensorRadius - leaf_diagonal) {
+      EXPECT_EQ(octree.Query(p), OccupancyOctree::FREE);
+    } else if (sensor_distance > kSensorRadius) {
+      EXPECT_EQ(octree.Query(p), OccupancyOctree::UNKNOWN);
+    }
+  }
+}
+
+TEST(OccupancyOctree, TestBoundQueries) {
+  OccupancyOctree octree(Vector3d::Zero(), Vector3d::Constant(kEnvironmentSize),
+                         kResolution);
+  octree.InsertFreeSphere(kSensorPosition, kSensorRadius);
+  octree.InsertOccupiedSphere(kObstaclePosition, kObstacleRadius);
+
+  const Box box = MakeBox(0.2);
+
+  // Bound touching the obstacle.
+  const Vector3d near_obstacle =
+      kObstaclePosition - Vector3d(kObstacleRadius + 0.1, 0.0, 0.0);
+  EXPECT_EQ(octree.Query(near_obstacle), OccupancyOctree::FREE);
+  EXPECT_EQ(octree.Query(near_obstacle, box), OccupancyOctree::OCCUPIED);
+
+  // Bound in free space.
+  const Vector3d free = kSensorPosition - Vector3d(1.0, 0.0, 0.0);
+  EXPECT_EQ(octree.Query(free, box), OccupancyOctree::FREE);
+
+  // Bound straddling the edge of the sensor FOV.
+  const Vector3d edge = kSensorPosition - Vector3d(kSensorRadius, 0.0, 0.0);
+  EXPECT_EQ(octree.Query(edge, box), OccupancyOctree::UNKNOWN);
+
+  // Depth-limited queries are conservative. The root contains occupied
+  // space, so a query which may not descend at all is occupied.
+  EXPECT_EQ(octree.Query(free, box, 0), OccupancyOctree::OCCUPIED);
+}
+
+TEST(OccupancyOctree, TestMemoryScalesWithSurface) {
+  // Halving the resolution should roughly quadruple the number of nodes for
+  // a sphere, rather than multiply it by eight.
+  OccupancyOctree coarse(Vector3d::Zero(), Vector3d::Constant(kEnvironmentSize),
+                         2.0 * kResolution);
+  coarse.InsertFreeSphere(kSensorPosition, kSensorRadius);
+
+  OccupancyOctree fine(Vector3d::Zero(), Vector3d::Constant(kEnvironmentSize),
+                       kResolution);
+  fine.InsertFreeSphere(kSensorPosition, kSensorRadius);
+
+  const double ratio = static_cast<double>(fine.NumNodes()) /
+                       static_cast<double>(coarse.NumNodes());
+  EXPECT_GT(ratio, 2.0);
+  EXPECT_LT(ratio, 6.0);
+
+  // Covering the whole octree collapses it back to a single leaf.
+  fine.InsertOccupiedSphere(kSensorPosition, 2.0 * kEnvironmentSize);
+  EXPECT_EQ(fine.NumNodes(), 1u);
+  EXPECT_EQ(fine.Query(kSensorPosition), OccupancyOctree::OCCUPIED);
+}
+
+TEST(OccupancyOctree, TestInsertRay) {
+  OccupancyOctree octree(Vector3d::Zero(), Vector3d::Constant(kEnvironmentSize),
+                         kResolution);
+  const Vector3d origin(1.05, 5.05, 5.05);
+  const Vector3d endpoint(6.05, 5.05, 5.05);
+
+  EXPECT_TRUE(octree.InsertRay(origin, endpoint, true));
+  EXPECT_EQ(octree.Query(Vector3d(3.05, 5.05, 5.05)), OccupancyOctree::FREE);
+  EXPECT_EQ(octree.Query(endpoint), OccupancyOctree::OCCUPIED);
+  EXPECT_EQ(octree.Query(Vector3d(3.05, 6.05, 5.05)),
+            OccupancyOctree::UNKNOWN);
+
+  // Clearing again changes nothing, and misses do not mark their endpoint.
+  EXPECT_FALSE(octree.InsertRay(origin, endpoint, true));
+  EXPECT_TRUE(octree.InsertRay(origin, Vector3d(1.05, 8.05, 5.05), false));
+  EXPECT_EQ(octree.Query(Vector3d(1.05, 8.05, 5.05)), OccupancyOctree::FREE);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for PlannerManager goal checks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/planning/planner_manager.h>
+#include <fastrack/state/planar_dubins_3d.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+
+using namespace fastrack;
+using planning::PlannerManager;
+using state::PlanarDubins3D;
+using state::PositionVelocity;
+using trajectory::Trajectory;
+
+namespace {
+// Goal tolerance (m).
+static constexpr double kTolerance = 0.1;
+
+// Trajectory holding at the given state.
+template <typename S>
+Trajectory<S> EndingAt(const S& last) {
+  return Trajectory<S>(std::vector<S>(2, last), {0.0, 1.0});
+}
+
+// Goal message with the given values.
+fastrack_msgs::State Goal(const std::vector<double>& x) {
+  fastrack_msgs::State goal;
+  goal.x = x;
+  return goal;
+}
+}  // namespace
+
+TEST(PlannerManager, TestDubinsGoalIgnoresHeading) {
+  // Dubins goals are [x, y, theta, v], so the third entry is not a height.
+  const PlanarDubins3D last(2.0, -1.0, 0.7, 0.5);
+  const Trajectory<PlanarDubins3D> traj = EndingAt(last);
+  EXPECT_TRUE(PlannerManager<PlanarDubins3D>::ReachesGoal(
+    traj, Goal({2.0, -1.0, 0.7, 0.5}), kTolerance));
+  EXPECT_TRUE(PlannerManager<PlanarDubins3D>::ReachesGoal(
+    traj, Goal({2.05, -1.0, -2.0, 0.0}), kTolerance));
+  EXPECT_FALSE(PlannerManager<PlanarDubins3D>::ReachesGoal(
+    traj, Goal({2.5, -1.0, 0.7, 0.5}), kTolerance));
+}
+
+TEST(PlannerManager, TestPositionVelocityGoal) {
+  VectorXd x(6);
+  x << 1.0, 2.0, 3.0, 0.0, 0.0, 0.0;
+  const Trajectory<PositionVelocity> traj = EndingAt(PositionVelocity(x));
+  EXPECT_TRUE(PlannerManager<PositionVelocity>::ReachesGoal(
+    traj, Goal({1.0, 2.0, 3.05}), kTolerance));
+  EXPECT_FALSE(PlannerManager<PositionVelocity>::ReachesGoal(
+    traj, Goal({1.0, 2.0, 2.0}), kTolerance));
+  EXPECT_FALSE(PlannerManager<PositionVelocity>::ReachesGoal(
+    Trajectory<PositionVelocity>(), Goal({1.0, 2.0, 3.0}), kTolerance));
+}
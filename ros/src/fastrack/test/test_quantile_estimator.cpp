@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for QuantileEstimator.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/quantile_estimator.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace {
+
+// Window size and number of samples to use for tests.
+static constexpr size_t kWindowSize = 100;
+static constexpr size_t kNumSamples = 250;
+
+}  // namespace
+
+TEST(QuantileEstimator, TestEmpty) {
+  fastrack::QuantileEstimator estimator(kWindowSize);
+  EXPECT_EQ(estimator.Size(), 0);
+  EXPECT_TRUE(std::isnan(estimator.Quantile(0.5)));
+}
+
+TEST(QuantileEstimator, TestQuantiles) {
+  // Insert 1, 2, ..., kWindowSize.
+  fastrack::QuantileEstimator estimator(kWindowSize);
+  for (size_t ii = 1; ii <= kWindowSize; ii++)
+    estimator.Add(static_cast<double>(ii));
+
+  EXPECT_EQ(estimator.Size(), kWindowSize);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(0.0), 1.0);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(0.5), 0.5 * kWindowSize);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(0.99), 0.99 * kWindowSize);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(1.0), kWindowSize);
+}
+
+TEST(QuantileEstimator, TestSlidingWindow) {
+  // Insert 1, 2, ..., kNumSamples. Only the most recent kWindowSize samples
+  // should be kept.
+  fastrack::QuantileEstimator estimator(kWindowSize);
+  for (size_t ii = 1; ii <= kNumSamples; ii++)
+    estimator.Add(static_cast<double>(ii));
+
+  EXPECT_EQ(estimator.Size(), kWindowSize);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(0.0), kNumSamples - kWindowSize + 1);
+  EXPECT_DOUBLE_EQ(estimator.Quantile(1.0), kNumSamples);
+
+  estimator.Clear();
+  EXPECT_EQ(estimator.Size(), 0);
+}
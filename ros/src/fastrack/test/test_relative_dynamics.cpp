@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for relative dynamics.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/control/quadrotor_control.h>
+#include <fastrack/control/quadrotor_control_bound_box.h>
+#include <fastrack/control/quadrotor_control_bound_cylinder.h>
+#include <fastrack/control/scalar_bound_interval.h>
+#include <fastrack/control/vector_bound_box.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d_rel_kinematics.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d_rel_planar_dubins_3d.h>
+#include <fastrack/state/planar_dubins_3d.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace fastrack::control;
+using namespace fastrack::dynamics;
+using namespace fastrack::state;
+
+namespace {
+// Number of random queries.
+static constexpr size_t kNumQueries = 1000;
+
+// Tolerance for comparing controls.
+static constexpr double kEpsilon = 1e-10;
+
+void ExpectNear(const QuadrotorControl& u1, const QuadrotorControl& u2) {
+  EXPECT_NEAR(u1.pitch, u2.pitch, kEpsilon);
+  EXPECT_NEAR(u1.roll, u2.roll, kEpsilon);
+  EXPECT_NEAR(u1.yaw_rate, u2.yaw_rate, kEpsilon);
+  EXPECT_NEAR(u1.thrust, u2.thrust, kEpsilon);
+}
+
+}  // namespace
+
+TEST(QuadrotorDecoupled6DRelPlanarDubins3D, TestRelativeOptimalControl) {
+  const QuadrotorDecoupled6DRelPlanarDubins3D dynamics;
+  const QuadrotorControlBoundCylinder tracker_u_bound(
+      0.1, ScalarBoundInterval(-1.0, 1.0), ScalarBoundInterval(7.81, 11.81));
+  const ScalarBoundInterval planner_u_bound(-1.0, 1.0);
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+  std::uniform_real_distribution<double> unif_theta(-M_PI, M_PI);
+
+  // The precomputable part followed by the state-dependent part should match
+  // the optimal control computed all at once.
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    const PositionVelocity tracker_x(Vector3d(unif(rng), unif(rng), unif(rng)),
+                                     Vector3d(unif(rng), unif(rng), unif(rng)));
+    const PlanarDubins3D planner_x(unif(rng), unif(rng), unif_theta(rng));
+    const PositionVelocityRelPlanarDubins3D gradient(unif(rng), unif(rng),
+                                                     unif(rng), unif(rng));
+
+    const QuadrotorControl relative_u =
+        dynamics.RelativeOptimalControl(gradient, tracker_u_bound);
+    ExpectNear(dynamics.CompleteOptimalControl(tracker_x, planner_x,
+                                               relative_u),
+               dynamics.OptimalControl(tracker_x, planner_x, gradient,
+                                       tracker_u_bound, planner_u_bound));
+  }
+}
+
+TEST(QuadrotorDecoupled6DRelKinematics, TestRelativeOptimalControl) {
+  const QuadrotorDecoupled6DRelKinematics<QuadrotorControlBoundBox> dynamics;
+  const QuadrotorControlBoundBox tracker_u_bound(
+      QuadrotorControl(-0.1, -0.1, 0.0, 7.81),
+      QuadrotorControl(0.1, 0.1, 0.0, 11.81));
+  const VectorBoundBox planner_u_bound(Vector3d::Constant(-1.0),
+                                       Vector3d::Constant(1.0));
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    const PositionVelocity tracker_x(Vector3d(unif(rng), unif(rng), unif(rng)),
+                                     Vector3d(unif(rng), unif(rng), unif(rng)));
+    const PositionVelocity planner_x(Vector3d(unif(rng), unif(rng), unif(rng)),
+                                     Vector3d(unif(rng), unif(rng), unif(rng)));
+    const PositionVelocityRelPositionVelocity gradient(
+        Vector3d(unif(rng), unif(rng), unif(rng)),
+        Vector3d(unif(rng), unif(rng), unif(rng)));
+
+    const QuadrotorControl relative_u =
+        dynamics.RelativeOptimalControl(gradient, tracker_u_bound);
+    ExpectNear(dynamics.CompleteOptimalControl(tracker_x, planner_x,
+                                               relative_u),
+               dynamics.OptimalControl(tracker_x, planner_x, gradient,
+                                       tracker_u_bound, planner_u_bound));
+  }
+}
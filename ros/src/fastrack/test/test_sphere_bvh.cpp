@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for SphereBvh ray casting and ThreadPool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/sphere_overlap_kernels.h>
+#include <fastrack/utils/sphere_bvh.h>
+#include <fastrack/utils/thread_pool.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <random>
+#include <vector>
+
+using fastrack::SphereBvh;
+using fastrack::ThreadPool;
+using fastrack::bound::SphereArray;
+
+namespace {
+// Environment extent, obstacles, and rays.
+static constexpr double kEnvironmentSize = 10.0;
+static constexpr size_t kNumObstacles = 500;
+static constexpr double kMinRadius = 0.05;
+static constexpr double kMaxRadius = 0.5;
+static constexpr size_t kNumRays = 2000;
+static constexpr double kRange = 8.0;
+
+SphereArray RandomSpheres(size_t num_spheres, unsigned int seed) {
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif_position(0.0, kEnvironmentSize);
+  std::uniform_real_distribution<double> unif_radius(kMinRadius, kMaxRadius);
+
+  SphereArray spheres;
+  for (size_t ii = 0; ii < num_spheres; ii++) {
+    const Vector3d p(unif_position(rng), unif_position(rng),
+                     unif_position(rng));
+    spheres.Add(p, unif_radius(rng));
+  }
+
+  return spheres;
+}
+
+// Brute force ray cast over every sphere.
+double BruteForceRaycast(const SphereArray& spheres, const Vector3d& origin,
+                         const Vector3d& direction, double max_distance) {
+  double best = max_distance;
+  for (size_t ii = 0; ii < spheres.Size(); ii++) {
+    const Vector3d oc = origin - spheres.Center(ii);
+    const double b = oc.dot(direction);
+    const double c = oc.squaredNorm() - spheres.r[ii] * spheres.r[ii];
+    if (c <= 0.0) return 0.0;
+
+    const double discriminant = b * b - c;
+    if (discriminant < 0.0) continue;
+
+    const double t = -b - std::sqrt(discriminant);
+    if (t >= 0.0 && t < best) best = t;
+  }
+
+  return best;
+}
+
+}  // namespace
+
+TEST(SphereBvh, TestMatchesBruteForce) {
+  const SphereArray spheres = RandomSpheres(kNumObstacles, 0);
+  const SphereBvh bvh(spheres);
+  EXPECT_EQ(bvh.NumSpheres(), kNumObstacles);
+
+  std::default_random_engine rng(1);
+  std::uniform_real_distribution<double> unif_position(0.0, kEnvironmentSize);
+  std::normal_distribution<double> gaussian;
+
+  size_t num_hits = 0;
+  for (size_t ii = 0; ii < kNumRays; ii++) {
+    const Vector3d origin(unif_position(rng), unif_position(rng),
+                          unif_position(rng));
+    const Vector3d direction =
+        Vector3d(gaussian(rng), gaussian(rng), gaussian(rng)).normalized();
+
+    const double expected =
+        BruteForceRaycast(spheres, origin, direction, kRange);
+    EXPECT_NEAR(bvh.Raycast(origin, direction, kRange), expected, 1e-9);
+    num_hits += expected < kRange;
+  }
+
+  // Make sure the test actually exercises hits and misses.
+  EXPECT_GT(num_hits, 0u);
+  EXPECT_LT(num_hits, kNumRays);
+}
+
+TEST(SphereBvh, TestEmpty) {
+  const SphereBvh bvh{SphereArray()};
+  EXPECT_EQ(bvh.Raycast(Vector3d::Zero(), Vector3d::UnitX(), kRange), kRange);
+}
+
+TEST(ThreadPool, TestCoversEveryIndexOnce) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.NumThreads(), 4u);
+
+  // Run a few loops to make sure the pool can be reused.
+  for (size_t n : {0, 1, 7, 1000, 4097}) {
+    std::vector<std::atomic<int>> counts(n);
+    for (auto& count : counts) count = 0;
+
+    pool.ParallelFor(n, 64, [&counts](size_t begin, size_t end) {
+      for (size_t ii = begin; ii < end; ii++) counts[ii]++;
+    });
+
+    for (size_t ii = 0; ii < n; ii++) EXPECT_EQ(counts[ii].load(), 1);
+  }
+}
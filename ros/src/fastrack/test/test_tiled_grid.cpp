@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for TiledGrid.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/utils/tiled_grid.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <thread>
+
+namespace {
+
+// A 10 x 7 grid with two channels, cut into 4 x 4 tiles, with a coarse level
+// downsampled by 3.
+static const std::vector<size_t> kNumCells = {10, 7};
+static const std::vector<size_t> kTileCells = {4, 4};
+static constexpr size_t kCoarseFactor = 3;
+static const std::string kFileName = "/tmp/fastrack_test_tiled_grid.bin";
+
+// Write the test grid, where the channels are the row-major index and its
+// negative.
+bool WriteTestGrid() {
+  std::vector<double> index, negative;
+  for (size_t ii = 0; ii < kNumCells[0] * kNumCells[1]; ii++) {
+    index.push_back(ii);
+    negative.push_back(-static_cast<double>(ii));
+  }
+
+  return fastrack::TiledGrid::Write(kFileName, kNumCells, {&index, &negative},
+                                    kTileCells, kCoarseFactor);
+}
+
+// Read the test grid file, and write the given bytes in its place.
+std::string ReadTestGrid() {
+  std::ifstream file(kFileName, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+void OverwriteTestGrid(const std::string& bytes) {
+  std::ofstream file(kFileName, std::ios::binary | std::ios::trunc);
+  file.write(bytes.data(), bytes.size());
+}
+
+// Look up until the tile is resident, or give up after a second.
+bool LookupResident(const fastrack::TiledGrid& grid, const size_t* cell,
+                    double* channels) {
+  double upper[2];
+  for (size_t ii = 0; ii < 1000; ii++) {
+    if (grid.Lookup(cell, channels, upper)) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return false;
+}
+
+}  // namespace
+
+TEST(TiledGrid, TestCoarseFallbackThenResident) {
+  ASSERT_TRUE(WriteTestGrid());
+
+  fastrack::TiledGrid grid;
+  ASSERT_TRUE(grid.Open(kFileName, 2));
+  EXPECT_EQ(grid.NumCells(), kNumCells);
+  EXPECT_EQ(grid.NumChannels(), 2);
+
+  // First lookup falls back to bounds over coarse cell (1, 1), i.e. fine
+  // cells (3, 3) through (5, 5).
+  const size_t cell[2] = {5, 5};
+  double channels[2], upper[2];
+  EXPECT_FALSE(grid.Lookup(cell, channels, upper));
+  EXPECT_EQ(channels[0], 3 * 7 + 3);
+  EXPECT_EQ(upper[0], 5 * 7 + 5);
+  EXPECT_EQ(channels[1], -(5 * 7 + 5));
+  EXPECT_EQ(upper[1], -(3 * 7 + 3));
+
+  // Coarse cells at the boundary only cover the grid. Coarse cell (3, 2) is
+  // just fine cell (9, 6).
+  const size_t corner[2] = {9, 6};
+  EXPECT_FALSE(grid.Lookup(corner, channels, upper));
+  EXPECT_EQ(channels[0], 9 * 7 + 6);
+  EXPECT_EQ(upper[0], 9 * 7 + 6);
+
+  // Eventually the tile is resident and lookups are exact.
+  ASSERT_TRUE(LookupResident(grid, cell, channels));
+  EXPECT_EQ(channels[0], 5 * 7 + 5);
+  EXPECT_EQ(channels[1], -(5 * 7 + 5));
+
+  // Partial tiles at the boundary work too.
+  ASSERT_TRUE(LookupResident(grid, corner, channels));
+  EXPECT_EQ(channels[0], 9 * 7 + 6);
+  EXPECT_GT(grid.NumHits(), 0);
+  EXPECT_GT(grid.NumMisses(), 0);
+
+  std::remove(kFileName.c_str());
+}
+
+TEST(TiledGrid, TestEviction) {
+  ASSERT_TRUE(WriteTestGrid());
+
+  fastrack::TiledGrid grid;
+  ASSERT_TRUE(grid.Open(kFileName, 1));
+
+  const size_t first[2] = {0, 0};
+  const size_t second[2] = {8, 0};
+  double channels[2];
+  ASSERT_TRUE(LookupResident(grid, first, channels));
+  ASSERT_TRUE(LookupResident(grid, second, channels));
+
+  // Only one tile fits, so the first was evicted.
+  double upper[2];
+  EXPECT_FALSE(grid.Lookup(first, channels, upper));
+
+  // Prefetching brings it back.
+  grid.Prefetch(first);
+  EXPECT_TRUE(LookupResident(grid, first, channels));
+  EXPECT_EQ(channels[0], 0.0);
+
+  std::remove(kFileName.c_str());
+}
+
+TEST(TiledGrid, TestInvalid) {
+  std::vector<double> too_small(3);
+  EXPECT_FALSE(fastrack::TiledGrid::Write(kFileName, kNumCells, {&too_small},
+                                          kTileCells, kCoarseFactor));
+
+  fastrack::TiledGrid grid;
+  EXPECT_FALSE(grid.Open("/tmp/fastrack_test_tiled_grid_missing.bin", 1));
+}
+
+TEST(TiledGrid, TestMalformed) {
+  ASSERT_TRUE(WriteTestGrid());
+  const std::string bytes = ReadTestGrid();
+
+  // Truncated last tile.
+  OverwriteTestGrid(bytes.substr(0, bytes.size() - sizeof(double)));
+  {
+    fastrack::TiledGrid grid;
+    EXPECT_FALSE(grid.Open(kFileName, 1));
+  }
+
+  // Truncated header.
+  OverwriteTestGrid(bytes.substr(0, 10));
+  {
+    fastrack::TiledGrid grid;
+    EXPECT_FALSE(grid.Open(kFileName, 1));
+  }
+
+  // Corrupt magic.
+  std::string corrupt = bytes;
+  corrupt[0] = 'X';
+  OverwriteTestGrid(corrupt);
+  {
+    fastrack::TiledGrid grid;
+    EXPECT_FALSE(grid.Open(kFileName, 1));
+  }
+
+  // Corrupt grid size, which would need far more tiles than the file holds.
+  // The first size follows the magic, version, dimension and channels.
+  corrupt = bytes;
+  const uint64_t huge = uint64_t(1) << 40;
+  corrupt.replace(16, sizeof(huge), reinterpret_cast<const char*>(&huge),
+                  sizeof(huge));
+  OverwriteTestGrid(corrupt);
+  {
+    fastrack::TiledGrid grid;
+    EXPECT_FALSE(grid.Open(kFileName, 1));
+  }
+
+  // Intact file still opens.
+  OverwriteTestGrid(bytes);
+  {
+    fastrack::TiledGrid grid;
+    EXPECT_TRUE(grid.Open(kFileName, 1));
+  }
+
+  std::remove(kFileName.c_str());
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for Trajectory ROS conversions.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+
+#include <gtest/gtest.h>
+
+using namespace fastrack;
+using state::PositionVelocity;
+using trajectory::Trajectory;
+
+namespace {
+// Number of states in the test trajectory.
+static constexpr size_t kNumStates = 20;
+
+// Straight-line trajectory at constant velocity.
+Trajectory<PositionVelocity> StraightLine() {
+  std::vector<PositionVelocity> states;
+  std::vector<double> times;
+  for (size_t ii = 0; ii < kNumStates; ii++) {
+    VectorXd x(6);
+    x << 0.1 * ii, -0.2 * ii, 1.0, 1.0, -2.0, 0.0;
+    states.emplace_back(x);
+    times.push_back(0.1 * ii);
+  }
+
+  return Trajectory<PositionVelocity>(states, times);
+}
+
+// Convert a message the same way the tracker does, returning false if the
+// tracker would reject it.
+bool Accept(const fastrack_msgs::Trajectory& msg,
+            Trajectory<PositionVelocity>* traj) {
+  if (Trajectory<PositionVelocity>::IsEmpty(msg))
+    return false;
+
+  const fastrack_msgs::Trajectory::ConstPtr ptr(
+    new fastrack_msgs::Trajectory(msg));
+  *traj = Trajectory<PositionVelocity>(ptr);
+  return true;
+}
+
+// Check that two trajectories hold the same states and times.
+void ExpectSame(const Trajectory<PositionVelocity>& traj1,
+                const Trajectory<PositionVelocity>& traj2) {
+  ASSERT_EQ(traj1.Size(), traj2.Size());
+  for (size_t ii = 0; ii < traj1.Size(); ii++) {
+    EXPECT_DOUBLE_EQ(traj1.Times()[ii], traj2.Times()[ii]);
+    EXPECT_TRUE(traj1.States()[ii].ToVector().isApprox(
+                  traj2.States()[ii].ToVector()));
+  }
+}
+}  // namespace
+
+TEST(Trajectory, TestPackedRoundTrip) {
+  const Trajectory<PositionVelocity> traj = StraightLine();
+
+  fastrack_msgs::Trajectory msg;
+  traj.ToPackedRos(&msg);
+  EXPECT_TRUE(msg.states.empty());
+
+  Trajectory<PositionVelocity> received;
+  ASSERT_TRUE(Accept(msg, &received));
+  ExpectSame(traj, received);
+}
+
+TEST(Trajectory, TestUnpackedRoundTrip) {
+  const Trajectory<PositionVelocity> traj = StraightLine();
+
+  Trajectory<PositionVelocity> received;
+  ASSERT_TRUE(Accept(traj.ToRos(), &received));
+  ExpectSame(traj, received);
+}
+
+TEST(Trajectory, TestRejectEmpty) {
+  Trajectory<PositionVelocity> received;
+  EXPECT_FALSE(Accept(fastrack_msgs::Trajectory(), &received));
+
+  fastrack_msgs::Trajectory msg;
+  Trajectory<PositionVelocity>().ToPackedRos(&msg);
+  EXPECT_FALSE(Accept(msg, &received));
+}
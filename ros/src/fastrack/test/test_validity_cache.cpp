@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for ValidityCache.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/box.h>
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/bound/sphere.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/utils/validity_cache.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+// Cell size and environment version to use for tests.
+static constexpr double kResolution = 0.1;
+static constexpr unsigned int kVersion = 7;
+
+// Number of random trials for the inflation tests.
+static constexpr size_t kNumTrials = 10000;
+
+// Check that a bound inflated by half a cell, placed at the cell center,
+// clears every placement of the original bound within the cell.
+void CheckInflationCoversCell(const fastrack::bound::TrackingBound& bound,
+                              fastrack::bound::TrackingBound* inflated) {
+  inflated->Inflate(0.5 * kResolution);
+
+  const fastrack::ValidityCache cache(kResolution);
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+  for (size_t ii = 0; ii < kNumTrials; ii++) {
+    const Vector3d p(unif(rng), unif(rng), unif(rng));
+    const Vector3d center = cache.CellCenter(p);
+    ASSERT_LE((p - center).lpNorm<Eigen::Infinity>(), 0.5 * kResolution);
+
+    const Vector3d obstacle(unif(rng), unif(rng), unif(rng));
+    const double radius = 0.1 * (unif(rng) + 1.0);
+    if (!inflated->OverlapsSphere(center, obstacle, radius)) {
+      EXPECT_FALSE(bound.OverlapsSphere(p, obstacle, radius));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ValidityCache, TestMiss) {
+  fastrack::ValidityCache cache(kResolution);
+
+  bool valid;
+  EXPECT_FALSE(cache.Lookup(Vector3d(1.0, 2.0, 3.0), kVersion, &valid));
+  EXPECT_EQ(cache.NumQueries(), 1);
+  EXPECT_EQ(cache.NumHits(), 0);
+}
+
+TEST(ValidityCache, TestResultCoversCell) {
+  fastrack::ValidityCache cache(kResolution);
+  cache.Insert(Vector3d(1.01, 2.01, 3.01), kVersion, true);
+
+  // Same cell is a hit.
+  bool valid = false;
+  EXPECT_TRUE(cache.Lookup(Vector3d(1.09, 2.05, 3.02), kVersion, &valid));
+  EXPECT_TRUE(valid);
+
+  // Neighboring cell and other versions are misses.
+  EXPECT_FALSE(cache.Lookup(Vector3d(1.11, 2.05, 3.02), kVersion, &valid));
+  EXPECT_FALSE(cache.Lookup(Vector3d(1.09, 2.05, 3.02), kVersion + 1, &valid));
+  EXPECT_DOUBLE_EQ(cache.HitRate(), 1.0 / 3.0);
+}
+
+TEST(ValidityCache, TestMixedCell) {
+  fastrack::ValidityCache cache(kResolution);
+  const Vector3d p(1.01, 2.01, 3.01);
+  cache.Insert(p, kVersion, false);
+
+  bool valid = true;
+  EXPECT_TRUE(cache.Lookup(p, kVersion, &valid));
+  EXPECT_FALSE(valid);
+
+  // Clearing forgets everything.
+  cache.Clear();
+  EXPECT_FALSE(cache.Lookup(p, kVersion, &valid));
+}
+
+TEST(ValidityCache, TestKeysCompareExactly) {
+  // With a single slot every cell collides.
+  fastrack::ValidityCache cache(kResolution, 1);
+  cache.Insert(Vector3d(0.05, 0.05, 0.05), kVersion, true);
+
+  bool valid = false;
+  EXPECT_FALSE(cache.Lookup(Vector3d(0.15, 0.05, 0.05), kVersion, &valid));
+  EXPECT_FALSE(cache.Lookup(Vector3d(0.05, -0.05, 0.05), kVersion, &valid));
+  EXPECT_TRUE(cache.Lookup(Vector3d(0.01, 0.09, 0.02), kVersion, &valid));
+  EXPECT_TRUE(valid);
+
+  // Positions too far out to index are never cached.
+  const Vector3d far(1e12, 0.0, 0.0);
+  cache.Insert(far, kVersion, true);
+  EXPECT_FALSE(cache.Lookup(far, kVersion, &valid));
+}
+
+TEST(ValidityCache, TestCellCenter) {
+  const fastrack::ValidityCache cache(kResolution);
+  EXPECT_TRUE(cache.CellCenter(Vector3d(1.01, -0.01, 0.0))
+                  .isApprox(Vector3d(1.05, -0.05, 0.05)));
+}
+
+TEST(ValidityCache, TestBoxInflationCoversCell) {
+  fastrack::bound::Box bound, inflated;
+  ASSERT_TRUE(bound.Initialize({0.1, 0.2, 0.05}));
+  inflated = bound;
+  CheckInflationCoversCell(bound, &inflated);
+}
+
+TEST(ValidityCache, TestCylinderInflationCoversCell) {
+  fastrack::bound::Cylinder bound, inflated;
+  ASSERT_TRUE(bound.Initialize({0.1, 0.05}));
+  inflated = bound;
+  CheckInflationCoversCell(bound, &inflated);
+}
+
+TEST(ValidityCache, TestSphereInflationCoversCell) {
+  fastrack::bound::Sphere bound, inflated;
+  ASSERT_TRUE(bound.Initialize({0.1}));
+  inflated = bound;
+  CheckInflationCoversCell(bound, &inflated);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Node running headless closed-loop simulations of a tracker based on the
+// MatlabValueFunction class, following random planar Dubins references with
+// yaw rate resampled periodically. Exits with failure if the fraction of
+// rollouts violating the tracking error bound exceeds sim/max_violation_rate.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/bound/cylinder.h>
+#include <fastrack/control/quadrotor_control.h>
+#include <fastrack/dynamics/planar_dubins_dynamics_3d.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d.h>
+#include <fastrack/dynamics/quadrotor_decoupled_6d_rel_planar_dubins_3d.h>
+#include <fastrack/simulation/closed_loop_simulator.h>
+#include <fastrack/state/planar_dubins_3d.h>
+#include <fastrack/state/position_velocity.h>
+#include <fastrack/trajectory/trajectory.h>
+#include <fastrack/utils/types.h>
+#include <fastrack/value/matlab_value_function.h>
+
+#include <ros/ros.h>
+#include <random>
+
+namespace fsim = fastrack::simulation;
+namespace fs = fastrack::state;
+namespace fb = fastrack::bound;
+namespace fc = fastrack::control;
+namespace fd = fastrack::dynamics;
+namespace ftr = fastrack::trajectory;
+namespace fv = fastrack::value;
+
+using CustomValueFunction = fv::MatlabValueFunction<
+    fs::PositionVelocity, fc::QuadrotorControl,
+    fd::QuadrotorDecoupled6D<fc::QuadrotorControlBoundCylinder>,
+    fs::PlanarDubins3D, double, fd::PlanarDubinsDynamics3D,
+    fs::PositionVelocityRelPlanarDubins3D,
+    fd::QuadrotorDecoupled6DRelPlanarDubins3D, fb::Cylinder>;
+
+namespace {
+// Time step between reference states.
+static constexpr double kReferenceTimeStep = 0.02;
+
+// Random Dubins references at the planner's speed, with yaw rate resampled
+// within the planner's bounds every segment_duration seconds. Heading is not
+// wrapped, so that interpolation between reference states is continuous.
+std::vector<ftr::Trajectory<fs::PlanarDubins3D>> RandomReferences(
+    const CustomValueFunction& value, size_t num_references, double duration,
+    double segment_duration, unsigned int seed) {
+  const auto& dynamics = value.PlannerDynamics();
+  const auto& bound = dynamics.GetControlBound();
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+  std::vector<ftr::Trajectory<fs::PlanarDubins3D>> references;
+  for (size_t ii = 0; ii < num_references; ii++) {
+    std::vector<fs::PlanarDubins3D> states;
+    std::vector<double> times;
+
+    fs::PlanarDubins3D x(0.0, 0.0, 2.0 * M_PI * unif(rng), dynamics.V());
+    double omega = 0.0;
+    double segment_start = 0.0;
+    for (double t = 0.0; t <= duration; t += kReferenceTimeStep) {
+      if (states.empty() || t - segment_start >= segment_duration) {
+        omega = bound.Min() + unif(rng) * (bound.Max() - bound.Min());
+        segment_start = t;
+      }
+
+      states.push_back(x);
+      times.push_back(t);
+
+      const fs::PlanarDubins3D x_dot = dynamics.Evaluate(x, omega);
+      x.X() += kReferenceTimeStep * x_dot.X();
+      x.Y() += kReferenceTimeStep * x_dot.Y();
+      x.Theta() += kReferenceTimeStep * x_dot.Theta();
+    }
+
+    references.emplace_back(states, times);
+  }
+
+  return references;
+}
+
+}  //\namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "SimulationDemo");
+  ros::NodeHandle n("~");
+  const std::string name = ros::this_node::getName();
+
+  CustomValueFunction value;
+  if (!value.Initialize(n)) {
+    ROS_ERROR("%s: Failed to initialize value function.", name.c_str());
+    return EXIT_FAILURE;
+  }
+
+  fsim::ClosedLoopSimulator<CustomValueFunction, fs::PlanarDubins3D> simulator(
+      value);
+  if (!simulator.Initialize(n)) {
+    ROS_ERROR("%s: Failed to initialize simulator.", name.c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Reference parameters.
+  int num_references = 64;
+  double duration = 10.0;
+  double segment_duration = 1.0;
+  double max_violation_rate = 0.0;
+  n.getParam("sim/num_references", num_references);
+  n.getParam("sim/duration", duration);
+  n.getParam("sim/segment_duration", segment_duration);
+  n.getParam("sim/max_violation_rate", max_violation_rate);
+
+  const auto references =
+      RandomReferences(value, std::max(num_references, 1), duration,
+                       segment_duration, simulator.Params().seed);
+  const fsim::ClosedLoopSimulationReport report =
+      simulator.Simulate(references);
+  report.Print(name);
+
+  return (report.ViolationRate() > max_violation_rate) ? EXIT_FAILURE
+                                                       : EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Node replaying a recorded session into a planar Dubins planner (Cylinder tracking bound).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <fastrack/planning/session_replayer.h>
+
+#include <fastrack_msgs/SensedSpheres.h>
+#include <fastrack_srvs/PlanarDubinsPlannerDynamics.h>
+#include <fastrack_srvs/TrackingBoundCylinder.h>
+
+#include <ros/ros.h>
+
+namespace fp = fastrack::planning;
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "SessionReplayerDemo");
+  ros::NodeHandle n("~");
+
+  fp::SessionReplayer<fastrack_msgs::SensedSpheres,
+                      fastrack_srvs::PlanarDubinsPlannerDynamics,
+                      fastrack_srvs::TrackingBoundCylinder> replayer;
+
+  if (!replayer.Initialize(n)) {
+    ROS_ERROR("%s: Failed to initialize session replayer.",
+              ros::this_node::getName().c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Service callbacks on a separate thread while replaying.
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  if (!replayer.Run()) {
+    ROS_ERROR("%s: Replay did not complete.",
+              ros::this_node::getName().c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -38,6 +38,8 @@
 //
 // Defines the StateConverter class, which listens for new crazyflie state
 // messages and immediately republishes them as fastrack state messages.
+// Optionally, it also republishes them with latency tracing on a second
+// topic, traced back to the time of the crazyflie state estimate.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -48,6 +50,7 @@
 #include <fastrack/utils/uncopyable.h>
 
 #include <fastrack_msgs/State.h>
+#include <fastrack_msgs/TracedState.h>
 #include <crazyflie_msgs/PositionVelocityStateStamped.h>
 
 #include <ros/ros.h>
@@ -74,9 +77,11 @@ private:
   // Publishers/subscribers and related topics.
   ros::Subscriber raw_state_sub_;
   ros::Publisher fastrack_state_pub_;
+  ros::Publisher traced_fastrack_state_pub_;
 
   std::string raw_state_topic_;
   std::string fastrack_state_topic_;
+  std::string traced_fastrack_state_topic_;
 
   // Naming and initialization.
   std::string name_;
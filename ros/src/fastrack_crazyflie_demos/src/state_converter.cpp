@@ -38,6 +38,8 @@
 //
 // Defines the StateConverter class, which listens for new crazyflie state
 // messages and immediately republishes them as fastrack state messages.
+// Optionally, it also republishes them with latency tracing on a second
+// topic, traced back to the time of the crazyflie state estimate.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -74,6 +76,9 @@ bool StateConverter::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("topic/fastrack_state", fastrack_state_topic_)) return false;
   if (!nl.getParam("topic/raw_state", raw_state_topic_)) return false;
 
+  // Traced topic is optional.
+  nl.getParam("topic/traced_fastrack_state", traced_fastrack_state_topic_);
+
   return true;
 }
 
@@ -89,6 +94,10 @@ bool StateConverter::RegisterCallbacks(const ros::NodeHandle& n) {
   fastrack_state_pub_ = nl.advertise<fastrack_msgs::State>(
     fastrack_state_topic_.c_str(), 1, false);
 
+  if (!traced_fastrack_state_topic_.empty())
+    traced_fastrack_state_pub_ = nl.advertise<fastrack_msgs::TracedState>(
+      traced_fastrack_state_topic_.c_str(), 1, false);
+
   return true;
 }
 
@@ -104,6 +113,15 @@ StateCallback(const crazyflie_msgs::PositionVelocityStateStamped::ConstPtr& msg)
   s.x.push_back(msg->state.z_dot);
 
   fastrack_state_pub_.publish(s);
+
+  // Trace back to the time of the raw state estimate.
+  if (!traced_fastrack_state_topic_.empty()) {
+    fastrack_msgs::TracedState traced;
+    traced.state = s;
+    traced.origin = msg->header.stamp;
+    traced.trace.push_back(ros::Time::now());
+    traced_fastrack_state_pub_.publish(traced);
+  }
 }
 
 } //\namespace crazyflie